@@ -0,0 +1,101 @@
+#!/bin/bash
+
+#  This file is part of GAM-NGS.
+#  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+#  Francesco Vezzi <vezzi@appliedgenomics.org>,
+#  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+#  Lars Arverstad <lars.arvestad@scilifelab.se>,
+#  Alberto Policriti <policriti@appliedgenomics.org>,
+#  Alberto Casagrande <casagrande@appliedgenomics.org>
+#
+#  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+#  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+#  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+#  been written using GAM's software as starting point. Thus, it shares part of
+#  GAM's source code.
+#
+#  Moreover, GAM-NGS uses BamTools library to access BAM files.
+#  BamTools's source code has been put in ./lib/bamtools-2.0.5/ folder,
+#  in which its license can be found.
+#
+#  GAM-NGS is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  GAM-NGS is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+
+# Compares linear and affine gap scores (gam-merge --affine-gaps) on synthetic
+# data sets built by gam-simulate. For each data set it reports the alignments
+# counted in the [alignment stats] section of the .stats file and the wall time
+# of gam-merge (one thread, best of REPS runs).
+#
+# Usage: ./affine_gaps_benchmark.sh [work dir]
+# Build the tools first, from the repository root:
+#   cmake . && make && make gam-simulate
+
+SCRIPT_PATH=`dirname $0`
+BIN_PATH=`cd ${SCRIPT_PATH}/../../bin && pwd -P`
+WORK_PATH=${1:-./affine_gaps_benchmark}
+GENOME_SIZE=2000000
+COVERAGE=30
+REPS=3
+
+# data sets: "<indel rate> <divergent flanks %> <slave substitution rate>"
+DATA_SETS="0.0005:50:0.06 0.005:50:0.0008 0.01:50:0.0008"
+
+for tool in gam-simulate gam-create gam-merge
+do
+	if [ ! -x ${BIN_PATH}/${tool} ]; then echo "[error] ${BIN_PATH}/${tool} not found" >&2; exit 1; fi
+done
+
+mkdir -p ${WORK_PATH} && cd ${WORK_PATH} || exit 1
+WORK_PATH=`pwd -P`
+
+stat_value()
+{
+	grep "^$1 = " out.stats | sed 's/.* = //'
+}
+
+printf "%-8s %-8s %-7s %6s %7s %8s %6s %9s\n" indel subst gaps pairs blocks retries tails "time(s)"
+
+for data_set in ${DATA_SETS}
+do
+	INDEL=`echo ${data_set} | cut -d: -f1`
+	FLANK=`echo ${data_set} | cut -d: -f2`
+	SUBST=`echo ${data_set} | cut -d: -f3`
+
+	rm -f *.bam *.bai *.fai *.fasta *.isize out.*
+	${BIN_PATH}/gam-simulate ${GENOME_SIZE} ${COVERAGE} ${INDEL} ${FLANK} ${SUBST} || exit 1
+
+	echo -e "${WORK_PATH}/master.bam\n250 1000" > master.bams.txt
+	echo -e "${WORK_PATH}/slave.bam\n250 1000" > slave.bams.txt
+
+	${BIN_PATH}/gam-create --master-bam master.bams.txt --slave-bam slave.bams.txt --min-block-size 10 --output out \
+		>gam-create.log.out 2>gam-create.log.err || { echo "[error] gam-create failed, see ${WORK_PATH}/gam-create.log.err" >&2; exit 1; }
+
+	for gaps in linear affine
+	do
+		GAPS_OPT=""; [ ${gaps} = affine ] && GAPS_OPT="--affine-gaps"
+		BEST=""
+
+		for rep in `seq ${REPS}`
+		do
+			START=`date +%s%N`
+			${BIN_PATH}/gam-merge --blocks-file out.blocks --master-bam master.bams.txt --master-fasta master.fasta \
+				--slave-bam slave.bams.txt --slave-fasta slave.fasta --min-block-size 10 --threads 1 --output out ${GAPS_OPT} \
+				>gam-merge.log.out 2>gam-merge.log.err || { echo "[error] gam-merge failed, see ${WORK_PATH}/gam-merge.log.err" >&2; exit 1; }
+			ELAPSED=$(( (`date +%s%N` - START) / 1000000 ))
+			if [ -z "${BEST}" ] || [ ${ELAPSED} -lt ${BEST} ]; then BEST=${ELAPSED}; fi
+		done
+
+		printf "%-8s %-8s %-7s %6s %7s %8s %6s %5d.%03d\n" ${INDEL} ${SUBST} ${gaps} \
+			"`stat_value 'Contig pairs aligned'`" "`stat_value 'Block alignments'`" \
+			"`stat_value 'Strand retries'`" "`stat_value 'Tail alignments'`" $((BEST / 1000)) $((BEST % 1000))
+	done
+done
@@ -0,0 +1,322 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Builds a synthetic data set for gam-create/gam-merge benchmarks.
+ *
+ * A random genome (with some repeats) is split into two assemblies, master and
+ * slave. Each contig copies its genome interval with small indels and
+ * substitutions, and may get divergent random flanks at its ends, which force
+ * tail alignments. Every third slave contig is reverse complemented.
+ * Paired reads are sampled from the genome and placed exactly on both
+ * assemblies, so no read aligner is needed.
+ *
+ * Output (in the current directory): master.fasta, master.bam (+.bai),
+ * slave.fasta, slave.bam (+.bai).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "api/BamReader.h"
+#include "api/BamWriter.h"
+
+using namespace BamTools;
+
+//! contig of a simulated assembly
+struct SimContig
+{
+	std::string name;
+	int genomeBegin, genomeEnd;  //!< genome interval [begin,end) copied in the contig
+	bool reversed;               //!< whether the contig is reverse complemented
+	std::vector<int> genomeToCtg;//!< forward contig position of each genome position of the interval (and its end)
+	std::string seq;
+};
+
+struct SimParams
+{
+	double indelRate;    //!< per-base probability of an indel in the contigs
+	int flankPercent;    //!< percentage of contig ends with a divergent random flank
+	double masterSubst;  //!< per-base substitution rate of master contigs
+	double slaveSubst;   //!< per-base substitution rate of slave contigs
+};
+
+static unsigned long long g_seed = 88172645463325252ULL;
+
+//! xorshift generator, so that data sets are the same on every platform
+static unsigned rnd()
+{
+	g_seed ^= g_seed << 13; g_seed ^= g_seed >> 7; g_seed ^= g_seed << 17;
+	return (unsigned)(g_seed >> 11);
+}
+
+static std::string randomSeq( int len )
+{
+	std::string s( len, 'A' );
+	for( int i=0; i < len; i++ ) s[i] = "ACGT"[rnd() % 4];
+	return s;
+}
+
+static std::string reverseComplement( const std::string &s )
+{
+	std::string r( s.rbegin(), s.rend() );
+
+	for( size_t i=0; i < r.size(); i++ )
+	{
+		char c = r[i];
+		r[i] = c == 'A' ? 'T' : c == 'T' ? 'A' : c == 'C' ? 'G' : c == 'G' ? 'C' : 'N';
+	}
+
+	return r;
+}
+
+//! splits the genome in contigs of [minLen,maxLen) bases
+static std::vector<SimContig> splitGenome( const std::string &genome, int minLen, int maxLen, int revEvery,
+                                           const char *prefix, double subst, const SimParams &par )
+{
+	std::vector<SimContig> ctgs;
+	int pos = 0;
+
+	for( int k=0; pos < (int)genome.size(); k++ )
+	{
+		int end = std::min( (int)genome.size(), pos + minLen + (int)(rnd() % (maxLen-minLen)) );
+		if( (int)genome.size() - end < minLen/2 ) end = genome.size();
+
+		char name[64];
+		sprintf( name, "%s_%d", prefix, k );
+
+		SimContig ctg;
+		ctg.name = name;
+		ctg.genomeBegin = pos;
+		ctg.genomeEnd = end;
+		ctg.reversed = (revEvery > 0 && k % revEvery == 1);
+		ctg.genomeToCtg.resize( end-pos+1 );
+
+		std::string &s = ctg.seq;
+		if( (int)(rnd() % 100) < par.flankPercent ) s += randomSeq( 300 + rnd() % 500 );
+
+		for( int i=pos; i < end; i++ )
+		{
+			ctg.genomeToCtg[i-pos] = s.size();
+
+			unsigned r = rnd() % 1000000;
+			if( r < par.indelRate*1000000/2 ) continue;                            // deletion
+			if( r < par.indelRate*1000000 ) s += randomSeq( 1 + rnd() % 3 );       // insertion
+
+			char c = genome[i];
+			if( (rnd() % 100000) < subst*100000 ) c = "ACGT"[rnd() % 4];
+			s += c;
+		}
+
+		ctg.genomeToCtg[end-pos] = s.size();
+		if( (int)(rnd() % 100) < par.flankPercent ) s += randomSeq( 300 + rnd() % 500 );
+		if( ctg.reversed ) s = reverseComplement(s);
+
+		ctgs.push_back(ctg);
+		pos = end;
+	}
+
+	return ctgs;
+}
+
+//! finds where genome interval [begin,end) lies in the assembly; false if it spans two contigs
+static bool locate( const std::vector<SimContig> &ctgs, int begin, int end, int &ctgId, int &ctgPos, bool &rev )
+{
+	for( size_t i=0; i < ctgs.size(); i++ )
+	{
+		const SimContig &c = ctgs[i];
+		if( begin < c.genomeBegin || end > c.genomeEnd ) continue;
+
+		int b = c.genomeToCtg[begin - c.genomeBegin];
+		int e = c.genomeToCtg[end - c.genomeBegin];
+
+		ctgId = i;
+		rev = c.reversed;
+		ctgPos = c.reversed ? (int)c.seq.size() - e : b;
+
+		return true;
+	}
+
+	return false;
+}
+
+static bool alignmentLess( const BamAlignment &x, const BamAlignment &y )
+{
+	if( x.RefID != y.RefID ) return x.RefID < y.RefID;
+	if( x.Position != y.Position ) return x.Position < y.Position;
+	return x.Name < y.Name;
+}
+
+//! writes the contigs and a coordinate-sorted, indexed BAM file of the paired reads
+static void writeAssembly( const std::string &prefix, const std::vector<SimContig> &ctgs, const std::string &genome,
+                           int pairs, int readLen, int insSize, unsigned long long seed )
+{
+	g_seed = seed;
+
+	std::ofstream fasta( (prefix + ".fasta").c_str() );
+	RefVector refs;
+
+	for( size_t i=0; i < ctgs.size(); i++ )
+	{
+		fasta << ">" << ctgs[i].name << "\n";
+		for( size_t j=0; j < ctgs[i].seq.size(); j += 60 ) fasta << ctgs[i].seq.substr(j,60) << "\n";
+		refs.push_back( RefData( ctgs[i].name, ctgs[i].seq.size() ) );
+	}
+
+	fasta.close();
+
+	std::vector<BamAlignment> aligns;
+
+	for( int k=0; k < pairs; k++ )
+	{
+		int isize = insSize - insSize/10 + rnd() % (insSize/5);
+		int begin = rnd() % (genome.size() - isize);
+		int end = begin + isize;
+
+		int ctg[2], pos[2];
+		bool rev[2], found[2];
+		found[0] = locate( ctgs, begin, begin+readLen, ctg[0], pos[0], rev[0] );
+		found[1] = locate( ctgs, end-readLen, end, ctg[1], pos[1], rev[1] );
+
+		char name[64];
+		sprintf( name, "read_%08d_xxxxxxxx:%d", k, k*7 );
+
+		// first mate is forward on the genome, second mate is reverse
+		for( int m=0; m < 2; m++ )
+		{
+			if( !found[m] ) continue;
+
+			int o = 1-m;
+			BamAlignment al;
+			al.Name = name;
+			al.Length = readLen;
+			al.QueryBases = std::string( readLen, 'A' );
+			al.Qualities = std::string( readLen, 'I' );
+			al.SetIsPaired(true);
+			al.SetIsFirstMate( m == 0 );
+			al.SetIsSecondMate( m == 1 );
+
+			al.RefID = ctg[m];
+			al.Position = pos[m];
+			al.SetIsMapped(true);
+			al.SetIsReverseStrand( m == 0 ? rev[m] : !rev[m] );
+			al.MapQuality = 60;
+			al.CigarData.push_back( CigarOp( 'M', readLen ) );
+
+			if( found[o] )
+			{
+				al.MateRefID = ctg[o];
+				al.MatePosition = pos[o];
+				al.SetIsMateMapped(true);
+				al.SetIsMateReverseStrand( m == 0 ? !rev[o] : rev[o] );
+				al.InsertSize = (ctg[o] != ctg[m]) ? 0 : (pos[o] > pos[m] ? pos[o]+readLen-pos[m] : -(pos[m]+readLen-pos[o]));
+			}
+			else
+			{
+				al.MateRefID = -1;
+				al.MatePosition = -1;
+				al.SetIsMateMapped(false);
+			}
+
+			// some reads with multiple mappings
+			if( k % 50 == 7 ) al.AddTag( "NH", "i", (int32_t)2 );
+
+			aligns.push_back(al);
+		}
+	}
+
+	std::sort( aligns.begin(), aligns.end(), alignmentLess );
+
+	SamHeader header;
+	header.SortOrder = "coordinate";
+	header.Version = "1.0";
+
+	BamWriter writer;
+	if( !writer.Open( prefix + ".bam", header, refs ) )
+	{
+		std::cerr << "[error] unable to write " << prefix << ".bam" << std::endl;
+		exit(1);
+	}
+
+	for( size_t i=0; i < aligns.size(); i++ ) writer.SaveAlignment( aligns[i] );
+	writer.Close();
+
+	BamReader reader;
+	reader.Open( prefix + ".bam" );
+	reader.CreateIndex( BamIndex::STANDARD );
+	reader.Close();
+}
+
+int main( int argc, char *argv[] )
+{
+	if( argc < 2 )
+	{
+		std::cerr << "Usage: gam-simulate <genome size> [coverage=30] [indel rate=0.0005] [flank %=50] [slave subst. rate=0.0008]" << std::endl;
+		return 1;
+	}
+
+	int genomeSize = atoi(argv[1]);
+	int coverage = argc > 2 ? atoi(argv[2]) : 30;
+
+	SimParams par;
+	par.indelRate = argc > 3 ? atof(argv[3]) : 0.0005;
+	par.flankPercent = argc > 4 ? atoi(argv[4]) : 50;
+	par.masterSubst = 0.0005;
+	par.slaveSubst = argc > 5 ? atof(argv[5]) : 0.0008;
+
+	if( genomeSize < 100000 )
+	{
+		std::cerr << "[error] genome size must be at least 100000" << std::endl;
+		return 1;
+	}
+
+	std::string genome = randomSeq( genomeSize );
+
+	// some repeats
+	for( int r=0; r < 20; r++ )
+	{
+		int src = rnd() % (genomeSize-2000), dst = rnd() % (genomeSize-2000);
+		for( int i=0; i < 1500; i++ ) genome[dst+i] = genome[src+i];
+	}
+
+	std::vector<SimContig> master = splitGenome( genome, 20000, 60000, 0, "mctg", par.masterSubst, par );
+	std::vector<SimContig> slave = splitGenome( genome, 15000, 45000, 3, "sctg", par.slaveSubst, par );
+
+	int pairs = (long long)genomeSize * coverage / 200;
+	writeAssembly( "master", master, genome, pairs, 100, 500, 1234 );
+	writeAssembly( "slave", slave, genome, pairs, 100, 500, 1234 );
+
+	return 0;
+}
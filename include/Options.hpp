@@ -55,6 +55,13 @@ public:
 
 	program_mode_t program_mode;
 
+	typedef enum
+        {
+            strand_solver_tree,
+            strand_solver_paths,
+            strand_solver_compare
+        } __attribute__((packed)) strand_solver_t;
+
 	int argc;
 	char **argv;
 
@@ -76,8 +83,14 @@ public:
 
 	int minBlockSize;
 	int threadsNum;
+	int decompressThreadsNum;
+	int coverageWidth;
+	std::string coverageSpillDir;
 	double coverageThreshold;
 	bool noMultiplicityFilter;
+	bool textBlocks;
+	bool affineGaps;
+	strand_solver_t strandSolver;
 
 	bool debug;
 
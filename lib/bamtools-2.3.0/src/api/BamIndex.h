@@ -69,6 +69,10 @@ class API_EXPORT BamIndex {
         // returns the 'type' enum for derived index format
         virtual BamIndex::IndexType Type(void) const =0;
 
+        // creates an index for another reader of the same BAM file, sharing (read-only)
+        // the in-memory data of this index, which must outlive it (0 if not supported)
+        virtual BamIndex* Share(Internal::BamReaderPrivate* reader) const { return 0; }
+
     //! \cond
 
     // internal methods
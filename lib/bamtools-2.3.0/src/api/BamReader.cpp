@@ -276,6 +276,24 @@ bool BamReader::Open(const std::string& filename) {
     return d->Open(filename);
 }
 
+/*! \fn bool BamReader::OpenShared(const BamReader& other)
+    \brief Opens the BAM file of another reader, sharing its data.
+
+    The header, the reference data and the in-memory index data of \a other
+    are shared read-only, rather than loaded again: only the file handles
+    (and the buffers) are private to this reader. Thus, several readers can
+    perform region queries on the same file concurrently, each one from its
+    own thread. \a other must stay open as long as this reader is.
+
+    \param[in] other an open BamReader (possibly with an index)
+
+    \returns \c true if BAM file (and its index) was opened successfully
+    \sa Open(), OpenIndex()
+*/
+bool BamReader::OpenShared(const BamReader& other) {
+    return d->OpenShared(*other.d);
+}
+
 /*! \fn bool BamReader::OpenIndex(const std::string& indexFilename)
     \brief Opens a BAM index file.
 
@@ -304,6 +322,21 @@ bool BamReader::Rewind(void) {
     return d->Rewind();
 }
 
+/*! \fn bool BamReader::SetDecompressThreads(int numThreads)
+    \brief Sets number of threads decompressing upcoming data in background.
+
+    When \a numThreads is greater than 0, a pool of threads reads ahead and
+    decompresses the next BGZF blocks, while alignments are parsed by the
+    calling thread. This mostly benefits long sequential scans of the file:
+    blocks read ahead are discarded on every random-access jump.
+
+    \param[in] numThreads number of decompression threads (0 disables read-ahead)
+    \returns \c true if read-ahead has been successfully (re)configured
+*/
+bool BamReader::SetDecompressThreads(int numThreads) {
+    return d->SetDecompressThreads(numThreads);
+}
+
 /*! \fn void BamReader::SetIndex(BamIndex* index)
     \brief Sets a custom BamIndex on this reader.
 
@@ -46,8 +46,12 @@ class API_EXPORT BamReader {
         bool Jump(int refID, int position = 0);
         // opens a BAM file
         bool Open(const std::string& filename);
+        // opens the BAM file of another reader, sharing its header & index data
+        bool OpenShared(const BamReader& other);
         // returns internal file pointer to beginning of alignment data
         bool Rewind(void);
+        // sets number of threads decompressing upcoming data in background
+        bool SetDecompressThreads(int numThreads);
         // sets the target region of interest
         bool SetRegion(const BamRegion& region);
         // sets the target region of interest
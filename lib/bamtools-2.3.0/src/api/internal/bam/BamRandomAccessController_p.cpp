@@ -250,6 +250,26 @@ void BamRandomAccessController::SetIndex(BamIndex* index) {
     m_index = index;
 }
 
+bool BamRandomAccessController::ShareIndex(const BamRandomAccessController& other, BamReaderPrivate* reader) {
+
+    if ( other.m_index == 0 ) {
+        SetErrorString("BamRandomAccessController::ShareIndex", "no index to share");
+        return false;
+    }
+
+    // attempt to create an index sharing other's data
+    BamIndex* index = other.m_index->Share(reader);
+    if ( index == 0 ) {
+        const string message = string("could not share index: ") + other.m_index->GetErrorString();
+        SetErrorString("BamRandomAccessController::ShareIndex", message);
+        return false;
+    }
+
+    // save new index & return success
+    SetIndex(index);
+    return true;
+}
+
 bool BamRandomAccessController::SetRegion(const BamRegion& region, const int& referenceCount) {
 
     // store region
@@ -55,6 +55,7 @@ class BamRandomAccessController {
         bool LocateIndex(BamReaderPrivate* reader, const BamIndex::IndexType& preferredType);
         bool OpenIndex(const std::string& indexFilename, BamReaderPrivate* reader);
         void SetIndex(BamIndex* index);
+        bool ShareIndex(const BamRandomAccessController& other, BamReaderPrivate* reader);
 
         // region methods
         void ClearRegion(void);
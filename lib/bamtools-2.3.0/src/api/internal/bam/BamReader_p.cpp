@@ -30,6 +30,7 @@ using namespace std;
 // constructor
 BamReaderPrivate::BamReaderPrivate(BamReader* parent)
     : m_alignmentsBeginOffset(0)
+    , m_shared(0)
     , m_parent(parent)
 {
     m_isBigEndian = BamTools::SystemIsBigEndian();
@@ -46,6 +47,7 @@ bool BamReaderPrivate::Close(void) {
     // clear BAM metadata
     m_references.clear();
     m_header.Clear();
+    m_shared = 0;
 
     // clear filename
     m_filename.clear();
@@ -95,6 +97,7 @@ const string BamReaderPrivate::Filename(void) const {
 }
 
 const SamHeader& BamReaderPrivate::GetConstSamHeader(void) const {
+    if ( m_shared ) return m_shared->GetConstSamHeader();
     return m_header.ToConstSamHeader();
 }
 
@@ -104,11 +107,13 @@ string BamReaderPrivate::GetErrorString(void) const {
 
 // return header data as std::string
 string BamReaderPrivate::GetHeaderText(void) const {
+    if ( m_shared ) return m_shared->GetHeaderText();
     return m_header.ToString();
 }
 
 // return header data as SamHeader object
 SamHeader BamReaderPrivate::GetSamHeader(void) const {
+    if ( m_shared ) return m_shared->GetSamHeader();
     return m_header.ToSamHeader();
 }
 
@@ -195,10 +200,11 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment) {
 }
 
 int BamReaderPrivate::GetReferenceCount(void) const {
-    return m_references.size();
+    return GetReferenceData().size();
 }
 
 const RefVector& BamReaderPrivate::GetReferenceData(void) const {
+    if ( m_shared ) return m_shared->GetReferenceData();
     return m_references;
 }
 
@@ -207,14 +213,15 @@ int BamReaderPrivate::GetReferenceID(const string& refName) const {
 
     // retrieve names from reference data
     vector<string> refNames;
-    RefVector::const_iterator refIter = m_references.begin();
-    RefVector::const_iterator refEnd  = m_references.end();
+    const RefVector& references = GetReferenceData();
+    RefVector::const_iterator refIter = references.begin();
+    RefVector::const_iterator refEnd  = references.end();
     for ( ; refIter != refEnd; ++refIter)
         refNames.push_back( (*refIter).RefName );
 
     // return 'index-of' refName (or -1 if not found)
     int index = distance(refNames.begin(), find(refNames.begin(), refNames.end(), refName));
-    if ( index == (int)m_references.size() ) return -1;
+    if ( index == (int)references.size() ) return -1;
     else return index;
 }
 
@@ -393,6 +400,41 @@ bool BamReaderPrivate::Open(const string& filename) {
     }
 }
 
+// opens the BAM file of another reader, sharing its header, references & index
+bool BamReaderPrivate::OpenShared(const BamReaderPrivate& other) {
+
+    try {
+
+        // make sure we're starting with fresh state
+        Close();
+
+        // open BgzfStream
+        m_stream.Open(other.m_filename, IBamIODevice::ReadOnly);
+
+        // share BAM metadata, rather than loading it again
+        m_shared = ( other.m_shared ? other.m_shared : &other );
+        m_filename = other.m_filename;
+        m_alignmentsBeginOffset = other.m_alignmentsBeginOffset;
+
+        if ( !Seek(m_alignmentsBeginOffset) )
+            throw BamException("BamReader::OpenShared", m_errorString);
+
+        // share index, if any
+        if ( other.HasIndex() && !m_randomAccessController.ShareIndex(other.m_randomAccessController, this) )
+            throw BamException("BamReader::OpenShared", m_randomAccessController.GetErrorString());
+
+        // return success
+        return true;
+
+    } catch ( BamException& e ) {
+        const string error = e.what();
+        const string message = string("could not open file: ") + other.m_filename +
+                               "\n\t" + error;
+        SetErrorString("BamReader::OpenShared", message);
+        return false;
+    }
+}
+
 bool BamReaderPrivate::OpenIndex(const std::string& indexFilename) {
 
     if ( m_randomAccessController.OpenIndex(indexFilename, this) )
@@ -447,6 +489,20 @@ void BamReaderPrivate::SetErrorString(const string& where, const string& what) {
     m_errorString = where + SEPARATOR + what;
 }
 
+bool BamReaderPrivate::SetDecompressThreads(int numThreads) {
+
+    try {
+        m_stream.SetReadAheadThreads(numThreads);
+        return true;
+    }
+    catch ( BamException& e ) {
+        const string streamError = e.what();
+        const string message = string("could not set decompression threads: \n\t") + streamError;
+        SetErrorString("BamReader::SetDecompressThreads", message);
+        return false;
+    }
+}
+
 void BamReaderPrivate::SetIndex(BamIndex* index) {
     m_randomAccessController.SetIndex(index);
 }
@@ -455,7 +511,7 @@ void BamReaderPrivate::SetIndex(BamIndex* index) {
 // returns success/failure
 bool BamReaderPrivate::SetRegion(const BamRegion& region) {
 
-    if ( m_randomAccessController.SetRegion(region, m_references.size()) )
+    if ( m_randomAccessController.SetRegion(region, GetReferenceCount()) )
         return true;
     else {
         const string bracError = m_randomAccessController.GetErrorString();
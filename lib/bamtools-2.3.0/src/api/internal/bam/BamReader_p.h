@@ -47,7 +47,9 @@ class BamReaderPrivate {
         const std::string Filename(void) const;
         bool IsOpen(void) const;
         bool Open(const std::string& filename);
+        bool OpenShared(const BamReaderPrivate& other);
         bool Rewind(void);
+        bool SetDecompressThreads(int numThreads);
         bool SetRegion(const BamRegion& region);
 
         // access alignment data
@@ -98,6 +100,9 @@ class BamReaderPrivate {
         std::string m_filename;
         RefVector   m_references;
 
+        // reader whose header, references & index are shared (not owned, 0 if none)
+        const BamReaderPrivate* m_shared;
+
         // system data
         bool m_isBigEndian;
 
@@ -64,6 +64,7 @@ BamStandardIndex::RaiiWrapper::~RaiiWrapper(void) {
 // ctor
 BamStandardIndex::BamStandardIndex(Internal::BamReaderPrivate* reader)
     : BamIndex(reader)
+    , m_sharedSummary(0)
     , m_bufferLength(0)
 {
      m_isBigEndian = BamTools::SystemIsBigEndian();
@@ -427,11 +428,11 @@ const string BamStandardIndex::Extension(void) {
 void BamStandardIndex::GetOffset(const BamRegion& region, int64_t& offset, bool* hasAlignmentsInRegion) {
 
     // cannot calculate offsets if unknown/invalid reference ID requested
-    if ( region.LeftRefID < 0 || region.LeftRefID >= (int)m_indexFileSummary.size() )
+    if ( region.LeftRefID < 0 || region.LeftRefID >= (int)Summary().size() )
         throw BamException("BamStandardIndex::GetOffset", "invalid reference ID requested");
 
     // retrieve index summary for left bound reference
-    const BaiReferenceSummary& refSummary = m_indexFileSummary.at(region.LeftRefID);
+    const BaiReferenceSummary& refSummary = Summary().at(region.LeftRefID);
 
     // set up region boundaries based on actual BamReader data
     uint32_t begin;
@@ -495,9 +496,9 @@ void BamStandardIndex::GetOffset(const BamRegion& region, int64_t& offset, bool*
 
 // returns whether reference has alignments or no
 bool BamStandardIndex::HasAlignments(const int& referenceID) const {
-    if ( referenceID < 0 || referenceID >= (int)m_indexFileSummary.size() )
+    if ( referenceID < 0 || referenceID >= (int)Summary().size() )
         return false;
-    const BaiReferenceSummary& refSummary = m_indexFileSummary.at(referenceID);
+    const BaiReferenceSummary& refSummary = Summary().at(referenceID);
     return ( refSummary.NumBins > 0 );
 }
 
@@ -547,6 +548,7 @@ bool BamStandardIndex::Load(const std::string& filename) {
 
         // attempt to open file (read-only)
         OpenFile(filename, IBamIODevice::ReadOnly);
+        m_indexFilename = filename;
 
         // validate format
         CheckMagicNumber();
@@ -563,6 +565,24 @@ bool BamStandardIndex::Load(const std::string& filename) {
     }
 }
 
+BamIndex* BamStandardIndex::Share(Internal::BamReaderPrivate* reader) const {
+
+    BamStandardIndex* index = new BamStandardIndex(reader);
+
+    try {
+        // each index reads bins through its own file handle
+        index->OpenFile(m_indexFilename, IBamIODevice::ReadOnly);
+    } catch ( BamException& e ) {
+        m_errorString = e.what();
+        delete index;
+        return 0;
+    }
+
+    index->m_indexFilename = m_indexFilename;
+    index->m_sharedSummary = &Summary();
+    return index;
+}
+
 uint64_t BamStandardIndex::LookupLinearOffset(const BaiReferenceSummary& refSummary, const int& index) {
 
     // attempt seek to proper index file position
@@ -788,6 +808,10 @@ void BamStandardIndex::SortLinearOffsets(BaiLinearOffsetVector& linearOffsets) {
     sort( linearOffsets.begin(), linearOffsets.end() );
 }
 
+const BaiFileSummary& BamStandardIndex::Summary(void) const {
+    return ( m_sharedSummary ? *m_sharedSummary : m_indexFileSummary );
+}
+
 void BamStandardIndex::SummarizeBins(BaiReferenceSummary& refSummary) {
 
     // load number of bins
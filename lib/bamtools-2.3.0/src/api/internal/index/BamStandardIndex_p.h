@@ -123,6 +123,8 @@ class BamStandardIndex : public BamIndex {
         bool Jump(const BamTools::BamRegion& region, bool* hasAlignmentsInRegion);
         // loads existing data from file into memory
         bool Load(const std::string& filename);
+        // creates an index for another reader, sharing this index's summary
+        BamIndex* Share(Internal::BamReaderPrivate* reader) const;
         BamIndex::IndexType Type(void) const { return BamIndex::STANDARD; }
     public:
         // returns format's file extension
@@ -131,6 +133,9 @@ class BamStandardIndex : public BamIndex {
     // internal methods
     private:
 
+        // returns the in-memory summary (possibly shared with another index)
+        const BaiFileSummary& Summary(void) const;
+
         // index file ops
         void CheckMagicNumber(void);
         void CloseFile(void);
@@ -198,7 +203,9 @@ class BamStandardIndex : public BamIndex {
     // data members
     private:
         bool m_isBigEndian;
+        std::string m_indexFilename;
         BaiFileSummary m_indexFileSummary;
+        const BaiFileSummary* m_sharedSummary; // not owned, 0 unless created by Share()
 
         // our input buffer
         unsigned int m_bufferLength;
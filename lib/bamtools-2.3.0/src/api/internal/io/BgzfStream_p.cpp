@@ -19,12 +19,233 @@ using namespace BamTools::Internal;
 
 #include "zlib.h"
 
+#include <pthread.h>
 #include <cstring>
 #include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <vector>
 using namespace std;
 
+// ---------------------------
+// BgzfReadAhead implementation
+// ---------------------------
+
+namespace BamTools {
+namespace Internal {
+
+// ring of blocks read from device & inflated in order by a pool of worker threads,
+// while the owning BgzfStream consumes them in the same order
+struct BgzfReadAhead {
+
+    enum SlotState { SLOT_FREE = 0, SLOT_INFLATING, SLOT_READY };
+
+    struct Slot {
+        SlotState State;
+        RaiiBuffer* Compressed;
+        RaiiBuffer* Uncompressed;
+        size_t BlockLength;     // uncompressed length (0 at EOF)
+        int64_t Address;        // address of the block in file
+        int64_t NextAddress;    // address of the following block
+        string Error;
+    };
+
+    BgzfStream* Stream;
+    vector<pthread_t> Threads;
+    vector<Slot> Slots;
+
+    pthread_mutex_t Mutex;
+    pthread_cond_t WorkCond;    // signalled when a slot becomes free (or on stop)
+    pthread_cond_t ReadyCond;   // signalled when a slot becomes ready
+
+    uint64_t NextRead;          // sequence number of the next block to read from device
+    uint64_t NextConsume;       // sequence number of the next block to hand to the stream
+    int64_t ResumeAddress;      // address of the first block not yet consumed
+    int NumInflating;
+    bool IsEof;
+    bool IsStopped;
+
+    BgzfReadAhead(BgzfStream* stream, int numThreads)
+        : Stream(stream)
+        , Threads(numThreads)
+        , Slots(2*numThreads + 2)
+        , NextRead(0)
+        , NextConsume(0)
+        , ResumeAddress(stream->m_device->Tell())
+        , NumInflating(0)
+        , IsEof(false)
+        , IsStopped(false)
+    {
+        for ( size_t i = 0; i < Slots.size(); ++i ) {
+            Slots[i].State = SLOT_FREE;
+            Slots[i].Compressed = new RaiiBuffer(Constants::BGZF_MAX_BLOCK_SIZE);
+            Slots[i].Uncompressed = new RaiiBuffer(Constants::BGZF_DEFAULT_BLOCK_SIZE);
+            Slots[i].BlockLength = 0;
+            Slots[i].Address = 0;
+            Slots[i].NextAddress = 0;
+        }
+
+        pthread_mutex_init(&Mutex, NULL);
+        pthread_cond_init(&WorkCond, NULL);
+        pthread_cond_init(&ReadyCond, NULL);
+
+        for ( size_t i = 0; i < Threads.size(); ++i )
+            pthread_create(&Threads[i], NULL, BgzfReadAhead::Worker, this);
+    }
+
+    ~BgzfReadAhead(void) {
+
+        pthread_mutex_lock(&Mutex);
+        IsStopped = true;
+        pthread_cond_broadcast(&WorkCond);
+        pthread_mutex_unlock(&Mutex);
+
+        for ( size_t i = 0; i < Threads.size(); ++i )
+            pthread_join(Threads[i], NULL);
+
+        for ( size_t i = 0; i < Slots.size(); ++i ) {
+            delete Slots[i].Compressed;
+            delete Slots[i].Uncompressed;
+        }
+
+        pthread_cond_destroy(&ReadyCond);
+        pthread_cond_destroy(&WorkCond);
+        pthread_mutex_destroy(&Mutex);
+    }
+
+    static void* Worker(void* arg) {
+        static_cast<BgzfReadAhead*>(arg)->Run();
+        return NULL;
+    }
+
+    void Run(void) {
+
+        pthread_mutex_lock(&Mutex);
+
+        while ( true ) {
+
+            while ( !IsStopped && (IsEof || Slots[NextRead % Slots.size()].State != SLOT_FREE) )
+                pthread_cond_wait(&WorkCond, &Mutex);
+
+            if ( IsStopped ) break;
+
+            Slot& slot = Slots[NextRead % Slots.size()];
+            ++NextRead;
+
+            // device is accessed sequentially, while holding the lock
+            size_t compressedLength = 0;
+            slot.Error.clear();
+            slot.Address = Stream->m_device->Tell();
+            try {
+                compressedLength = Stream->ReadCompressedBlock(slot.Compressed->Buffer);
+            }
+            catch ( BamException& e ) {
+                slot.Error = e.what();
+            }
+            slot.NextAddress = Stream->m_device->Tell();
+
+            // EOF (or device error) reached: no more blocks to read
+            if ( compressedLength == 0 ) {
+                IsEof = true;
+                slot.BlockLength = 0;
+                slot.State = SLOT_READY;
+                pthread_cond_broadcast(&ReadyCond);
+                continue;
+            }
+
+            // decompress the block without holding the lock
+            slot.State = SLOT_INFLATING;
+            ++NumInflating;
+            pthread_mutex_unlock(&Mutex);
+
+            size_t blockLength = 0;
+            string error;
+            try {
+                blockLength = BgzfStream::InflateBlock(slot.Compressed->Buffer, compressedLength, slot.Uncompressed->Buffer);
+            }
+            catch ( BamException& e ) {
+                error = e.what();
+            }
+
+            pthread_mutex_lock(&Mutex);
+            slot.BlockLength = blockLength;
+            slot.Error = error;
+            slot.State = SLOT_READY;
+            --NumInflating;
+            pthread_cond_broadcast(&ReadyCond);
+        }
+
+        pthread_mutex_unlock(&Mutex);
+    }
+
+    // waits for the next block & copies it into the stream's uncompressed buffer
+    void Consume(void) {
+
+        pthread_mutex_lock(&Mutex);
+
+        Slot& slot = Slots[NextConsume % Slots.size()];
+        while ( slot.State != SLOT_READY )
+            pthread_cond_wait(&ReadyCond, &Mutex);
+
+        const string error = slot.Error;
+        const size_t blockLength = slot.BlockLength;
+        const int64_t address = slot.Address;
+        Stream->m_nextBlockAddress = slot.NextAddress;
+
+        // EOF slot is kept, so that further reads keep returning EOF
+        if ( blockLength > 0 ) {
+            memcpy(Stream->m_uncompressedBlock.Buffer, slot.Uncompressed->Buffer, blockLength);
+            slot.State = SLOT_FREE;
+            ResumeAddress = slot.NextAddress;
+            ++NextConsume;
+            pthread_cond_broadcast(&WorkCond);
+        }
+
+        pthread_mutex_unlock(&Mutex);
+
+        if ( !error.empty() )
+            throw BamException("BgzfStream::ReadBlock", error);
+
+        // update block data
+        if ( blockLength == 0 ) {
+            Stream->m_blockLength = 0;
+            return;
+        }
+
+        if ( Stream->m_blockLength != 0 )
+            Stream->m_blockOffset = 0;
+        Stream->m_blockAddress = address;
+        Stream->m_blockLength  = blockLength;
+    }
+
+    // waits for running decompressions, then drops every block read ahead
+    // (lock is kept on return, so that device can be safely repositioned)
+    void Suspend(void) {
+
+        pthread_mutex_lock(&Mutex);
+
+        while ( NumInflating > 0 )
+            pthread_cond_wait(&ReadyCond, &Mutex);
+
+        for ( size_t i = 0; i < Slots.size(); ++i )
+            Slots[i].State = SLOT_FREE;
+
+        NextRead = 0;
+        NextConsume = 0;
+        IsEof = false;
+    }
+
+    // restarts reading ahead from current device position
+    void Resume(void) {
+        ResumeAddress = Stream->m_device->Tell();
+        pthread_cond_broadcast(&WorkCond);
+        pthread_mutex_unlock(&Mutex);
+    }
+};
+
+} // namespace Internal
+} // namespace BamTools
+
 // ---------------------------
 // BgzfStream implementation
 // ---------------------------
@@ -34,10 +255,13 @@ BgzfStream::BgzfStream(void)
   : m_blockLength(0)
   , m_blockOffset(0)
   , m_blockAddress(0)
+  , m_nextBlockAddress(0)
   , m_isWriteCompressed(true)
   , m_device(0)
   , m_uncompressedBlock(Constants::BGZF_DEFAULT_BLOCK_SIZE)
   , m_compressedBlock(Constants::BGZF_MAX_BLOCK_SIZE)
+  , m_readAheadThreads(0)
+  , m_readAhead(0)
 { }
 
 // destructor
@@ -63,6 +287,12 @@ void BgzfStream::Close(void) {
     // skip if no device open
     if ( m_device == 0 ) return;
 
+    // stop background decompression
+    if ( m_readAhead ) {
+        delete m_readAhead;
+        m_readAhead = 0;
+    }
+
     // if writing to file, flush the current BGZF block,
     // then write an empty block (as EOF marker)
     if ( m_device->IsOpen() && (m_device->Mode() == IBamIODevice::WriteOnly) ) {
@@ -84,6 +314,7 @@ void BgzfStream::Close(void) {
     m_blockLength = 0;
     m_blockOffset = 0;
     m_blockAddress = 0;
+    m_nextBlockAddress = 0;
     m_isWriteCompressed = true;
 }
 
@@ -229,14 +460,19 @@ void BgzfStream::FlushBlock(void) {
 
 // decompresses the current block
 size_t BgzfStream::InflateBlock(const size_t& blockLength) {
+    return InflateBlock(m_compressedBlock.Buffer, blockLength, m_uncompressedBlock.Buffer);
+}
+
+// decompresses a BGZF block into a byte buffer
+size_t BgzfStream::InflateBlock(char* compressed, const size_t& blockLength, char* uncompressed) {
 
     // setup zlib stream object
     z_stream zs;
     zs.zalloc    = NULL;
     zs.zfree     = NULL;
-    zs.next_in   = (Bytef*)m_compressedBlock.Buffer + 18;
+    zs.next_in   = (Bytef*)compressed + 18;
     zs.avail_in  = blockLength - 16;
-    zs.next_out  = (Bytef*)m_uncompressedBlock.Buffer;
+    zs.next_out  = (Bytef*)uncompressed;
     zs.avail_out = Constants::BGZF_DEFAULT_BLOCK_SIZE;
 
     // initialize
@@ -325,7 +561,7 @@ size_t BgzfStream::Read(char* data, const size_t dataLength) {
 
     // update block data
     if ( m_blockOffset == m_blockLength ) {
-        m_blockAddress = m_device->Tell();
+        m_blockAddress = m_nextBlockAddress;
         m_blockOffset  = 0;
         m_blockLength  = 0;
     }
@@ -339,9 +575,40 @@ void BgzfStream::ReadBlock(void) {
 
     BT_ASSERT_X( m_device, "BgzfStream::ReadBlock() - trying to read from null IO device");
 
+    // if requested, take block from (lazily started) read-ahead threads
+    if ( m_readAheadThreads > 0 ) {
+        if ( m_readAhead == 0 )
+            m_readAhead = new BgzfReadAhead(this, m_readAheadThreads);
+        m_readAhead->Consume();
+        return;
+    }
+
     // store block's starting address
     const int64_t blockAddress = m_device->Tell();
 
+    // read compressed block from file
+    const size_t blockLength = ReadCompressedBlock(m_compressedBlock.Buffer);
+    m_nextBlockAddress = m_device->Tell();
+
+    // if block empty
+    if ( blockLength == 0 ) {
+        m_blockLength = 0;
+        return;
+    }
+
+    // decompress block data
+    const size_t newBlockLength = InflateBlock(blockLength);
+
+    // update block data
+    if ( m_blockLength != 0 )
+        m_blockOffset = 0;
+    m_blockAddress = blockAddress;
+    m_blockLength  = newBlockLength;
+}
+
+// reads a compressed BGZF block from device (returns 0 at EOF)
+size_t BgzfStream::ReadCompressedBlock(char* buffer) {
+
     // read block header from file
     char header[Constants::BGZF_BLOCK_HEADER_LENGTH];
     int64_t numBytesRead = m_device->Read(header, Constants::BGZF_BLOCK_HEADER_LENGTH);
@@ -353,10 +620,8 @@ void BgzfStream::ReadBlock(void) {
     }
 
     // if block header empty
-    if ( numBytesRead == 0 ) {
-        m_blockLength = 0;
-        return;
-    }
+    if ( numBytesRead == 0 )
+        return 0;
 
     // if block header invalid size
     if ( numBytesRead != static_cast<int8_t>(Constants::BGZF_BLOCK_HEADER_LENGTH) )
@@ -368,11 +633,11 @@ void BgzfStream::ReadBlock(void) {
 
     // copy header contents to compressed buffer
     const size_t blockLength = BamTools::UnpackUnsignedShort(&header[16]) + 1;
-    memcpy(m_compressedBlock.Buffer, header, Constants::BGZF_BLOCK_HEADER_LENGTH);
+    memcpy(buffer, header, Constants::BGZF_BLOCK_HEADER_LENGTH);
 
     // read remainder of block
     const size_t remaining = blockLength - Constants::BGZF_BLOCK_HEADER_LENGTH;
-    numBytesRead = m_device->Read(&m_compressedBlock.Buffer[Constants::BGZF_BLOCK_HEADER_LENGTH], remaining);
+    numBytesRead = m_device->Read(&buffer[Constants::BGZF_BLOCK_HEADER_LENGTH], remaining);
 
     // check for device error
     if ( numBytesRead < 0 ) {
@@ -384,14 +649,7 @@ void BgzfStream::ReadBlock(void) {
     if ( numBytesRead != static_cast<int64_t>(remaining) )
         throw BamException("BgzfStream::ReadBlock", "could not read data from block");
 
-    // decompress block data
-    const size_t newBlockLength = InflateBlock(blockLength);
-
-    // update block data
-    if ( m_blockLength != 0 )
-        m_blockOffset = 0;
-    m_blockAddress = blockAddress;
-    m_blockLength  = newBlockLength;
+    return blockLength;
 }
 
 // seek to position in BGZF file
@@ -406,8 +664,17 @@ void BgzfStream::Seek(const int64_t& position) {
     int     blockOffset  = (position & 0xFFFF);
     int64_t blockAddress = (position >> 16) & 0xFFFFFFFFFFFFLL;
 
+    // drop blocks read ahead, device is repositioned while threads are suspended
+    if ( m_readAhead )
+        m_readAhead->Suspend();
+
     // attempt seek in file
-    if ( m_device->IsRandomAccess() && m_device->Seek(blockAddress) ) {
+    const bool seeked = m_device->IsRandomAccess() && m_device->Seek(blockAddress);
+
+    if ( m_readAhead )
+        m_readAhead->Resume();
+
+    if ( seeked ) {
 
         // update block data & return success
         m_blockLength  = 0;
@@ -421,6 +688,35 @@ void BgzfStream::Seek(const int64_t& position) {
     }
 }
 
+// sets number of threads decompressing upcoming blocks in background (0 = disabled)
+void BgzfStream::SetReadAheadThreads(int numThreads) {
+
+    if ( numThreads < 0 )
+        numThreads = 0;
+
+    // threads will be (re)started at next block read
+    if ( numThreads != m_readAheadThreads )
+        StopReadAhead();
+
+    m_readAheadThreads = numThreads;
+}
+
+// stops read-ahead threads, leaving device positioned at first unconsumed block
+void BgzfStream::StopReadAhead(void) {
+
+    if ( m_readAhead == 0 ) return;
+
+    const int64_t resumeAddress = m_readAhead->ResumeAddress;
+    delete m_readAhead;
+    m_readAhead = 0;
+
+    if ( !m_device->IsRandomAccess() || !m_device->Seek(resumeAddress) ) {
+        stringstream s("");
+        s << "unable to seek to position: " << resumeAddress;
+        throw BamException("BgzfStream::SetReadAheadThreads", s.str());
+    }
+}
+
 void BgzfStream::SetWriteCompressed(bool ok) {
     m_isWriteCompressed = ok;
 }
@@ -30,8 +30,13 @@
 namespace BamTools {
 namespace Internal {
 
+struct BgzfReadAhead;
+
 class BgzfStream {
 
+    // background decompression of upcoming blocks
+    friend struct BgzfReadAhead;
+
     // constructor & destructor
     public:
         BgzfStream(void);
@@ -51,6 +56,8 @@ class BgzfStream {
         void Seek(const int64_t& position);
         // sets IO device (closes previous, if any, but does not attempt to open)
         void SetIODevice(IBamIODevice* device);
+        // sets number of threads decompressing upcoming blocks in background (0 = disabled)
+        void SetReadAheadThreads(int numThreads);
         // enable/disable compressed output
         void SetWriteCompressed(bool ok);
         // get file position in BGZF file
@@ -68,23 +75,33 @@ class BgzfStream {
         size_t InflateBlock(const size_t& blockLength);
         // reads a BGZF block
         void ReadBlock(void);
+        // reads a compressed BGZF block from device (returns 0 at EOF)
+        size_t ReadCompressedBlock(char* buffer);
+        // stops read-ahead threads, leaving device positioned at first unconsumed block
+        void StopReadAhead(void);
 
     // static 'utility' methods
     public:
         // checks BGZF block header
         static bool CheckBlockHeader(char* header);
+        // de-compresses a BGZF block into a byte buffer
+        static size_t InflateBlock(char* compressed, const size_t& blockLength, char* uncompressed);
 
     // data members
     public:
         int32_t m_blockLength;
         int32_t m_blockOffset;
         int64_t m_blockAddress;
+        int64_t m_nextBlockAddress;
 
         bool m_isWriteCompressed;
         IBamIODevice* m_device;
 
         RaiiBuffer m_uncompressedBlock;
         RaiiBuffer m_compressedBlock;
+
+        int m_readAheadThreads;
+        BgzfReadAhead* m_readAhead;
 };
 
 } // namespace Internal
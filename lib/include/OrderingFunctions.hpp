@@ -127,23 +127,19 @@ struct ReadNumBlocksOrderer
  *      <li> <b>Back indices vector</b>: given an index \c i of \c blocks, returns the index of a block in the sorted vector. </li>
  * </ul>
  *
- * \param blocksList list of blocks
+ * \param blocks view of blocks
  * \param comparison struct for Block objects
  * \return a pair consisting of ordered indices and back indices
  */
 template< class BlocksOrderer >
 inline std::pair< std::vector<UIntType>, std::vector<UIntType> >
-getOrderedIndices( const std::list<Block> &blocksList, BlocksOrderer orderer )
+getOrderedIndices( const BlockSpan &blocks, BlocksOrderer orderer )
 {
     std::map< Block, UIntType > blockMap;
-	std::vector< Block > blocks;
-
-	blocks.reserve( blocksList.size() );
-	for( std::list<Block>::const_iterator b = blocksList.begin(); b != blocksList.end(); ++b ) blocks.push_back(*b);
 
     for( UIntType idx = 0; idx < blocks.size(); idx++ ) blockMap[ blocks[idx] ] = idx;
 
-    std::vector< Block > orderedBlocks(blocks);
+    std::vector< Block > orderedBlocks( blocks.begin(), blocks.end() );
     std::sort( orderedBlocks.begin(), orderedBlocks.end(), orderer );
 
     std::vector< UIntType > orderedIdx( blocks.size() );
@@ -167,7 +163,7 @@ getOrderedIndices( const std::list<Block> &blocksList, BlocksOrderer orderer )
  * \return ordered and back indices
  */
 std::pair< std::vector<UIntType>, std::vector<UIntType> >
-inline getOrderedMasterIndices( const std::list<Block> &blocks )
+inline getOrderedMasterIndices( const BlockSpan &blocks )
 {
     MasterBlocksOrderer mbo;
     return getOrderedIndices( blocks, mbo );
@@ -180,7 +176,7 @@ inline getOrderedMasterIndices( const std::list<Block> &blocks )
  * \return ordered and back indices
  */
 std::pair< std::vector<UIntType>, std::vector<UIntType> >
-inline getOrderedSlaveIndices( const std::list<Block> &blocks )
+inline getOrderedSlaveIndices( const BlockSpan &blocks )
 {
     SlaveBlocksOrderer sbo;
     return getOrderedIndices( blocks, sbo );
@@ -40,28 +40,43 @@
 
 using namespace options;
 
-//! Partitions a vector of blocks.
+//! Kinds of assemblies' graphs.
+enum AssemblyGraphKind { LINEAR_GRAPH, FORKS_GRAPH, BUBBLES_GRAPH, CYCLIC_GRAPH };
+
+//! Builds the compact assemblies' graph of a partition of blocks.
 /*!
- * Returns a list of vectors. Each vector contains only blocks which may
- * be merged together.
+ * The assemblies' graph of the partition is built, checked for cycles and
+ * compacted; edges are then weighted through region queries on the given
+ * BAM readers, which should be private to the calling thread.
  *
- * \param blocks a vector of blocks.
- * \param options options of the application.
- * \return a list of block vectors.
+ * \param blocks blocks of the partition (which must outlive the graph).
+ * \param agId identifier of the graph.
+ * \param kind (output) kind of the assemblies' graph.
+ * \return the compact graph, or \c NULL if the assemblies' graph is cyclic.
  */
-std::list< CompactAssemblyGraph* >
-partitionBlocks( const std::list<Block> &blocks );
+CompactAssemblyGraph*
+buildCompactGraph(
+	const BlockSpan &blocks,
+	uint64_t agId,
+	MultiBamReader &masterBamReader, MultiBamReader &masterMpBamReader,
+	MultiBamReader &slaveBamReader, MultiBamReader &slaveMpBamReader,
+	AssemblyGraphKind &kind );
 
 
+//! Computes the z-score of the inserts spanning a region, for each library.
+/*!
+ * Region queries are not synchronized: \c multiBamReader must be private to the calling thread.
+ */
 std::vector<double>
 computeZScore( MultiBamReader &multiBamReader, const uint64_t &refID, uint32_t start, uint32_t end );
 
-//! Partitions a list of blocks by paired contigs.
+//! Partitions a vector of blocks by paired contigs.
 /*!
- * \param blocks list of blocks.
- * \return vector of partitions (list of blocks).
+ * Blocks are reordered in place so that each partition is a contiguous range.
+ * \param blocks vector of blocks.
+ * \return vector of partitions (views over \c blocks).
  */
-std::vector< std::list<Block> >
-partitionBlocksByPairedContigs( const std::list< Block > &blocks );
+std::vector< BlockSpan >
+partitionBlocksByPairedContigs( std::vector<Block> &blocks );
 
 #endif	/* PARTITIONFUNCTIONS_HPP */
\ No newline at end of file
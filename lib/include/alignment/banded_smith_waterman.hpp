@@ -32,11 +32,20 @@
 #define _BANDED_SMITH_WATERMAN_
 
 #include "alignment/my_alignment.hpp"
-#include "assembly/contig.hpp"
+#include "assembly/contig_view.hpp"
+#include "alignment/banded_sw_kernels.hpp"
 
 #define FORCE_MAXGAP_LEN 10
 #define DEFAULT_BAND_SIZE 150
 #define BSW_MAX_ALIGNMENT 500000
+#define BSW_TRACEBACK_BLOCK_CELLS (1 << 24) // cells whose traceback moves are kept at once (4 MB)
+
+//! Gap penalties of BandedSmithWaterman.
+typedef enum
+{
+    BSW_GAPS_LINEAR, /*!< every gap position costs the gap score. */
+    BSW_GAPS_AFFINE  /*!< the first gap position costs the gap score, the following ones the gap extension score. */
+} BandedGapModel;
 
 class BandedSmithWaterman
 {
@@ -50,6 +59,14 @@ class BandedSmithWaterman
         const ScoreType _gap_score;
         const ScoreType _gap_ext_score;
         const size_type _band_size;
+        BandedKernelType _kernel; //!< kernel used to fill the matrix.
+        BandedGapModel _gap_model; //!< linear or affine (Gotoh) gaps.
+
+        template< typename CellType >
+        MyAlignment
+        align_band(const ContigView& a, size_type begin_a, size_type end_a,
+                const ContigView& b, size_type begin_b, size_type x_size,
+                bool force_start, bool force_end ) const;
 
     public:
 
@@ -66,9 +83,19 @@ class BandedSmithWaterman
         BandedSmithWaterman( const size_type& band_size );
 
         MyAlignment
-        find_alignment(const Contig& a, size_type begin_a, size_type end_a,
-                const Contig& b, size_type begin_b, size_type end_b,
+        find_alignment(const ContigView& a, size_type begin_a, size_type end_a,
+                const ContigView& b, size_type begin_b, size_type end_b,
 				bool force_start = false, bool force_end = false ) const;
+
+        //! Selects the fill kernel, falling back to the best one supported by the CPU.
+        void set_kernel( BandedKernelType kernel );
+
+        BandedKernelType kernel() const;
+
+        //! Selects linear or affine gap penalties (linear by default).
+        void set_gap_model( BandedGapModel gap_model );
+
+        BandedGapModel gap_model() const;
 };
 
 #endif // _BANDED_SMITH_WATERMAN_
@@ -0,0 +1,253 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _BANDED_SW_KERNELS_CODE_
+#define _BANDED_SW_KERNELS_CODE_
+
+#include "alignment/banded_sw_kernels.hpp"
+
+/*
+ * Row-wise vectorization of the banded recurrence. In band coordinates
+ * diagonal and vertical moves only read the previous row, so they are
+ * computed for a whole vector of cells at once. The horizontal gap
+ * sw[i][j] = max( T[j], sw[i][j-1] + gap ) is a running maximum: with
+ * V[k] = T[k] - k*gap it becomes sw[i][j] = j*gap + max_{k<=j} V[k], i.e. a
+ * prefix maximum computed with log2(LANES) shifts per vector plus a carry.
+ * A second look at each cell gives the move the traceback will take from it.
+ * The affine (Gotoh) variant keeps the vertical gaps E of the previous row
+ * and turns the horizontal gaps F into the same kind of prefix maximum.
+ *
+ * Ops provides the vector type and the few primitives used below; this file
+ * is only included by the per-instruction-set translation units, which are
+ * compiled with the matching -m flags.
+ */
+namespace
+{
+
+template< class Ops >
+void bandedFillRow( const typename Ops::cell_type* prev, typename Ops::cell_type* cur, uint8_t* moves,
+                    size_t i, const BandedFillArgs& args )
+{
+    typedef typename Ops::cell_type cell_type;
+    typedef typename Ops::vec_type vec_type;
+
+    const int64_t lanes = Ops::LANES;
+    const int64_t y_size = int64_t(args.y_size);
+    const int gap = args.gap_score;
+
+    const vec_type ninf = Ops::set1( Ops::NEG_INF );
+    const vec_type zero = Ops::set1( 0 );
+    const vec_type vgap = Ops::set1( gap );
+    const vec_type vlast = Ops::set1( cell_type(y_size-1) );
+    const vec_type vstep = Ops::set1( cell_type(lanes) );
+    const vec_type vgapstep = Ops::set1( cell_type(lanes * gap) );
+    const vec_type lane_idx = Ops::lane_index();
+    const vec_type lane_gap = Ops::mullo( lane_idx, vgap );
+
+    int64_t row_pos = args.first_pos + int64_t(i); // position in a of cell (i,0)
+    int64_t jlo = row_pos < 0 ? -row_pos : 0;
+    int64_t jhi = args.a_size - 1 - row_pos;
+    if( jhi > y_size-1 ) jhi = y_size-1;
+
+    if( jlo > jhi ) // no cell of a in this row
+    {
+        for( int64_t j = 0; j < y_size; j += lanes ) Ops::store( cur+j, zero );
+        return;
+    }
+
+    const vec_type vlo = Ops::set1( cell_type(jlo) );
+    const vec_type vhi = Ops::set1( cell_type(jhi) );
+    const int8_t* table = args.score_tables + 16 * args.b_codes[i];
+    const uint8_t* a_row = args.a_codes + i;
+
+    // diagonal and vertical moves, stored as V[j] = T[j] - j*gap
+    vec_type idx = lane_idx, idx_gap = lane_gap;
+    for( int64_t j = 0; j < y_size; j += lanes )
+    {
+        vec_type diag = Ops::add( Ops::load(prev+j), Ops::scores(a_row+j,table) );
+        vec_type up = Ops::add( Ops::load(prev+j+1), vgap );
+        up = Ops::select( Ops::cmpgt(vlast,idx), up, ninf ); // no vertical move on the last diagonal
+
+        vec_type v = Ops::sub( Ops::max(diag,up), idx_gap );
+        vec_type out = Ops::bor( Ops::cmpgt(vlo,idx), Ops::cmpgt(idx,vhi) );
+        Ops::store( cur+j, Ops::select(out, ninf, v) );
+
+        idx = Ops::add( idx, vstep );
+        idx_gap = Ops::add( idx_gap, vgapstep );
+    }
+
+    // the cell on the first base of a has no diagonal predecessor
+    if( row_pos <= 0 )
+    {
+        int64_t diag = table[ a_row[jlo] ];
+        int64_t up = (jlo < y_size-1) ? int64_t(prev[jlo+1]) + gap : gap;
+        int64_t t = (jlo < y_size-1 && up > diag) ? up : diag;
+
+        // a leading gap on b is allowed unless it would be too long for a forced start
+        if( (!args.force_start || int64_t(i) <= args.force_maxgap) && gap > t ) t = gap;
+
+        cur[jlo] = cell_type( t - jlo * gap );
+    }
+
+    // horizontal moves (running maximum of V) and traceback moves
+    const vec_type one = Ops::set1( BSW_MOVE_UP );
+    const vec_type two = Ops::set1( BSW_MOVE_LEFT );
+    vec_type carry = ninf;
+    idx = lane_idx; idx_gap = lane_gap;
+    for( int64_t j = 0; j < y_size; j += lanes )
+    {
+        vec_type v = Ops::max( Ops::prefix_max(Ops::load(cur+j),ninf), carry );
+        carry = Ops::broadcast_last( v );
+
+        vec_type out = Ops::bor( Ops::cmpgt(vlo,idx), Ops::cmpgt(idx,vhi) );
+        vec_type h = Ops::select( out, zero, Ops::add(v,idx_gap) );
+        Ops::store( cur+j, h );
+
+        // same tests as the traceback: diagonal first, then vertical inside the
+        // band, vertical on its first diagonal and horizontal on its last one
+        vec_type diag = Ops::add( Ops::load(prev+j), Ops::scores(a_row+j,table) );
+        vec_type up = Ops::add( Ops::load(prev+j+1), vgap );
+        vec_type first = Ops::cmpeq( idx, zero );
+        vec_type last = Ops::cmpeq( idx, vlast );
+        vec_type vertical = Ops::bor( Ops::andnot(last,first), Ops::andnot(Ops::bor(first,last), Ops::cmpeq(h,up)) );
+        vec_type move = Ops::select( Ops::cmpeq(h,diag), zero, Ops::select(vertical,one,two) );
+        Ops::store_bytes( moves+j, move );
+
+        idx = Ops::add( idx, vstep );
+        idx_gap = Ops::add( idx_gap, vgapstep );
+    }
+}
+
+template< class Ops >
+void bandedFillAffineRow( const typename Ops::cell_type* prev_h, const typename Ops::cell_type* prev_e,
+                          typename Ops::cell_type* cur_h, typename Ops::cell_type* cur_e, uint8_t* moves,
+                          size_t i, const BandedFillArgs& args )
+{
+    typedef typename Ops::cell_type cell_type;
+    typedef typename Ops::vec_type vec_type;
+
+    const int64_t lanes = Ops::LANES;
+    const int64_t y_size = int64_t(args.y_size);
+    const int open = args.gap_score;
+    const int ext = args.gap_ext_score;
+
+    const vec_type ninf = Ops::set1( Ops::NEG_INF );
+    const vec_type zero = Ops::set1( 0 );
+    const vec_type vopen = Ops::set1( open );
+    const vec_type vext = Ops::set1( ext );
+    const vec_type vlast = Ops::set1( cell_type(y_size-1) );
+    const vec_type vstep = Ops::set1( cell_type(lanes) );
+    const vec_type vextstep = Ops::set1( cell_type(lanes * ext) );
+    const vec_type lane_idx = Ops::lane_index();
+    const vec_type lane_ext = Ops::mullo( lane_idx, vext );
+
+    int64_t row_pos = args.first_pos + int64_t(i); // position in a of cell (i,0)
+    int64_t jlo = row_pos < 0 ? -row_pos : 0;
+    int64_t jhi = args.a_size - 1 - row_pos;
+    if( jhi > y_size-1 ) jhi = y_size-1;
+
+    if( jlo > jhi ) // no cell of a in this row
+    {
+        for( int64_t j = 0; j < y_size; j += lanes ) { Ops::store( cur_h+j, zero ); Ops::store( cur_e+j, ninf ); }
+        return;
+    }
+
+    const vec_type vlo = Ops::set1( cell_type(jlo) );
+    const vec_type vhi = Ops::set1( cell_type(jhi) );
+    const int8_t* table = args.score_tables + 16 * args.b_codes[i];
+    const uint8_t* a_row = args.a_codes + i;
+
+    // gaps in a (E) and diagonal moves, stored as W[j] = max(diag,E) - j*ext
+    vec_type idx = lane_idx, idx_ext = lane_ext;
+    for( int64_t j = 0; j < y_size; j += lanes )
+    {
+        vec_type e = Ops::max( Ops::add(Ops::load(prev_h+j+1),vopen), Ops::add(Ops::load(prev_e+j+1),vext) );
+        e = Ops::select( Ops::cmpgt(vlast,idx), e, ninf ); // no vertical move on the last diagonal
+
+        vec_type diag = Ops::add( Ops::load(prev_h+j), Ops::scores(a_row+j,table) );
+        vec_type out = Ops::bor( Ops::cmpgt(vlo,idx), Ops::cmpgt(idx,vhi) );
+        Ops::store( cur_e+j, Ops::select(out, ninf, e) );
+        Ops::store( cur_h+j, Ops::select(out, ninf, Ops::sub(Ops::max(diag,e),idx_ext)) );
+
+        idx = Ops::add( idx, vstep );
+        idx_ext = Ops::add( idx_ext, vextstep );
+    }
+
+    // the cell on the first base of a starts the alignment
+    if( row_pos <= 0 )
+    {
+        int64_t start = table[ a_row[jlo] ];
+        if( args.force_start && int64_t(i) > args.force_maxgap ) start += open + (int64_t(i)-1) * ext;
+        if( int64_t(cur_e[jlo]) > start ) start = cur_e[jlo];
+
+        cur_h[jlo] = cell_type( start - jlo * ext );
+    }
+
+    // gaps in b (F): since open <= ext, F[j] = open + (j-1)*ext + max_{k<j} W[k]
+    const vec_type vopenext = Ops::set1( open - ext );
+    const vec_type one = Ops::set1( BSW_MOVE_UP );
+    const vec_type two = Ops::set1( BSW_MOVE_LEFT );
+    const vec_type e_open = Ops::set1( BSW_MOVE_E_OPEN );
+    const vec_type f_open = Ops::set1( BSW_MOVE_F_OPEN );
+    vec_type carry = ninf, h_carry = ninf;
+    idx = lane_idx; idx_ext = lane_ext;
+    for( int64_t j = 0; j < y_size; j += lanes )
+    {
+        vec_type w = Ops::load( cur_h+j );
+        vec_type q = Ops::max( Ops::prefix_max(w,ninf), carry );
+        vec_type f = Ops::add( Ops::add(Ops::shift_in(q,carry),vopenext), idx_ext );
+        carry = Ops::broadcast_last( q );
+
+        f = Ops::select( Ops::cmpgt(idx,vlo), f, ninf ); // no horizontal move on the first cell of the row
+        vec_type h = Ops::max( Ops::add(w,idx_ext), f );
+
+        vec_type out = Ops::bor( Ops::cmpgt(vlo,idx), Ops::cmpgt(idx,vhi) );
+        h = Ops::select( out, zero, h );
+        Ops::store( cur_h+j, h );
+
+        // traceback: diagonal first, then gap in a, then gap in b; opening a gap is preferred to extending it
+        vec_type e = Ops::load( cur_e+j );
+        vec_type diag = Ops::add( Ops::load(prev_h+j), Ops::scores(a_row+j,table) );
+        vec_type h_left = Ops::shift_in( h, h_carry );
+        h_carry = Ops::broadcast_last( h );
+
+        vec_type move = Ops::select( Ops::cmpeq(h,diag), zero, Ops::select(Ops::cmpeq(h,e),one,two) );
+        move = Ops::bor( move, Ops::band(Ops::cmpeq(e,Ops::add(Ops::load(prev_h+j+1),vopen)), e_open) );
+        move = Ops::bor( move, Ops::band(Ops::cmpeq(f,Ops::add(h_left,vopen)), f_open) );
+        Ops::store_bytes( moves+j, move );
+
+        idx = Ops::add( idx, vstep );
+        idx_ext = Ops::add( idx_ext, vextstep );
+    }
+}
+
+} // anonymous namespace
+
+#endif // _BANDED_SW_KERNELS_CODE_
@@ -0,0 +1,124 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _BANDED_SW_KERNELS_
+#define _BANDED_SW_KERNELS_
+
+#include <stddef.h>
+#include <stdint.h>
+
+//! Fill kernels available to BandedSmithWaterman.
+typedef enum
+{
+    BSW_KERNEL_SCALAR, /*!< portable scalar loops. */
+    BSW_KERNEL_SSE41,  /*!< 128-bit vectors (SSE4.1). */
+    BSW_KERNEL_AVX2    /*!< 256-bit vectors (AVX2). */
+} BandedKernelType;
+
+//! Moves of the traceback, stored in 2 bits for every cell of the band (4 bits with affine gaps).
+typedef enum
+{
+    BSW_MOVE_DIAG = 0, /*!< match or mismatch. */
+    BSW_MOVE_UP = 1,   /*!< gap in a. */
+    BSW_MOVE_LEFT = 2, /*!< gap in b. */
+    BSW_MOVE_E_OPEN = 4, /*!< (affine gaps) the gap in a ending here is opened after the previous row. */
+    BSW_MOVE_F_OPEN = 8  /*!< (affine gaps) the gap in b ending here is opened after the previous cell. */
+} BandedMoveType;
+
+/*! \brief Inputs of the vectorized fill of a banded matrix.
+ *
+ * Rows are filled one at a time (one row per base of b) and cell (i,j) is the
+ * alignment of b[i] against a[first_pos+i+j]. Row 0 is filled by the caller:
+ * kernels compute row i from row i-1 with the same recurrence as the scalar
+ * code and return the traceback move of every cell, except the one on the
+ * first base of a, which is left to the caller.
+ */
+struct BandedFillArgs
+{
+    size_t x_size;               //!< number of rows.
+    size_t y_size;               //!< number of cells of the band (2*band+1).
+    size_t stride;               //!< allocated cells per row, multiple of 16 and greater than y_size.
+    const uint8_t* a_codes;      //!< base codes of a from first_pos on, followed by stride+16 spare bytes.
+    const uint8_t* b_codes;      //!< base codes of the x_size rows of b.
+    int64_t first_pos;           //!< position in a of cell (0,0), possibly negative.
+    int64_t a_size;              //!< length of a.
+    const int8_t* score_tables;  //!< for each base of b, 16 scores indexed by the base of a.
+    int gap_score;               //!< (negative) gap score, or gap opening score with affine gaps.
+    int gap_ext_score;           //!< (negative) gap extension score, used with affine gaps only.
+    bool force_start;            //!< alignment forced to start at the beginning of a.
+    int64_t force_maxgap;        //!< longest gap allowed before a forced start.
+};
+
+//! Returns the fastest kernel supported by the running CPU.
+BandedKernelType bandedKernelDetect();
+
+//! Returns a printable name of a kernel.
+const char* bandedKernelName( BandedKernelType kernel );
+
+/*! \brief SSE4.1 fill of row i with 16-bit saturating cells.
+ *
+ * \param prev  row i-1.
+ * \param cur   row i, written for stride cells.
+ * \param moves traceback move of every cell of row i (stride bytes).
+ * \return \c false if the kernel has not been compiled in.
+ */
+bool bandedFillRowSSE41( const int16_t* prev, int16_t* cur, uint8_t* moves, size_t i, const BandedFillArgs& args );
+
+//! SSE4.1 fill of a row with 32-bit cells.
+bool bandedFillRowSSE41( const int32_t* prev, int32_t* cur, uint8_t* moves, size_t i, const BandedFillArgs& args );
+
+//! AVX2 fill of a row with 16-bit saturating cells.
+bool bandedFillRowAVX2( const int16_t* prev, int16_t* cur, uint8_t* moves, size_t i, const BandedFillArgs& args );
+
+//! AVX2 fill of a row with 32-bit cells.
+bool bandedFillRowAVX2( const int32_t* prev, int32_t* cur, uint8_t* moves, size_t i, const BandedFillArgs& args );
+
+/*! \brief SSE4.1 fill of row i with affine gaps and 16-bit saturating cells.
+ *
+ * Besides the best scores (H), rows keep the scores of the alignments ending
+ * with a gap in a (E). Requires gap_score <= gap_ext_score.
+ * \return \c false if the kernel has not been compiled in.
+ */
+bool bandedFillAffineRowSSE41( const int16_t* prev_h, const int16_t* prev_e, int16_t* cur_h, int16_t* cur_e,
+                               uint8_t* moves, size_t i, const BandedFillArgs& args );
+
+//! SSE4.1 fill of a row with affine gaps and 32-bit cells.
+bool bandedFillAffineRowSSE41( const int32_t* prev_h, const int32_t* prev_e, int32_t* cur_h, int32_t* cur_e,
+                               uint8_t* moves, size_t i, const BandedFillArgs& args );
+
+//! AVX2 fill of a row with affine gaps and 16-bit saturating cells.
+bool bandedFillAffineRowAVX2( const int16_t* prev_h, const int16_t* prev_e, int16_t* cur_h, int16_t* cur_e,
+                              uint8_t* moves, size_t i, const BandedFillArgs& args );
+
+//! AVX2 fill of a row with affine gaps and 32-bit cells.
+bool bandedFillAffineRowAVX2( const int32_t* prev_h, const int32_t* prev_e, int32_t* cur_h, int32_t* cur_e,
+                              uint8_t* moves, size_t i, const BandedFillArgs& args );
+
+#endif // _BANDED_SW_KERNELS_
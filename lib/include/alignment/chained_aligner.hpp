@@ -0,0 +1,115 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _CHAINED_ALIGNER_
+#define _CHAINED_ALIGNER_
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "alignment/my_alignment.hpp"
+#include "assembly/contig_view.hpp"
+
+#define CHAIN_DEFAULT_K 15           // length of the minimizers
+#define CHAIN_DEFAULT_W 10           // consecutive k-mers each minimizer is chosen from
+#define CHAIN_MAX_OCC 32             // minimizers occurring more often in the first sequence are not used as anchors
+#define CHAIN_LOOKBACK 64            // anchors tried as predecessors of each anchor
+#define CHAIN_MAX_GAP 5000           // longest distance between chained anchors
+#define CHAIN_BAND 32                // extra diagonals around the gaps aligned between anchors
+#define CHAIN_MAX_EXTENSION 2000     // longest extension past the first/last anchor of the chain
+#define CHAIN_MAX_SEGMENT_CELLS (1 << 26) // larger segments are not aligned with dynamic programming
+
+/*! \brief Seed-and-chain aligner of long sequences.
+ *
+ * Anchors are the (w,k)-minimizers shared by the two sequences; the best
+ * collinear chain of anchors is aligned with banded dynamic programming only
+ * in the gaps between consecutive anchors, so the cost grows with the
+ * divergence of the sequences rather than with their length. Scores are the
+ * linear ones of BandedSmithWaterman. The buffers are reused across calls:
+ * an object should be kept by each thread.
+ */
+class ChainedAligner
+{
+    public:
+        typedef long int int_type;
+        typedef unsigned long int size_type;
+
+    private:
+        typedef std::pair< uint64_t, uint64_t > MinimizerType; //!< hash and position of a minimizer
+        typedef std::pair< int_type, int_type > AnchorType;    //!< positions of a shared minimizer in a and b
+
+        size_type _k;
+        size_type _w;
+
+        std::vector< MinimizerType > _a_minimizers;
+        std::vector< MinimizerType > _b_minimizers;
+        std::vector< AnchorType > _anchors;
+        std::vector< double > _chain_scores;
+        std::vector< int_type > _chain_preds;
+        std::vector< AnchorType > _chain;
+
+        std::vector< ScoreType > _rows;
+        std::vector< uint8_t > _moves;
+        std::vector< AlignmentAlphabet > _segment;
+        std::vector< AlignmentAlphabet > _edit;
+
+        void find_minimizers( const ContigView& c, size_type begin, size_type end, std::vector< MinimizerType >& minimizers ) const;
+        void find_chain( const ContigView& a, size_type begin_a, size_type end_a, const ContigView& b, size_type begin_b, size_type end_b );
+
+        ScoreType align_segment( const ContigView& a, int_type a0, size_type& la, const ContigView& b, int_type b0, size_type& lb,
+                                 int dir, bool extend );
+
+    public:
+        //! A constructor.
+        /*!
+         * \param k length of the minimizers (at most 32).
+         * \param w number of consecutive k-mers each minimizer is chosen from.
+         */
+        ChainedAligner( size_type k = CHAIN_DEFAULT_K, size_type w = CHAIN_DEFAULT_W );
+
+        //! Aligns a[begin_a..end_a] and b[begin_b..end_b].
+        /*!
+         * \param force_start the alignment starts at (begin_a,begin_b).
+         * \param force_end the alignment ends at (end_a,end_b).
+         * \return the alignment, or an empty one if the sequences share no anchor and no end is forced.
+         */
+        MyAlignment find_alignment(
+                const ContigView& a,
+                size_type begin_a,
+                size_type end_a,
+                const ContigView& b,
+                size_type begin_b,
+                size_type end_b,
+                bool force_start = false,
+                bool force_end = false );
+};
+
+#endif // _CHAINED_ALIGNER_
@@ -38,23 +38,65 @@
 #ifndef BLOCK_HPP
 #define	BLOCK_HPP
 
+#include <iterator>
 #include <list>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "api/BamAux.h"
 #include "api/BamReader.h"
 
 #include "bam/MultiBamReader.hpp"
 #include "assembly/Read.hpp"
+#include "assembly/ReadMap.hpp"
+#include "assembly/CoverageMap.hpp"
 #include "assembly/Frame.hpp"
 #include "assembly/RefSequence.hpp"
 
-#include "google/sparse_hash_map"
 #include "types.hpp"
 
 using namespace BamTools;
-using google::sparse_hash_map;
+
+#define BLOCKS_FILE_MAGIC   "GAMBLOCK"   //!< first bytes of binary blocks' files.
+#define BLOCKS_FILE_VERSION 1            //!< version of binary blocks' files.
+
+//! Header of binary blocks' files.
+/*!
+ * The header is followed by \c blocksNum fixed-size records (BlockRecord),
+ * stored in the byte order of the machine which wrote the file.
+ */
+struct BlocksFileHeader
+{
+    char     magic[8];          //!< BLOCKS_FILE_MAGIC (not null-terminated).
+    uint32_t version;           //!< BLOCKS_FILE_VERSION.
+    int32_t  minBlockSize;      //!< min-block-size used to build the blocks.
+    uint32_t masterContigs;     //!< number of contigs of the master assembly.
+    uint32_t slaveContigs;      //!< number of contigs of the slave assembly.
+    uint64_t blocksNum;         //!< number of block records.
+};
+
+//! Frame of a block, as stored in binary blocks' files.
+struct FrameRecord
+{
+    int32_t  ctgId;
+    int32_t  begin;
+    int32_t  end;
+    char     strand;
+    char     padding[3];
+    uint64_t blockReadsLen;
+    uint64_t readsLen;
+};
+
+//! Block, as stored in binary blocks' files.
+struct BlockRecord
+{
+    int64_t     numReads;
+    FrameRecord masterFrame;
+    FrameRecord slaveFrame;
+};
+
+class BlockSpan;
 
 //! Class implementing a block.
 class Block
@@ -90,6 +132,14 @@ public:
      */
     Block(const Block &block);
 
+    //! Assignment operator.
+    /*!
+     * Copies a block.
+     * \param block a Block object.
+     * \return this block.
+     */
+    Block& operator=(const Block &block);
+
     //! Sets the number of the reads in the block.
     /*!
      * \param nr number of reads.
@@ -175,45 +225,56 @@ public:
      * \param blocks    vector of blocks.
      * \return vector of blocks filtered.
      */
-    static std::vector<Block> filterBlocksByOverlaps( std::list<Block> &blocks );
+    static std::vector<Block> filterBlocksByOverlaps( const BlockSpan &blocks );
 
+    //! Removes (in place, keeping the order) blocks with low coverage.
     static void filterBlocksByCoverage(
-		std::list<Block> &blocks,
+		std::vector<Block> &blocks,
 		const std::set< std::pair<int32_t,int32_t> > &slb,
 		double min_cov,
 		double t = 0.5 );
 
 	static void filterBlocksByLength(
-		std::list<Block> &blocks,
+		std::vector<Block> &blocks,
 		const RefSequence &masterRef,
 		const RefSequence &slaveRef,
 		const std::set< std::pair<int32_t,int32_t> > &slb,
 		int32_t min_length );
 
+    //! Loads the uniquely mapped reads of the slave assembly.
+    /*!
+     * Reads are kept in coordinate order, identified by the fingerprint of their names,
+     * so that the pass over the slave's BAM may run while master's reads are being loaded.
+     * \param bamReader         BamReader object of the slave assembly (possibly restricted to a region).
+     * \param slaveReads        (output) vector of slave's reads in coordinate order.
+     * \param coverage          coverage of the slave assembly, already initialized (output)
+     * \param noMultFilter      whether reads with multiple alignments should be kept.
+     */
+    static void loadSlaveReads(
+        MultiBamReader &bamReader,
+        std::vector< KeyedRead > &slaveReads,
+        CoverageMap &coverage,
+        bool noMultFilter = false );
+
     //! Finds the blocks over two assemblies.
     /*!
+     * Blocks never span slave's contigs, hence disjoint ranges of contigs may be processed independently.
      * \param outblocks         (output) vector of blocks found.
-     * \param bamReader         BamReader object of the slave assembly.
+     * \param slaveReads        slave's reads in coordinate order (released on return).
      * \param minBlockSize      minimum reads required to form a block.
-     * \param readsMap_1        hash table of the master's reads (pair 1)
-     * \param readsMap_2        hash table of the master's reads (pair 2)
-     * \param coverage          vector of coverages of the slave assembly (output)
-     * \param assemblyId        slave assembly identifier
+     * \param readsMap          hash table of the master's reads (both pairs)
      * \return vector of blocks found.
      */
     static void findBlocks(
         std::vector<Block> &outblocks,
-        MultiBamReader &bamReader,
+        std::vector< KeyedRead > &slaveReads,
         const int minBlockSize,
-        sparse_hash_map< std::string, Read > &readsMap_1,
-        sparse_hash_map< std::string, Read > &readsMap_2,
-        std::vector< std::vector< uint32_t > > &coverage,
-        bool noMultFilter = false );
+        const ReadMap &readsMap );
 
     static void updateCoverages(
         std::vector<Block> &blocks,
-        const std::vector< std::vector<uint32_t> > &masterCoverage,
-        std::vector< std::vector<uint32_t> > &slaveCoverage );
+        const CoverageMap &masterCoverage,
+        const CoverageMap &slaveCoverage );
 
     //! Returns whether two block share the master contig.
     /*!
@@ -241,11 +302,13 @@ public:
 
     //! Reads blocks from an input file.
     /*!
+     * Both binary and text files are accepted: binary files are memory-mapped.
      * \param blockFile the name of the input file.
+     * \param blocks vector where loaded blocks are appended (output).
      * \param minBlockSize minimum size (# reads) of the blocks to be loaded.
-     * \return a vector containing the blocks read from the file.
+     * \param header header of the file (output, zeroed for text files), if not \c NULL.
      */
-	static void loadBlocks( const std::string& blockFile, std::list<Block> &blocks, int minBlockSize = 1 );
+	static void loadBlocks( const std::string& blockFile, std::vector<Block> &blocks, int minBlockSize = 1, BlocksFileHeader *header = NULL );
     static std::vector<Block> readCoreBlocks( const std::string& blockFile, int minBlockSize = 1 );
 
     //! Write a vector of blocks into a file.
@@ -254,6 +317,17 @@ public:
      * \param blocks a vector of Block objects.
      */
     static void writeBlocks( const std::string& blockFile, std::vector< Block >& blocks  );
+
+    //! Write a vector of blocks into a binary file.
+    /*!
+     * \param blockFile the name of the output file.
+     * \param blocks a vector of Block objects.
+     * \param masterContigs number of contigs of the master assembly.
+     * \param slaveContigs number of contigs of the slave assembly.
+     * \param minBlockSize min-block-size used to build the blocks.
+     */
+    static void writeBlocksBinary( const std::string& blockFile, const std::vector< Block >& blocks,
+                                   uint32_t masterContigs, uint32_t slaveContigs, int32_t minBlockSize );
     static void writeBlocksVerbose( const std::string &blockFile, std::vector< Block > &blocks, const MultiBamReader &masterBam, const MultiBamReader &slaveBam );
 
     //! Less-Than operator for the Block class.
@@ -264,17 +338,54 @@ public:
 };
 
 
+//! Read-only view over a contiguous range of blocks.
+/*!
+ * Blocks of the merge pipeline are stored once in a single vector; partitions,
+ * graphs and filters refer to sub-ranges of it through BlockSpan objects,
+ * which are as cheap to copy as a pair of pointers.
+ * A view is invalidated by any reallocation of the underlying vector.
+ */
+class BlockSpan
+{
+
+public:
+    typedef const Block* const_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    BlockSpan() : _begin(NULL), _end(NULL) {}
+    BlockSpan( const Block *begin, const Block *end ) : _begin(begin), _end(end) {}
+    BlockSpan( const std::vector<Block> &blocks ) :
+        _begin( blocks.empty() ? NULL : &blocks[0] ), _end( _begin + blocks.size() ) {}
+
+    const_iterator begin() const { return _begin; }
+    const_iterator end() const { return _end; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(_end); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(_begin); }
+
+    size_t size() const { return _end - _begin; }
+    bool empty() const { return _begin == _end; }
+
+    const Block& front() const { return *_begin; }
+    const Block& back() const { return *(_end-1); }
+    const Block& operator[]( size_t i ) const { return _begin[i]; }
+
+private:
+    const Block *_begin;
+    const Block *_end;
+};
+
+
 void getNoBlocksContigs(
 	const RefSequence &masterRef,
 	const RefSequence &slaveRef,
-	const std::list<Block> &blocks,
+	const BlockSpan &blocks,
 	boost_bitset_t &masterNBC,
 	boost_bitset_t &slaveNBC );
 
 void getNoBlocksAfterFilterContigs(
 	const RefSequence &masterRef,
 	const RefSequence &slaveRef,
-	const std::list<Block> &blocks,
+	const BlockSpan &blocks,
 	const boost_bitset_t &masterNBC,
 	const boost_bitset_t &slaveNBC,
 	boost_bitset_t &masterNBC_AF,
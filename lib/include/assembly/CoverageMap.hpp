@@ -0,0 +1,150 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \file CoverageMap.hpp
+ * \brief Definition of CoverageMap class.
+ * \details This file contains the definition of the per-base coverage of an
+ *          assembly, stored so that the coverage of any region is computed
+ *          in constant time.
+ */
+
+#ifndef COVERAGEMAP_HPP
+#define	COVERAGEMAP_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "api/BamAux.h"
+#include "types.hpp"
+
+//! Per-base coverage of the contigs of an assembly.
+/*!
+ * While reads are added, each base keeps a difference (+1 where a read
+ * starts, -1 where it ends). Once all reads have been added, differences are
+ * turned into cumulative coverages, so that the sum of the coverage over a
+ * region (i.e. the total length of the reads within it) is the difference of
+ * two values.
+ *
+ * Values take 16 or 32 bits per base. Bases are grouped in windows (64 and
+ * 1024 bases, respectively) and the exact 64-bit cumulative coverage is kept
+ * at the beginning of each window, so that only offsets inside windows are
+ * stored per base. Windows where the values do not fit (i.e. too many reads
+ * start or end, or the coverage is too high) are moved to an exact side table.
+ * Per-base values may be kept in a memory-mapped file rather than in memory.
+ */
+class CoverageMap
+{
+
+private:
+    int _width;                                     //!< bits used for each base (16 or 32).
+    int _windowBits;                                //!< logarithm of the number of bases of a window.
+    std::string _spillDir;                          //!< directory of the file backing per-base values (empty if in memory).
+
+    std::vector< uint64_t > _ctgOffset;             //!< first base of each contig in the storage (aligned to a window).
+    std::vector< int32_t > _ctgLength;              //!< contigs' length.
+
+    char *_data;                                    //!< per-base values.
+    uint64_t _dataBytes;                            //!< size of per-base values.
+    bool _mapped;                                   //!< whether per-base values are memory-mapped.
+
+    std::vector< uint32_t > _starts;                //!< reads starting in each window (while reads are added).
+    std::vector< uint32_t > _ends;                  //!< reads ending in each window (while reads are added).
+    std::vector< uint64_t > _checkpoints;           //!< exact cumulative coverage at the beginning of each window.
+    std::vector< uint8_t > _overflow;               //!< whether a window has been moved to the side table.
+    std::vector< std::map< uint64_t, std::vector< int64_t > > > _sideTable; //!< exact values of overflowed windows (per contig).
+
+    bool _finalized;                                //!< whether cumulative coverages have been computed.
+
+    inline uint64_t getValue( uint64_t pos ) const;
+    inline void setValue( uint64_t pos, uint64_t value );
+    inline int64_t getDiff( uint64_t pos ) const;
+
+    void addDiff( int32_t ctgId, int32_t pos, int64_t diff, std::vector< uint32_t > &counts );
+    uint64_t cumulative( int32_t ctgId, int32_t pos ) const;
+
+    void allocate( uint64_t bytes );
+    void release();
+
+    CoverageMap( const CoverageMap &orig );
+    CoverageMap& operator=( const CoverageMap &orig );
+
+public:
+    //! A constructor.
+    /*!
+     * \param width     bits used for each base (16 or 32)
+     * \param spillDir  directory where per-base values are memory-mapped (empty to keep them in memory)
+     */
+    CoverageMap( int width = 32, const std::string &spillDir = "" );
+
+    //! A destructor.
+    ~CoverageMap();
+
+    //! Allocates the coverage of the contigs of an assembly (initially zero).
+    /*!
+     * \param refs contigs of the assembly
+     */
+    void init( const BamTools::RefVector &refs );
+
+    //! Adds a read to the coverage.
+    /*!
+     * Reads of distinct contigs may be added concurrently.
+     * \param ctgId     contig's identifier
+     * \param startPos  starting position (0-based) of the read
+     * \param endPos    ending position (0-based) of the read (half-open interval)
+     */
+    void addRead( int32_t ctgId, int32_t startPos, int32_t endPos );
+
+    //! Computes the cumulative coverages, once every read has been added.
+    void finalize();
+
+    //! Returns the sum of the coverage over a region.
+    /*!
+     * Positions outside the contig have no coverage.
+     * \param ctgId contig's identifier
+     * \param begin first position (0-based) of the region
+     * \param end   last position (0-based) of the region
+     * \return total length of the reads' portions inside the region.
+     */
+    uint64_t getReadsLen( int32_t ctgId, int32_t begin, int32_t end ) const;
+
+    //! Returns the memory (in bytes) used by per-base values, either in memory or mapped on file.
+    uint64_t getDataSize() const;
+
+    //! Returns the number of windows moved to the side table.
+    uint64_t getOverflowWindows() const;
+
+    //! Frees the memory used by the coverage.
+    void clear();
+};
+
+#endif	/* COVERAGEMAP_HPP */
+
@@ -0,0 +1,140 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \file FastaIndex.hpp
+ * \brief Definition of FastaIndex class.
+ * \details This file contains the definition of a FASTA file indexed as
+ *          samtools faidx does, whose sequences are read on demand from
+ *          a memory mapping of the file.
+ */
+
+#ifndef FASTAINDEX_HPP
+#define	FASTAINDEX_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "assembly/contig.hpp"
+
+//! Indexed FASTA file whose sequences are loaded on demand.
+/*!
+ * The index is the \c .fai file next to the FASTA one (name, length, offset,
+ * bases and bytes per line of each sequence): it is reused when it is newer
+ * than the FASTA file, otherwise it is built by scanning the file and saved
+ * (unless the lines of a sequence have different lengths, which the index
+ * cannot describe).
+ * The FASTA file is memory-mapped and the pages of a sequence are dropped
+ * once the sequence has been parsed, so only the loaded contigs stay
+ * resident. Loaded contigs are shared and reference counted: acquire() and
+ * release() may be called concurrently.
+ */
+class FastaIndex
+{
+
+private:
+    struct Entry
+    {
+        std::string name;       //!< sequence's name.
+        uint64_t length;        //!< number of bases.
+        uint64_t offset;        //!< offset of the first base in the file.
+        uint64_t lineBases;     //!< bases per line.
+        uint64_t lineWidth;     //!< bytes per line (newline included).
+
+        Contig *ctg;            //!< loaded contig (NULL if not loaded).
+        uint32_t refs;          //!< number of acquire() not yet released.
+    };
+
+    std::string _fastaFile;                         //!< path of the FASTA file.
+    std::vector< Entry > _entries;                  //!< sequences, in file order.
+    std::map< std::string, int64_t > _ids;          //!< name => index of the sequence.
+
+    const char *_data;                              //!< memory mapping of the FASTA file.
+    uint64_t _dataBytes;                            //!< size of the FASTA file.
+
+    mutable pthread_mutex_t _mutex;                 //!< protects loaded contigs and their counters.
+
+    bool readIndex( const std::string &faiFile );
+    bool checkIndex() const;
+    void buildIndex();
+    void writeIndex( const std::string &faiFile ) const;
+
+    void unmap();
+
+    FastaIndex( const FastaIndex &orig );
+    FastaIndex& operator=( const FastaIndex &orig );
+
+public:
+    //! A constructor.
+    FastaIndex();
+
+    //! A destructor.
+    ~FastaIndex();
+
+    //! Opens a FASTA file, reading (or building) its index.
+    /*!
+     * \param fastaFile path of the FASTA file
+     * \return number of sequences in the file
+     */
+    size_t open( const std::string &fastaFile );
+
+    //! Number of sequences.
+    size_t size() const;
+
+    //! Index of a sequence.
+    /*!
+     * \param name sequence's name
+     * \return index of the sequence, or -1 if there is none with such a name
+     */
+    int64_t find( const std::string &name ) const;
+
+    //! Name of a sequence.
+    const std::string& name( int64_t id ) const;
+
+    //! Length of a sequence.
+    uint64_t length( int64_t id ) const;
+
+    //! Parses a sequence in a new contig (not shared: it must be deleted by the caller).
+    Contig* load( int64_t id ) const;
+
+    //! Gets a sequence, parsing it if it is not loaded yet.
+    /*!
+     * The contig stays loaded until each acquire() has been released.
+     */
+    const Contig& acquire( int64_t id );
+
+    //! Releases a sequence got with acquire(), deleting it when no longer used.
+    void release( int64_t id );
+};
+
+#endif	/* FASTAINDEX_HPP */
@@ -0,0 +1,105 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \file FastaWriter.hpp
+ * \brief Definition of FastaWriter class.
+ * \details This file contains the definition of a buffered writer of FASTA
+ *          files, used for the (large) output files of gam-merge.
+ */
+
+#ifndef FASTAWRITER_HPP
+#define	FASTAWRITER_HPP
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "assembly/contig.hpp"
+
+#define FASTA_WRITER_BUFFER (4 << 20)  // bytes of each output buffer
+
+//! Buffered writer of FASTA files.
+/*!
+ * Contigs are written as <tt>os << ctg << std::endl</tt> does (60 bases per
+ * line), but bases are converted to characters through a table into a large
+ * buffer, which is written with a single system call when full. When the
+ * writer is asynchronous, two buffers are used: a background thread writes
+ * one while the other is being filled.
+ */
+class FastaWriter
+{
+
+private:
+    std::string _file;                      //!< path of the output file.
+    int _fd;                                //!< descriptor of the output file (-1 when closed).
+
+    std::vector< char > _buffers[2];        //!< output buffers.
+    int _active;                            //!< buffer being filled.
+    size_t _used;                           //!< bytes used in the active buffer.
+    std::vector< uint8_t > _codes;          //!< base codes of the bases being converted.
+
+    bool _async;                            //!< whether buffers are written by a background thread.
+    pthread_t _thread;                      //!< background writer.
+    pthread_mutex_t _mutex;                 //!< protects the fields below.
+    pthread_cond_t _cond;                   //!< signals a buffer to write, a buffer written or the end of the output.
+    bool _pending;                          //!< whether the inactive buffer is waiting to be (or being) written.
+    size_t _pendingBytes;                   //!< bytes of the inactive buffer to write.
+    bool _done;                             //!< whether no more buffers will be handed to the background writer.
+
+    void append( const char *data, size_t bytes );
+    void flushBuffer();
+    void writeBytes( const char *data, size_t bytes ) const;
+
+    static void* writerThread( void *arg );
+
+    FastaWriter( const FastaWriter &orig );
+    FastaWriter& operator=( const FastaWriter &orig );
+
+public:
+    //! A constructor (creates or truncates the output file).
+    /*!
+     * \param file  path of the output file
+     * \param async whether buffers are written by a background thread
+     */
+    FastaWriter( const std::string &file, bool async = false );
+
+    //! A destructor (closes the file, if still open).
+    ~FastaWriter();
+
+    //! Appends a contig to the file.
+    void write( const Contig &ctg );
+
+    //! Writes the buffered data and closes the file.
+    void close();
+};
+
+#endif	/* FASTAWRITER_HPP */
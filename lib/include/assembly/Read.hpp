@@ -43,10 +43,11 @@
 #include "bam/MultiBamReader.hpp"
 
 #include "types.hpp"
-#include "google/sparse_hash_map"
 
 using namespace BamTools;
-using google::sparse_hash_map;
+
+class ReadMap;
+class CoverageMap;
 
 //! Class implementing a read.
 class Read
@@ -69,6 +70,14 @@ public:
      */
     Read(const Read &orig);
 
+    //! Assignment operator.
+    /*!
+     * Copies a read.
+     * \param orig a Read object.
+     * \return this read.
+     */
+    Read& operator=(const Read &orig);
+
     //! A constructor which sets the read's attributes.
     /*!
      * \param ctg       contig's identifier
@@ -106,7 +115,7 @@ public:
     /*!
      * \return \c true if the read is reverse complemented, \c false otherwise.
      */
-    bool isReverse();
+    bool isReverse() const;
 
     bool overlaps( Read &read, int minOverlap = 0 ) const;
 
@@ -115,19 +124,15 @@ public:
      * Reads with multiple alignments or unmapped are discarded.
      *
      * \param bamReader BamReader object.
-     * \param readMap_1 map where the first uniquely mapped pairs are loaded (output)
-	 * \param readMap_2 map where the second uniquely mapped pairs are loaded (output)
-     * \param coverage vector of coverages of the contigs (output)
-	 * \param dupReadMap_1 map where the first mutiple mapped pairs are loaded (output)
-	 * \param dupReadMap_2 map where the second mutiple mapped pairs are loaded (output)
-	 * \param loadDupReads whether duplicate reads maps should be filled
+     * \param readMap map where the uniquely mapped reads (both mates) are loaded (output)
+     * \param coverage coverage of the contigs (output)
+	 * \param noMultFilter whether reads should be processed as if they had unique mapping
 	 *
      */
     static void loadReadsMap(
         MultiBamReader &bamReader,
-        sparse_hash_map< std::string, Read > &readMap_1,
-        sparse_hash_map< std::string, Read > &readMap_2,
-        std::vector< std::vector<uint32_t> > &coverage,
+        ReadMap &readMap,
+        CoverageMap &coverage,
         bool noMultFilter = false
 	);
 };
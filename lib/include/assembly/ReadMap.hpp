@@ -0,0 +1,169 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \file ReadMap.hpp
+ * \brief Definition of ReadMap class.
+ * \details This file contains the definition of a compact hash table which
+ *          indexes uniquely mapped reads by a fingerprint of their name.
+ */
+
+#ifndef READMAP_HPP
+#define	READMAP_HPP
+
+#include <string>
+#include <vector>
+
+#include "assembly/Read.hpp"
+#include "types.hpp"
+
+//! Open-addressing table of reads, indexed by 64-bit fingerprints of their names.
+/*!
+ * Both mates of a pair share the same slot, so each read name is hashed and
+ * stored only once. A secondary 32-bit hash of the name is kept to detect
+ * fingerprint collisions: colliding names are dropped from the table, as if
+ * they were reads with multiple alignments.
+ */
+class ReadMap
+{
+
+private:
+    //! Read coordinates packed in 12 bytes.
+    struct PackedRead
+    {
+        int32_t  contigId;  //!< contig's identifier (-1 if the mate is missing).
+        int32_t  startPos;  //!< starting position (0-based) inside the contig.
+        uint32_t lenRev;    //!< read's length shifted by one, ORed with the reverse flag.
+    };
+
+    //! Table's slot, holding both the mates of a read.
+    struct Slot
+    {
+        uint64_t   key;         //!< fingerprint of the read name (0 if the slot is empty).
+        uint32_t   check;       //!< secondary hash used to detect collisions.
+        uint32_t   collided;    //!< whether two different names share the fingerprint.
+        PackedRead mate[2];     //!< first and second mate of the read.
+    };
+
+    std::vector< Slot > _slots;    //!< slots of the table (size is a power of 2).
+    uint64_t _mask;                 //!< _slots.size()-1
+    uint64_t _keys;                 //!< number of used slots.
+    uint64_t _reads;                //!< number of reads stored.
+    uint64_t _collisions;           //!< number of fingerprint collisions detected.
+
+    static Slot emptySlot();
+
+    uint64_t findSlot( uint64_t key ) const;
+    void grow();
+
+public:
+    //! A constructor which reserves space for a given number of reads.
+    /*!
+     * \param expected number of read names expected to be inserted
+     */
+    ReadMap( uint64_t expected = 0 );
+
+    //! Computes the fingerprint of a read name.
+    /*!
+     * \param name  read's name
+     * \param key   64-bit fingerprint used to index the read (output)
+     * \param check secondary hash used to detect collisions (output)
+     */
+    static void fingerprint( const std::string &name, uint64_t &key, uint32_t &check );
+
+    //! Inserts (or replaces) a mate of a read.
+    /*!
+     * \param name  read's name
+     * \param mate  0 for unpaired reads and first mates, 1 for second mates
+     * \param read  read's coordinates
+     */
+    void insert( const std::string &name, int mate, const Read &read );
+
+    //! Retrieves a mate of a read.
+    /*!
+     * \param name  read's name
+     * \param mate  0 for unpaired reads and first mates, 1 for second mates
+     * \param read  read's coordinates (output)
+     * \return \c true if the read has been found, \c false otherwise.
+     */
+    bool find( const std::string &name, int mate, Read &read ) const;
+
+    //! Retrieves a mate of a read, given the fingerprint of its name.
+    /*!
+     * \param key   64-bit fingerprint of the read's name
+     * \param check secondary hash of the read's name
+     * \param mate  0 for unpaired reads and first mates, 1 for second mates
+     * \param read  read's coordinates (output)
+     * \return \c true if the read has been found, \c false otherwise.
+     */
+    bool find( uint64_t key, uint32_t check, int mate, Read &read ) const;
+
+    //! Removes every read and frees the memory used by the table.
+    void clear();
+
+    //! Returns the number of reads stored.
+    uint64_t size() const;
+
+    //! Returns the number of fingerprint collisions detected.
+    uint64_t getCollisions() const;
+
+    //! Returns the memory (in bytes) used by the table.
+    uint64_t getMemoryUsage() const;
+};
+
+
+//! A read identified by the fingerprint of its name, packed in 24 bytes.
+/*!
+ * Used to buffer slave's reads until master's reads are available.
+ */
+struct KeyedRead
+{
+    uint64_t key;       //!< 64-bit fingerprint of the read's name.
+    uint32_t check;     //!< secondary hash of the read's name.
+    int32_t  contigId;  //!< contig's identifier.
+    int32_t  startPos;  //!< starting position (0-based) inside the contig.
+    uint32_t lenFlags;  //!< read's length shifted by two, ORed with mate (bit 1) and reverse (bit 0) flags.
+
+    KeyedRead() : key(0), check(0), contigId(0), startPos(0), lenFlags(0) {}
+
+    KeyedRead( const std::string &name, int mate, const Read &read ) :
+        contigId(read.getContigId()), startPos(read.getStartPos()),
+        lenFlags( (uint32_t(read.getLength()) << 2) | (mate ? 2 : 0) | (read.isReverse() ? 1 : 0) )
+    {
+        ReadMap::fingerprint( name, key, check );
+    }
+
+    int getMate() const { return (lenFlags >> 1) & 1; }
+
+    Read getRead() const { return Read( contigId, startPos, startPos + int32_t(lenFlags >> 2), (lenFlags & 1) != 0 ); }
+};
+
+#endif	/* READMAP_HPP */
+
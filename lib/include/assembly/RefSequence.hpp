@@ -32,11 +32,13 @@
 #define REFSEQUENCE_HPP_
 
 #include "assembly/contig.hpp"
+#include "assembly/FastaIndex.hpp"
 
 struct reference_t {
 	std::string RefName;
 	int32_t RefLength;
-	Contig *Sequence;
+	FastaIndex *Fasta;  //!< indexed FASTA file the sequence is loaded from.
+	int64_t FastaId;    //!< index of the sequence in Fasta.
 };
 
 typedef std::vector< reference_t > RefSequence;
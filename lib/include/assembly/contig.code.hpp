@@ -37,52 +37,251 @@
 #include<sstream>
 #include<ios>
 #include <stdexcept>
+#include <algorithm>
+
+#define CONTIG_BASES_PER_WORD 32
+#define CONTIG_WORDS(size) (((size)+CONTIG_BASES_PER_WORD-1)/CONTIG_BASES_PER_WORD)
+
+NucleotideRef::operator Nucleotide() const
+{
+  return Nucleotide(this->_ctg->base(this->_pos));
+}
+
+BaseType
+NucleotideRef::base() const
+{
+  return this->_ctg->base(this->_pos);
+}
+
+NucleotideRef&
+NucleotideRef::operator=(const Nucleotide& base)
+{
+  this->_ctg->set_base(this->_pos, base.base());
+
+  return *this;
+}
+
+NucleotideRef&
+NucleotideRef::operator=(const char base)
+{
+  this->_ctg->set_base(this->_pos, Nucleotide(base).base());
+
+  return *this;
+}
+
+NucleotideRef&
+NucleotideRef::operator=(const NucleotideRef& orig)
+{
+  this->_ctg->set_base(this->_pos, orig.base());
+
+  return *this;
+}
+
+bool
+NucleotideRef::operator==(const Nucleotide& base) const
+{
+  return this->base() == base.base();
+}
+
+bool
+NucleotideRef::operator!=(const Nucleotide& base) const
+{
+  return this->base() != base.base();
+}
+
+// clears the 2-bit codes of the bases in [begin,end)
+static void
+clear_codes(std::vector<uint64_t>& bases, size_t begin, size_t end)
+{
+  while (begin < end) {
+    size_t word=begin/CONTIG_BASES_PER_WORD;
+    size_t first=begin%CONTIG_BASES_PER_WORD;
+    size_t last=std::min(end-word*CONTIG_BASES_PER_WORD,
+                         (size_t)CONTIG_BASES_PER_WORD);
+    uint64_t mask=(last-first==CONTIG_BASES_PER_WORD) ? ~0ULL :
+                        (((1ULL << (2*(last-first)))-1) << (2*first));
+
+    bases[word] &= ~mask;
+    begin=word*CONTIG_BASES_PER_WORD+last;
+  }
+}
+
+// first run of N starting after index
+static std::vector< std::pair<size_t,size_t> >::iterator
+next_n_run(std::vector< std::pair<size_t,size_t> >& runs, const size_t& index)
+{
+  return std::upper_bound(runs.begin(), runs.end(),
+                          std::make_pair(index, (size_t)-1));
+}
+
+static std::vector< std::pair<size_t,size_t> >::const_iterator
+next_n_run(const std::vector< std::pair<size_t,size_t> >& runs, const size_t& index)
+{
+  return std::upper_bound(runs.begin(), runs.end(),
+                          std::make_pair(index, (size_t)-1));
+}
+
+bool
+Contig::is_n(const size_t& index) const
+{
+  std::vector<NRunType>::const_iterator it=next_n_run(this->_n_runs, index);
+
+  if (it == this->_n_runs.begin()) return false;
+  --it;
+
+  return index < it->second;
+}
+
+void
+Contig::add_n(const size_t& index)
+{
+  // sequences are mostly written from left to right
+  if (this->_n_runs.empty() || this->_n_runs.back().second < index) {
+    this->_n_runs.push_back(NRunType(index, index+1));
+    return;
+  }
+  if (this->_n_runs.back().second == index) {
+    this->_n_runs.back().second++;
+    return;
+  }
+
+  std::vector<NRunType>::iterator next=next_n_run(this->_n_runs, index);
+  bool join_prev=false, join_next=(next != this->_n_runs.end() && next->first == index+1);
+
+  if (next != this->_n_runs.begin()) {
+    std::vector<NRunType>::iterator prev=next-1;
+    if (index < prev->second) return;
+    join_prev=(prev->second == index);
+  }
+
+  if (join_prev && join_next) {
+    (next-1)->second=next->second;
+    this->_n_runs.erase(next);
+  } else if (join_prev) {
+    (next-1)->second++;
+  } else if (join_next) {
+    next->first--;
+  } else {
+    this->_n_runs.insert(next, NRunType(index, index+1));
+  }
+}
+
+void
+Contig::remove_n(const size_t& index)
+{
+  if (this->_n_runs.empty() || this->_n_runs.back().second <= index) return;
+
+  std::vector<NRunType>::iterator run=next_n_run(this->_n_runs, index);
+
+  if (run == this->_n_runs.begin()) return;
+  --run;
+  if (index >= run->second) return;
+
+  if (run->first == index) {
+    if (++(run->first) == run->second) this->_n_runs.erase(run);
+  } else if (run->second == index+1) {
+    run->second--;
+  } else {
+    NRunType tail(index+1, run->second);
+    run->second=index;
+    this->_n_runs.insert(run+1, tail);
+  }
+}
+
+void
+Contig::clear_n_codes()
+{
+  for (std::vector<NRunType>::const_iterator it=this->_n_runs.begin();
+                                             it!=this->_n_runs.end(); it++) {
+    clear_codes(this->_bases, it->first, it->second);
+  }
+
+  // padding of the last word
+  clear_codes(this->_bases, this->_size,
+              this->_bases.size()*CONTIG_BASES_PER_WORD);
+}
 
 size_t
 Contig::resize(const size_t& size)
 {
-(this->_sequence).resize(size);
-//(this->_quality).resize(size);
+  size_t old_size=this->_size;
+
+  this->_size=size;
+  this->_bases.resize(CONTIG_WORDS(size), 0);
+
+  if (size < old_size) {
+    while (!this->_n_runs.empty() && this->_n_runs.back().first >= size) {
+      this->_n_runs.pop_back();
+    }
+    if (!this->_n_runs.empty() && this->_n_runs.back().second > size) {
+      this->_n_runs.back().second=size;
+    }
+    clear_codes(this->_bases, size, this->_bases.size()*CONTIG_BASES_PER_WORD);
+  } else if (size > old_size) {
+    // new bases are N
+    if (!this->_n_runs.empty() && this->_n_runs.back().second == old_size) {
+      this->_n_runs.back().second=size;
+    } else {
+      this->_n_runs.push_back(NRunType(old_size, size));
+    }
+  }
+  //(this->_quality).resize(size);
 
-return this->size();
+  return this->size();
 }
 
-Contig::Contig(): _name(""), _sequence(0) {} //, _quality(0) {}
+Contig::Contig(): _name(""), _size(0), _bases(0), _n_runs(0) {} //, _quality(0) {}
 
-Contig::Contig(const Contig& orig): _name(orig._name),
-                            _sequence(orig._sequence) {}
+Contig::Contig(const Contig& orig): _name(orig._name), _size(orig._size),
+                            _bases(orig._bases), _n_runs(orig._n_runs) {}
                             //_quality(orig._quality) {}
 
 Contig::Contig(const std::string &name): _name(name),
-                            _sequence(0) {} //, _quality(0) {}
+                            _size(0), _bases(0), _n_runs(0) {} //, _quality(0) {}
 
 Contig::Contig(const std::string &name, const SeqType &sequence,
                                         const QualSeqType &quality):
-                                    _name(name), _sequence(sequence) {}
+                                    _name(name), _size(0), _bases(0), _n_runs(0)
                                                  // _quality(quality)
-//{
+{
+  this->_size=sequence.size();
+  this->_bases.resize(CONTIG_WORDS(this->_size), 0);
+
+  for (size_t i=0; i<sequence.size(); i++) {
+    this->set_base(i, sequence[i].base());
+  }
 //  if (_quality.size() != _sequence.size()) {
 //    std::stringstream s;
 //    s << "Sequence size does not match quality "<<
 //                                "sequence size for \""<< name <<"\".";
 //    throw std::logic_error(s.str());
 //  }
-//}
+}
 
 Contig::Contig(const std::string &name, const SeqType &sequence):
-               _name(name), _sequence(sequence) {} //, _quality(sequence.size())
-//{
+               _name(name), _size(sequence.size()),
+               _bases(CONTIG_WORDS(sequence.size()), 0), _n_runs(0) //, _quality(sequence.size())
+{
+  for (size_t i=0; i<sequence.size(); i++) {
+    this->set_base(i, sequence[i].base());
+  }
 //  for (QualSeqType::iterator i=this->_quality.begin();
 //                             i!=this->_quality.end(); i++) {
 //    *i=100;
 //  }
-//}
+}
 
 Contig::Contig(const std::string &name, const size_t& size):
-       _name(name), _sequence(size) {} //, _quality(size) {}
+       _name(name), _size(0), _bases(0), _n_runs(0) //, _quality(size) {}
+{
+  this->resize(size);
+}
 
 Contig::Contig(const size_t& size):
-       _name(), _sequence(size) {} //, _quality(size) {}
+       _name(), _size(0), _bases(0), _n_runs(0) //, _quality(size) {}
+{
+  this->resize(size);
+}
 
 const std::string &
 Contig::name() const { return this->_name; }
@@ -97,13 +296,15 @@ Contig::set_name(const std::string& new_name)
 
 size_t
 Contig::size() const
-{ return (this->_sequence).size(); }
+{ return this->_size; }
 
 const Contig&
 Contig::operator=(const Contig& orig)
 {
   this->_name=orig._name;
-  this->_sequence=orig._sequence;
+  this->_size=orig._size;
+  this->_bases=orig._bases;
+  this->_n_runs=orig._n_runs;
   //this->_quality=orig._quality;
 
   return *this;
@@ -112,7 +313,8 @@ Contig::operator=(const Contig& orig)
 bool
 Contig::operator==(const Contig& ctg) const
 {
-   if (_sequence!=ctg._sequence)
+   // N codes and padding are always cleared: packed words can be compared
+   if (_size!=ctg._size || _bases!=ctg._bases || _n_runs!=ctg._n_runs)
      return false;
 
    // if (_quality!=ctg._quality) return false;
@@ -126,28 +328,103 @@ Contig::operator!=(const Contig& ctg) const
   return !(*this==ctg);
 }
 
-const Nucleotide&
+void
+Contig::set_base(const size_t& index, const BaseType base)
+{
+  uint64_t& word=this->_bases[index/CONTIG_BASES_PER_WORD];
+  unsigned int shift=2*(index%CONTIG_BASES_PER_WORD);
+
+  word &= ~(3ULL << shift);
+
+  if (base == N || base == LAST_BASE) {
+    this->add_n(index);
+  } else {
+    word |= ((uint64_t)base) << shift;
+    this->remove_n(index);
+  }
+}
+
+Nucleotide
 Contig::operator[](const size_t& index) const
 {
-  return this->_sequence[index];
+  return Nucleotide(this->base(index));
 }
 
-Nucleotide&
+NucleotideRef
 Contig::operator[](const size_t& index)
 {
-  return this->_sequence[index];
+  return NucleotideRef(this, index);
 }
 
-const Nucleotide&
+Nucleotide
 Contig::at(const size_t& index) const
 {
-  return this->_sequence.at(index);
+  if (index >= this->_size) {
+    throw std::out_of_range("Contig::at");
+  }
+
+  return Nucleotide(this->base(index));
 }
 
-Nucleotide&
+NucleotideRef
 Contig::at(const size_t& index)
 {
-  return this->_sequence.at(index);
+  if (index >= this->_size) {
+    throw std::out_of_range("Contig::at");
+  }
+
+  return NucleotideRef(this, index);
+}
+
+void
+Contig::codes(const size_t& index, const size_t& length, uint8_t* out) const
+{
+  for (size_t i=0; i<length; i++) {
+    out[i]=this->code(index+i);
+  }
+
+  std::vector<NRunType>::const_iterator run=next_n_run(this->_n_runs, index);
+  if (run != this->_n_runs.begin()) --run;
+
+  for (; run!=this->_n_runs.end() && run->first<index+length; run++) {
+    for (size_t i=std::max(run->first,index);
+                i<std::min(run->second,index+length); i++) {
+      out[i-index]=N;
+    }
+  }
+}
+
+uint64_t
+Contig::word(const size_t& index, const size_t& length) const
+{
+  if (length == 0) return 0;
+
+  size_t w=index/CONTIG_BASES_PER_WORD;
+  unsigned int shift=2*(index%CONTIG_BASES_PER_WORD);
+  uint64_t x=this->_bases[w] >> shift;
+
+  if (shift != 0 && w+1 < this->_bases.size()) {
+    x |= this->_bases[w+1] << (64-shift);
+  }
+
+  // the first base goes from the lowest to the highest bits
+  x=((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+  x=((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+  x=__builtin_bswap64(x);
+
+  return x >> (64-2*length);
+}
+
+bool
+Contig::has_n(const size_t& index, const size_t& length) const
+{
+  if (length == 0) return false;
+
+  std::vector<NRunType>::const_iterator run=next_n_run(this->_n_runs, index);
+
+  if (run != this->_n_runs.begin() && index < (run-1)->second) return true;
+
+  return run != this->_n_runs.end() && run->first < index+length;
 }
 
 //const QualType&
@@ -178,7 +455,7 @@ Contig::sequence(const size_t& index, const size_t& length) const
   SeqType out_seq(length);
 
   for (size_t i=index; i<index+length; i++) {
-    out_seq.at(i)=this->_sequence.at(i);
+    out_seq.at(i-index)=Nucleotide(this->base(i));
   }
 
   return out_seq;
@@ -190,18 +467,22 @@ reverse(Contig& ctg)
   //QualSeqType quality(ctg.size());
   if( ctg.size() == 0 ) return ctg;
 
-  unsigned int i = 0, j = ctg.size()-1;
-  Nucleotide temp;
-
   ctg.set_name( "Reversed "+ctg.name() );
-  while( i < j )
-  {
-      temp = ctg.at(i);
-      ctg.at(i) = ctg.at(j);
-      ctg.at(j) = temp;
-      i++;
-      j--;
+
+  std::vector<uint64_t> bases(ctg._bases.size(), 0);
+  for (size_t i=0, j=ctg.size()-1; i<ctg.size(); i++, j--) {
+    bases[i/CONTIG_BASES_PER_WORD] |=
+            ((uint64_t)ctg.code(j)) << (2*(i%CONTIG_BASES_PER_WORD));
+  }
+  ctg._bases.swap(bases);
+
+  std::vector<Contig::NRunType> n_runs;
+  n_runs.reserve(ctg._n_runs.size());
+  for (std::vector<Contig::NRunType>::reverse_iterator it=ctg._n_runs.rbegin();
+                                                 it!=ctg._n_runs.rend(); it++) {
+    n_runs.push_back(Contig::NRunType(ctg.size()-it->second, ctg.size()-it->first));
   }
+  ctg._n_runs.swap(n_runs);
 
   return ctg;
   //return Contig(name,sequence); //return Contig(name,sequence,quality);
@@ -213,10 +494,11 @@ complement(Contig& ctg)
   //SeqType sequence(ctg.size());
   //QualSeqType quality(ctg.size());
 
-  for (unsigned int i=0; i< ctg.size(); i++) {
-    ctg.at(i)=complement(ctg.at(i));
-    //quality.at(i)=ctg.qual(i);
+  // A<->T and C<->G flip the lowest bit of the code
+  for (size_t i=0; i<ctg._bases.size(); i++) {
+    ctg._bases[i] ^= 0x5555555555555555ULL;
   }
+  ctg.clear_n_codes();
 
   return ctg;
   //return Contig(ctg.name(),sequence); //return Contig(name,sequence,quality);
@@ -31,7 +31,9 @@
 #ifndef CONTIGHPP_
 #define CONTIGHPP_
 
+#include <stdint.h>
 #include<string>
+#include<utility>
 #include<vector>
 
 #include "assembly/nucleotide.hpp"
@@ -47,12 +49,61 @@ std::istream& operator>>(std::istream&, Contig&);
 Contig read_contig(const std::string&, const std::string&,
                                         const std::string&);
 
+//! Reference to a base of a Contig, which keeps its bases packed.
+class NucleotideRef
+{
+ private:
+  Contig* _ctg;
+  size_t _pos;
+
+ public:
+  NucleotideRef(Contig* ctg, size_t pos): _ctg(ctg), _pos(pos) {}
+
+  operator Nucleotide() const;
+
+  BaseType base() const;
+
+  NucleotideRef& operator=(const Nucleotide& base);
+
+  NucleotideRef& operator=(const char base);
+
+  NucleotideRef& operator=(const NucleotideRef& orig);
+
+  bool operator==(const Nucleotide& base) const;
+
+  bool operator!=(const Nucleotide& base) const;
+};
+
+/*! \brief Named sequence of nucleotides.
+ *
+ * Bases are packed 2 bits each, 32 in a 64-bit word (N is stored as A), and
+ * the runs of N are kept apart in a sorted list: a contig takes about a
+ * quarter of the memory of a vector of Nucleotide. Elements are returned by
+ * value (or through a NucleotideRef when writable).
+ */
 class Contig {
  private:
+  typedef std::pair<size_t,size_t> NRunType; //!< [begin,end) positions of a run of N
+
   std::string _name;
-  SeqType _sequence;
+  size_t _size;
+  std::vector<uint64_t> _bases;  //!< 2-bit codes of the bases (the code of A where there is an N)
+  std::vector<NRunType> _n_runs; //!< sorted, disjoint and non-adjacent runs of N
   //QualSeqType _quality;
 
+  inline BaseType code(const size_t& index) const
+  {
+    return BaseType( (this->_bases[index >> 5] >> ((index & 31) << 1)) & 3 );
+  }
+
+  bool is_n(const size_t& index) const;
+
+  void add_n(const size_t& index);
+
+  void remove_n(const size_t& index);
+
+  void clear_n_codes();
+
  protected:
 
 
@@ -84,13 +135,29 @@ class Contig {
 
   bool operator!=(const Contig& ctg) const;
 
-  const Nucleotide& operator[](const size_t& index) const;
+  inline BaseType base(const size_t& index) const
+  {
+    return (!this->_n_runs.empty() && this->is_n(index)) ? N : this->code(index);
+  }
 
-  Nucleotide& operator[](const size_t& index);
+  void set_base(const size_t& index, const BaseType base);
 
-  const Nucleotide& at(const size_t& index) const;
+  Nucleotide operator[](const size_t& index) const;
 
-  Nucleotide& at(const size_t& index);
+  NucleotideRef operator[](const size_t& index);
+
+  Nucleotide at(const size_t& index) const;
+
+  NucleotideRef at(const size_t& index);
+
+  //! Base codes (N included) of the bases from index to index+length-1.
+  void codes(const size_t& index, const size_t& length, uint8_t* out) const;
+
+  //! Packed word of length <= 32 bases starting at index, 2 bits per base with the first one in the highest bits (N as A).
+  uint64_t word(const size_t& index, const size_t& length) const;
+
+  //! Tells whether there is an N from index to index+length-1.
+  bool has_n(const size_t& index, const size_t& length) const;
 
   //const QualType& qual(const size_t& index) const;
 
@@ -102,6 +169,9 @@ class Contig {
 
   size_t resize(const size_t& size);
 
+  friend Contig& reverse(Contig& ctg);
+  friend Contig& complement(Contig& ctg);
+
   friend std::istream& operator>>(std::istream&, Contig&);
   friend Contig read_contig(const std::string&, const std::string&,
                                                         const std::string&);
@@ -0,0 +1,136 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CONTIG_VIEW_HPP_
+#define CONTIG_VIEW_HPP_
+
+#include <stdint.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "assembly/contig.hpp"
+
+/*! \brief Read-only window on a Contig, possibly reverse complemented.
+ *
+ * A view stores a pointer to the contig, the window [offset,offset+length)
+ * and the strand: it is copied, narrowed and flipped in constant time,
+ * without touching the bases. The viewed contig must outlive the view.
+ */
+class ContigView
+{
+ private:
+  const Contig* _ctg;
+  size_t _offset;
+  size_t _length;
+  bool _reversed;
+
+  //! position in the contig of the i-th base of the view
+  inline size_t position(const size_t& index) const
+  {
+    return this->_reversed ? this->_offset + this->_length - 1 - index : this->_offset + index;
+  }
+
+ public:
+  //! A view of the whole contig (implicit, so that a Contig can be passed where a view is expected).
+  ContigView(const Contig& ctg, bool reversed = false):
+    _ctg(&ctg), _offset(0), _length(ctg.size()), _reversed(reversed) {}
+
+  //! A view of ctg[offset..offset+length-1].
+  ContigView(const Contig& ctg, size_t offset, size_t length, bool reversed = false):
+    _ctg(&ctg), _offset(offset), _length(length), _reversed(reversed)
+  {
+    if (offset + length > ctg.size()) {
+      throw std::out_of_range("ContigView: the contig has not so many bases.");
+    }
+  }
+
+  inline const Contig& contig() const { return *(this->_ctg); }
+
+  inline const std::string& name() const { return this->_ctg->name(); }
+
+  inline size_t size() const { return this->_length; }
+
+  inline bool is_reversed() const { return this->_reversed; }
+
+  inline BaseType base(const size_t& index) const
+  {
+    BaseType b = this->_ctg->base(this->position(index));
+    return (this->_reversed && b < N) ? BaseType(b ^ 1) : b;
+  }
+
+  inline Nucleotide operator[](const size_t& index) const
+  {
+    return Nucleotide(this->base(index));
+  }
+
+  inline Nucleotide at(const size_t& index) const
+  {
+    if (index >= this->_length) {
+      throw std::out_of_range("ContigView::at");
+    }
+
+    return Nucleotide(this->base(index));
+  }
+
+  //! Base codes (N included) of the bases from index to index+length-1.
+  void codes(const size_t& index, const size_t& length, uint8_t* out) const
+  {
+    if (!this->_reversed) {
+      this->_ctg->codes(this->_offset + index, length, out);
+      return;
+    }
+
+    this->_ctg->codes(this->position(index + length - 1), length, out);
+    std::reverse(out, out + length);
+    for (size_t i = 0; i < length; i++) {
+      if (out[i] < N) out[i] ^= 1;
+    }
+  }
+
+  //! Reverse complements the view in place.
+  inline ContigView& reverse_complement()
+  {
+    this->_reversed = !this->_reversed;
+    return *this;
+  }
+
+  //! The view of the bases from index to index+length-1 of this view.
+  ContigView sub_view(const size_t& index, const size_t& length) const
+  {
+    if (index + length > this->_length) {
+      throw std::out_of_range("ContigView: the view has not so many bases.");
+    }
+
+    size_t offset = this->_reversed ? this->_offset + this->_length - index - length : this->_offset + index;
+    return ContigView(*(this->_ctg), offset, length, this->_reversed);
+  }
+};
+
+#endif // CONTIG_VIEW_HPP_
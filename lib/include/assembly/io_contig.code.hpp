@@ -31,6 +31,7 @@
 #ifndef _IO_CONTIG_CODE_
 #define _IO_CONTIG_CODE_
 
+#include<cstdlib>
 #include<iostream>
 #include<fstream>
 #include<sstream>
@@ -44,7 +45,6 @@
 
 #include "assembly/io_contig.hpp"
 
-#define BUFFER_LEN 16384
 
 QualSeqType
 read_quality(const std::string& filename, const std::string& name)
@@ -210,7 +210,7 @@ read_contig_in(const std::string& name, const std::string& dir)
 std::istream& operator>>(std::istream& is, Contig& ctg)
 {
   std::string line;
-  ctg._sequence.resize(0);
+  ctg.resize(0);
 
   // get name
   getline(is, line);
@@ -237,8 +237,8 @@ std::istream& operator>>(std::istream& is, Contig& ctg)
   }
   */
 
-  ctg._sequence=read_sequence(is);
-  //ctg._quality.resize( ctg._sequence.size() );
+  ctg=Contig(ctg._name, read_sequence(is));
+  //ctg._quality.resize( ctg.size() );
 
   return is;
 }
@@ -247,15 +247,18 @@ std::ostream& operator<<(std::ostream& os, const Contig& ctg)
 {
   os << ">" << ctg.name();
 
+  // whole lines are written at once (and the stream is not flushed at each one)
+  char line[SEQ_LINE_LENGTH+1];
+
   size_t i=0;
   while (i<ctg.size()) {
-    os << std::endl;
     size_t j=0;
-    while ((i<ctg.size())&&(j<SEQ_LINE_LENGTH)) {
-      os << ctg.at(i);
+    line[j++]='\n';
+    while ((i<ctg.size())&&(j<=SEQ_LINE_LENGTH)) {
+      line[j++]=char(ctg[i]);
       i++;
-      j++;
     }
+    os.write(line, j);
   }
 
   return os;
@@ -565,33 +568,33 @@ void readNextSequence( std::istream &is, Contig &ctg )
 
 
 
+// sequences are not loaded: each one is bound to its record in the indexed FASTA
+// file, from which it is read on demand. Returns the number of sequences found.
 size_t
-loadSequences( const std::string &file, RefSequence &refSequence, const std::map< std::string, int32_t > &ctg2Id )
+indexSequences( const std::string &file, FastaIndex &fasta, RefSequence &refSequence )
 {
-	std::ifstream ifs( file.c_str(), std::ifstream::in );
+	fasta.open( file );
 
-	char buffer[BUFFER_LEN];
-	ifs.rdbuf()->pubsetbuf( buffer, BUFFER_LEN );
-	
 	size_t num = 0;
 
-	while( !ifs.eof() )
+	for( size_t i = 0; i < refSequence.size(); i++ )
 	{
-		std::string ctg_name;
-		readNextContigID( ifs, ctg_name );
+		refSequence[i].Fasta = &fasta;
+		refSequence[i].FastaId = fasta.find( refSequence[i].RefName );
 
-		std::map< std::string, int32_t >::const_iterator it = ctg2Id.find( ctg_name );
+		if( refSequence[i].FastaId < 0 ) continue;
 
-		Contig *ctg = new Contig( ctg_name, refSequence[it->second].RefLength );
-		readNextSequence( ifs, *ctg );
+		// sequences are no longer sized by the BAM headers: their lengths have to agree
+		if( fasta.length( refSequence[i].FastaId ) != uint64_t( refSequence[i].RefLength ) )
+		{
+			std::cerr << "[error] sequence \"" << refSequence[i].RefName << "\" has " << fasta.length( refSequence[i].FastaId )
+			          << " bases in FASTA file \"" << file << "\", but " << refSequence[i].RefLength << " in BAM header" << std::endl;
+			exit(1);
+		}
 
-		refSequence[it->second].Sequence = ctg;
-		
 		++num;
 	}
 
-	ifs.close();
-	
 	return num;
 }
 
@@ -35,8 +35,6 @@
 #include <vector>
 #include <exception>
 
-#include <pthread.h>
-
 #include "api/BamAux.h"
 #include "api/BamReader.h"
 #include "api/BamAlignment.h"
@@ -70,8 +68,6 @@ private:
     std::vector< BamAlignment > _bam_aligns; 	// Next alignment to be processed for each reader
     std::vector< bool > _valid_aligns;			// Whether an alignment is valid (to be processed)
 
-    std::vector< pthread_mutex_t > _bam_mutex;	// mutexes associated to each BAM reader
-
     std::vector< int32_t > _minInsert;			// min insert size to compute mean/std
     std::vector< int32_t > _maxInsert;			// max insert size to compute mean/std
 
@@ -89,13 +85,16 @@ public:
 
     bool Open( const std::vector< std::string > &filenames );
     bool Open( const std::string &filename );
+    bool OpenCopy( const MultiBamReader &other );
     void Close();
 
+    inline bool isOpen() const { return this->_is_open; }
     inline uint32_t size() const { return (this->_bam_readers).size(); }
 	inline BamReader& at( const size_t &index ) const { return *(this->_bam_readers.at(index)); }
     inline BamReader& operator[]( const size_t &index ) const { return *(this->_bam_readers[index]); }
 
 	void setMinMaxInsertSizes( const std::vector<int32_t> &minInsert, const std::vector<int32_t> &maxInsert );
+	void setDecompressThreads( int threads );
 
     BamReader* getBamReader( uint32_t idx );
     double getISizeMean( uint32_t idx );
@@ -106,14 +105,12 @@ public:
     double getMeanCoverage();
     double getGlobCoverage();
 
-    void lockBamReader( uint32_t idx );
-    void unlockBamReader( uint32_t idx );
-
     bool Rewind();
     bool Jump( uint32_t refID, uint32_t position = 0 );
     bool SetRegion ( const uint32_t &leftRefID, const uint32_t &leftPosition, const uint32_t &rightRefID, const uint32_t &rightPosition );
 
     bool computeStatistics();
+    void mergeStats( const MultiBamReader &other );
 
     bool GetNextAlignment( BamAlignment &align, bool update_stats = false );
     const RefVector& GetReferenceData() const;
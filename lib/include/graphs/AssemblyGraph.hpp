@@ -41,44 +41,24 @@
 #include <iostream>
 #include <iomanip>
 
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/strong_components.hpp>
-#include <boost/graph/topological_sort.hpp>
 //#include <boost/graph/graphviz.hpp>
 
 #include "assembly/Block.hpp"
+#include "graphs/CsrGraph.hpp"
 #include "OrderingFunctions.hpp"
 #include "strand_fixer/RelativeStrand.hpp"
 #include "strand_fixer/StrandProbability.hpp"
 
-namespace boost
-{
-    enum edge_kind_t { edge_kind };
-    BOOST_INSTALL_PROPERTY(edge, kind);
-}
-
-typedef enum { MASTER_EDGE, SLAVE_EDGE, BOTH_EDGE } __attribute__((packed)) EdgeKindType;
-
-struct EdgeProperty
-{
-	EdgeKindType kind;
-	double weight;
-	int32_t rnum;
-	bool min_cov;
-};
-
 //! Class implementing the graph of assemblies
 /*!
  * The graph is constructed from a vector of blocks. For each block, a relative
  * node is created. Edges connect nodes according to the order of the relative
- * blocks in the master and slave assemblies.
+ * blocks in the master and slave assemblies. Edges are collected while the
+ * graph is initialised and stored at once in compressed sparse row format.
  */
-class AssemblyGraph : public boost::adjacency_list< boost::setS, boost::vecS, boost::bidirectionalS,
-boost::no_property, boost::property<boost::edge_kind_t,EdgeProperty> >
+class AssemblyGraph : public CsrGraph
 {
 public:
-    //typedef boost::adjacency_list< boost::setS, boost::vecS, boost::bidirectionalS,
-	//	boost::no_property, boost::property<boost::edge_kind_t,EdgeProperty> > Graph;
     typedef boost::graph_traits<AssemblyGraph>::vertex_descriptor Vertex;
     typedef boost::graph_traits<AssemblyGraph>::vertex_iterator VertexIterator;
     typedef boost::graph_traits<AssemblyGraph>::adjacency_iterator AdjacencyIterator;
@@ -88,19 +68,17 @@ public:
 
 private:
     uint64_t _agId;						//!< assemblies' graph id
-	std::vector<Block> _blockVector;	//!< vector of the blocks used as nodes in the graph
+	BlockSpan _blockVector;				//!< view of the blocks used as nodes in the graph
+	std::vector<Block> _ownedBlocks;	//!< blocks owned by the graph, once modified by removeForks()
 
     //! Initialize the graph from a vector of blocks.
     /*!
      * Creates the nodes of the blocks and connects them with a directed edge,
      * according to their orders in master and slave assemblies.
      *
-     * \param blocks a vector of block
+     * \param blocks a view of the blocks (which must outlive the graph)
      */
-    void initGraph( const std::list<Block> &blocks );
-
-    //! Adds blocks' vertices to the graph.
-    UIntType addVertices();
+    void initGraph( const BlockSpan &blocks );
 
     //! Connects a block (node) to his successive blocks (nodes) in the master assembly
     /*!
@@ -108,11 +86,13 @@ private:
      * \param strandMap StranProbMap object
      * \param indexes of the ordered blocks
      * \param back indexes of the ordered blocks
+     * \param edges edges of the graph being built
      */
     void addMasterEdges( const UIntType &vertex,
                          const StrandProbMap &strandMap,
                          const std::vector<UIntType> &index,
-                         const std::vector<UIntType> &backIndex );
+                         const std::vector<UIntType> &backIndex,
+                         std::vector<EdgeEntry> &edges );
 
     //! Connects a block (node) to his successive blocks (nodes) in the master assembly
     /*!
@@ -120,11 +100,13 @@ private:
      * \param strandMap StranProbMap object
      * \param indexes of the ordered blocks
      * \param back indexes of the ordered blocks
+     * \param edges edges of the graph being built
      */
     void addSlaveEdges( const UIntType &vertex,
                          const StrandProbMap &strandMap,
                          const std::vector<UIntType> &index,
-                         const std::vector<UIntType> &backIndex );
+                         const std::vector<UIntType> &backIndex,
+                         std::vector<EdgeEntry> &edges );
 
     //! Connects two vertices, whose blocks are successive in the master assebly.
     /*!
@@ -132,8 +114,9 @@ private:
      *
      * \param s first vertex
      * \param t second vertex
+     * \param edges edges of the graph being built
      */
-    bool addMasterSingleEdge( const UIntType& s, const UIntType& t );
+    bool addMasterSingleEdge( const UIntType& s, const UIntType& t, std::vector<EdgeEntry> &edges );
 
     //! Connects two vertices, whose blocks are successive in the slave assebly.
     /*!
@@ -141,8 +124,12 @@ private:
      *
      * \param s first vertex
      * \param t second vertex
+     * \param edges edges of the graph being built
      */
-    bool addSlaveSingleEdge( const UIntType& s, const UIntType& t );
+    bool addSlaveSingleEdge( const UIntType& s, const UIntType& t, std::vector<EdgeEntry> &edges );
+
+    //! Builds the graph, joining master and slave edges with the same endpoints into BOTH_EDGE ones.
+    void buildEdges( std::vector<EdgeEntry> &edges );
 
     void bubbleDFS( Vertex v, std::vector<char> &colors, bool &found );
 
@@ -156,18 +143,19 @@ public:
 
     //! A constructor.
     /*!
-     * Creates a graph of assemblies, given a list of blocks.
-     * \param blocks a list of blocks.
+     * Creates a graph of assemblies, given a view of blocks.
+     * Blocks are not copied, hence their storage must outlive the graph.
+     * \param blocks a view of blocks.
      */
-	AssemblyGraph( const std::list< Block > &blocks, uint64_t id = 0 );
+	AssemblyGraph( const BlockSpan &blocks, uint64_t id = 0 );
 
 	inline uint64_t getId() const { return this->_agId; }
 
-    //! Gets the block vector of the graph.
+    //! Gets the blocks of the graph.
     /*!
-     * \return a reference to the block vector
+     * \return a reference to the view of the blocks
      */
-    const std::vector<Block>& getBlocksVector() const;
+    const BlockSpan& getBlocksVector() const;
 
     //! Gets a block of the graph.
     /*!
@@ -195,7 +183,6 @@ public:
     void reverseEdges();
 
     static void agTopologicalSort( const AssemblyGraph &g, std::list<Vertex> &tsList );
-    static void agTopologicalSort( const AssemblyGraph &g, Vertex v, std::vector<char> &colors, std::list<Vertex> &tsList );
 
 	bool hasForks();
 	bool hasBubbles();
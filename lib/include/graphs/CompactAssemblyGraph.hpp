@@ -42,15 +42,13 @@
 #include <iostream>
 #include <iomanip>
 
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/strong_components.hpp>
-#include <boost/graph/topological_sort.hpp>
 //#include <boost/graph/graphviz.hpp>
 #include <boost/dynamic_bitset.hpp>
 
 #include "OrderingFunctions.hpp"
 #include "assembly/Block.hpp"
 #include "graphs/AssemblyGraph.hpp"
+#include "graphs/CsrGraph.hpp"
 #include "strand_fixer/RelativeStrand.hpp"
 #include "strand_fixer/StrandProbability.hpp"
 
@@ -58,14 +56,13 @@
 /*!
  * The graph is constructed from a vector of blocks. For each block, a relative
  * node is created. Edges connect nodes according to the order of the relative
- * blocks in the master and slave assemblies.
+ * blocks in the master and slave assemblies. The graph is stored in compressed
+ * sparse row format: the edges removed and added while solving forks are kept
+ * in the overlay of CsrGraph.
  */
-class CompactAssemblyGraph : public boost::adjacency_list< boost::setS, boost::vecS,
-	boost::bidirectionalS, boost::no_property, boost::property<boost::edge_kind_t,EdgeProperty> >
+class CompactAssemblyGraph : public CsrGraph
 {
 public:
-//    typedef boost::adjacency_list< boost::setS, boost::vecS, boost::bidirectionalS,
-//		boost::no_property, boost::property<boost::edge_kind_t,EdgeProperty> > Graph;
     typedef boost::graph_traits<CompactAssemblyGraph>::vertex_descriptor Vertex;
     typedef boost::graph_traits<CompactAssemblyGraph>::vertex_iterator VertexIterator;
     typedef boost::graph_traits<CompactAssemblyGraph>::adjacency_iterator AdjacencyIterator;
@@ -77,7 +74,8 @@ public:
 private:
     uint64_t _cgId;
     uint64_t _num_vertices;
-    std::vector< std::list<Block> > _blockVector; //!< associate at each vertex a list of blocks (with the same master/slave)
+    std::vector<Block> _blocks;         //!< blocks of the graph, grouped by vertex (with the same master/slave)
+    std::vector<size_t> _blockOffsets;  //!< blocks of vertex \c v are in <code>[_blockOffsets[v], _blockOffsets[v+1])</code>
 
     //! Initialize the graph from a vector of blocks.
     /*!
@@ -92,7 +90,9 @@ private:
 		const AssemblyGraph &ag,
 		const AssemblyGraph::Vertex &root,
 		boost::dynamic_bitset<> *visited,
-		std::vector<Vertex> *ag2cg
+		std::vector<Vertex> *ag2cg,
+		std::vector<AssemblyGraph::Vertex> *visitOrder,
+		std::vector<EdgeEntry> *edges
 	);
 
     void initGraph( const AssemblyGraph &ag );
@@ -102,15 +102,26 @@ private:
         const AssemblyGraph::Vertex &v,
 		const AssemblyGraph::Vertex &u,
         boost::dynamic_bitset<> *colors,
-        std::vector<Vertex> *ag2cg
+        std::vector<Vertex> *ag2cg,
+        std::vector<AssemblyGraph::Vertex> *visitOrder,
+        std::vector<EdgeEntry> *edges
 	);
 
+    //! Copies the blocks of \c ag into \c _blocks, grouped by the vertex they have been collapsed into.
+    /*!
+     * \param ag the assemblies' graph.
+     * \param visitOrder vertices of \c ag, in the order they have been visited.
+     * \param ag2cg vertex of the compact graph associated to each vertex of \c ag.
+     */
+    void initBlocks( const AssemblyGraph &ag, const std::vector<AssemblyGraph::Vertex> &visitOrder,
+                     const std::vector<Vertex> &ag2cg );
+
     void bubbleDFS( Vertex v, std::vector<char> &colors, bool &found );
 
     void getRegionScore( MultiBamReader &peBamReader, MultiBamReader &mpBamReader, EdgeKindType kind,
-            std::list<Block>& b1, std::list<Block>& b2, double &weight, int32_t &rnum, bool &min_cov );
+            const BlockSpan& b1, const BlockSpan& b2, double &weight, int32_t &rnum, bool &min_cov );
 
-    void getLibRegionScore( MultiBamReader &bamReader, EdgeKindType kind, std::list<Block> &b1, std::list<Block> &b2,
+    void getLibRegionScore( MultiBamReader &bamReader, EdgeKindType kind, const BlockSpan &b1, const BlockSpan &b2,
             double &weight, int32_t &rnum, bool &min_cov );
 
 public:
@@ -124,18 +135,12 @@ public:
 
 	inline uint64_t getId() const { return this->_cgId; }
 
-    //! Gets the blocks vector of the graph.
-    /*!
-     * \return a reference to the blocks vector
-     */
-    const std::vector< std::list<Block> >& getBlocksVector() const;
-
-    //! Gets a block of the graph.
+    //! Gets the blocks of a vertex of the graph.
     /*!
-     * \param pos index of the block in the vector \c _blockVector
-     * \return the block at index \c pos in the block's vector
+     * \param pos a vertex of the graph
+     * \return a view over the blocks collapsed into vertex \c pos
      */
-    const std::list<Block>& getBlocks( const Vertex &pos ) const;
+    BlockSpan getBlocks( const Vertex &pos ) const;
 
     //! Assign operator of the AssemblyGraph class.
     const CompactAssemblyGraph& operator=( const CompactAssemblyGraph &orig );
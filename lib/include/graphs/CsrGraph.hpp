@@ -0,0 +1,409 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*!
+ * \file CsrGraph.hpp
+ * \brief Definition of CsrGraph class.
+ * \details This file contains the definition of the compressed sparse row
+ *          storage shared by the assemblies' graphs, and the functions that
+ *          make it a Boost graph.
+ */
+
+#ifndef CSRGRAPH_HPP
+#define	CSRGRAPH_HPP
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include <boost/config.hpp>
+#include <boost/graph/exception.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/properties.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+
+namespace boost
+{
+    enum edge_kind_t { edge_kind };
+    BOOST_INSTALL_PROPERTY(edge, kind);
+}
+
+typedef enum { MASTER_EDGE, SLAVE_EDGE, BOTH_EDGE } __attribute__((packed)) EdgeKindType;
+
+struct EdgeProperty
+{
+	EdgeKindType kind;
+	double weight;
+	int32_t rnum;
+	bool min_cov;
+};
+
+//! Directed graph stored in compressed sparse row format.
+/*!
+ * Edges are built at once by build(): the out-edges of each vertex are
+ * stored contiguously, sorted by target, and the in-edges are an array of
+ * edge indexes sorted by source, so that a graph costs a few words per
+ * vertex and per edge. Later changes (as the ones made while solving forks)
+ * go to a small overlay: removed edges are flagged and added edges are
+ * kept, per vertex, in sorted vectors. Iterators merge the two, hence edges
+ * are visited in the same order as with a <tt>boost::adjacency_list</tt>
+ * with \c setS out-edges.
+ *
+ * The graph models the Boost bidirectional, vertex list, edge list and
+ * adjacency graph concepts through the functions in namespace \c boost
+ * below, while the edge properties are read and written with
+ * <tt>boost::get/put( boost::edge_kind_t(), ... )</tt>.
+ */
+class CsrGraph
+{
+
+public:
+    typedef size_t Vertex;
+
+    //! Edge descriptor (index of the edge in the graph's arrays).
+    struct Edge
+    {
+        uint32_t id;
+
+        Edge() : id(0) {}
+        explicit Edge( uint32_t i ) : id(i) {}
+
+        inline bool operator==( const Edge &e ) const { return id == e.id; }
+        inline bool operator!=( const Edge &e ) const { return id != e.id; }
+        inline bool operator<( const Edge &e ) const { return id < e.id; }
+    };
+
+    //! Edge given to build().
+    struct EdgeEntry
+    {
+        uint32_t source;
+        uint32_t target;
+        EdgeProperty prop;
+
+        EdgeEntry() {}
+        EdgeEntry( Vertex s, Vertex t, const EdgeProperty &p ) : source(s), target(t), prop(p) {}
+    };
+
+    //! Orders edges by source and target.
+    static inline bool edgeEntryLess( const EdgeEntry &a, const EdgeEntry &b )
+    {
+        return a.source < b.source || ( a.source == b.source && a.target < b.target );
+    }
+
+    //! Iterator on the out-edges (or the in-edges) of a vertex, merging stored and added edges.
+    class IncidentEdgeIterator : public boost::iterator_facade< IncidentEdgeIterator, Edge, boost::forward_traversal_tag, Edge >
+    {
+    private:
+        friend class boost::iterator_core_access;
+        friend class CsrGraph;
+
+        const CsrGraph *_graph;
+        bool _in;                   //!< whether in-edges are iterated.
+        uint32_t _pos;              //!< position among the stored edges.
+        uint32_t _end;              //!< end of the stored edges.
+        const uint32_t *_added;     //!< current added edge.
+        const uint32_t *_addedEnd;  //!< end of the added edges.
+        bool _onAdded;              //!< whether the current edge is an added one.
+
+        inline uint32_t storedId() const { return _in ? _graph->_inEdges[_pos] : _pos; }
+        inline uint32_t key( uint32_t id ) const { return _in ? _graph->_sources[id] : _graph->_targets[id]; }
+
+        inline void settle()
+        {
+            if( _graph->_removedNum > 0 )
+            {
+                while( _pos < _end && _graph->_removed[ this->storedId() ] ) _pos++;
+                while( _added != _addedEnd && _graph->_removed[ *_added ] ) _added++;
+            }
+
+            _onAdded = _added != _addedEnd && ( _pos == _end || this->key(*_added) < this->key(this->storedId()) );
+        }
+
+        inline void increment()
+        {
+            if( _onAdded ) _added++; else _pos++;
+            this->settle();
+        }
+
+        inline bool equal( const IncidentEdgeIterator &it ) const { return _pos == it._pos && _added == it._added; }
+
+        inline Edge dereference() const { return Edge( _onAdded ? *_added : this->storedId() ); }
+
+    public:
+        IncidentEdgeIterator() : _graph(NULL), _in(false), _pos(0), _end(0), _added(NULL), _addedEnd(NULL), _onAdded(false) {}
+    };
+
+    //! Iterator on the targets of the out-edges of a vertex.
+    class AdjacentVertexIterator : public boost::iterator_facade< AdjacentVertexIterator, Vertex, boost::forward_traversal_tag, Vertex >
+    {
+    private:
+        friend class boost::iterator_core_access;
+
+        const CsrGraph *_graph;
+        IncidentEdgeIterator _edge;
+
+        inline void increment() { ++_edge; }
+        inline bool equal( const AdjacentVertexIterator &it ) const { return _edge == it._edge; }
+        inline Vertex dereference() const { return _graph->_targets[ (*_edge).id ]; }
+
+    public:
+        AdjacentVertexIterator() : _graph(NULL) {}
+        AdjacentVertexIterator( const CsrGraph *graph, const IncidentEdgeIterator &edge ) : _graph(graph), _edge(edge) {}
+    };
+
+    //! Iterator on all the edges of the graph (stored ones first, then added ones).
+    class AllEdgeIterator : public boost::iterator_facade< AllEdgeIterator, Edge, boost::forward_traversal_tag, Edge >
+    {
+    private:
+        friend class boost::iterator_core_access;
+
+        const CsrGraph *_graph;
+        uint32_t _id;
+
+        inline void increment()
+        {
+            _id++;
+            while( _id < _graph->_removed.size() && _graph->_removed[_id] ) _id++;
+        }
+
+        inline bool equal( const AllEdgeIterator &it ) const { return _id == it._id; }
+        inline Edge dereference() const { return Edge(_id); }
+
+    public:
+        AllEdgeIterator() : _graph(NULL), _id(0) {}
+        AllEdgeIterator( const CsrGraph *graph, uint32_t id ) : _graph(graph), _id(id)
+        {
+            while( _id < _graph->_removed.size() && _graph->_removed[_id] ) _id++;
+        }
+    };
+
+    // Boost graph traits
+    typedef Vertex vertex_descriptor;
+    typedef Edge edge_descriptor;
+    typedef IncidentEdgeIterator out_edge_iterator;
+    typedef IncidentEdgeIterator in_edge_iterator;
+    typedef AdjacentVertexIterator adjacency_iterator;
+    typedef boost::counting_iterator< Vertex > vertex_iterator;
+    typedef AllEdgeIterator edge_iterator;
+    typedef boost::directed_tag directed_category;
+    typedef boost::disallow_parallel_edge_tag edge_parallel_category;
+    typedef size_t vertices_size_type;
+    typedef size_t edges_size_type;
+    typedef size_t degree_size_type;
+
+    struct traversal_category :
+        public virtual boost::bidirectional_graph_tag,
+        public virtual boost::vertex_list_graph_tag,
+        public virtual boost::edge_list_graph_tag,
+        public virtual boost::adjacency_graph_tag {};
+
+    static inline Vertex null_vertex() { return Vertex(-1); }
+
+private:
+    static const uint32_t NO_EDGE = 0xFFFFFFFFu;
+
+    typedef std::map< Vertex, std::vector<uint32_t> > AddedEdgesMap;
+
+    size_t _vertices;                       //!< number of vertices.
+    uint32_t _storedEdges;                  //!< number of edges stored by build().
+
+    std::vector< uint32_t > _outOffsets;    //!< out-edges of \c v are the edges <code>[_outOffsets[v], _outOffsets[v+1])</code>.
+    std::vector< uint32_t > _inOffsets;     //!< in-edges of \c v are <code>_inEdges[_inOffsets[v] .. _inOffsets[v+1]-1]</code>.
+    std::vector< uint32_t > _inEdges;       //!< stored edges, sorted by target and source.
+
+    std::vector< uint32_t > _sources;       //!< source of each edge.
+    std::vector< uint32_t > _targets;       //!< target of each edge.
+    std::vector< EdgeProperty > _props;     //!< property of each edge.
+
+    // overlay
+    std::vector< bool > _removed;           //!< whether each edge has been removed.
+    uint32_t _removedNum;                   //!< number of removed edges.
+    AddedEdgesMap _addedOut;                //!< edges added after build(), by source (sorted by target).
+    AddedEdgesMap _addedIn;                 //!< edges added after build(), by target (sorted by source).
+
+    //! Index of the edge (u,v), removed or not, or \c NO_EDGE.
+    uint32_t findEdge( const Vertex &u, const Vertex &v ) const;
+
+    //! Inserts an added edge in a vector sorted by the given endpoints.
+    static void insertAdded( std::vector<uint32_t> &edges, uint32_t id, const std::vector<uint32_t> &keys );
+
+    inline std::pair<IncidentEdgeIterator,IncidentEdgeIterator> incidentEdges( const Vertex &v, bool in ) const;
+    inline size_t degree( const Vertex &v, bool in ) const;
+
+public:
+    //! A constructor (creates an empty graph).
+    CsrGraph();
+
+    //! Removes all vertices and edges.
+    void clear();
+
+    //! Replaces the graph with a new one.
+    /*!
+     * When an edge is given more than once, the property of the last one is
+     * kept. The entries are sorted in place.
+     *
+     * \param vertices number of vertices
+     * \param edges edges of the graph
+     */
+    void build( size_t vertices, std::vector<EdgeEntry> &edges );
+
+    inline size_t numVertices() const { return this->_vertices; }
+    size_t numEdges() const;
+
+    inline Vertex source( const Edge &e ) const { return this->_sources[e.id]; }
+    inline Vertex target( const Edge &e ) const { return this->_targets[e.id]; }
+
+    inline std::pair<IncidentEdgeIterator,IncidentEdgeIterator> outEdges( const Vertex &v ) const { return this->incidentEdges( v, false ); }
+    inline std::pair<IncidentEdgeIterator,IncidentEdgeIterator> inEdges( const Vertex &v ) const { return this->incidentEdges( v, true ); }
+
+    inline std::pair<AdjacentVertexIterator,AdjacentVertexIterator> adjacentVertices( const Vertex &v ) const
+    {
+        std::pair<IncidentEdgeIterator,IncidentEdgeIterator> e = this->incidentEdges( v, false );
+        return std::make_pair( AdjacentVertexIterator( this, e.first ), AdjacentVertexIterator( this, e.second ) );
+    }
+
+    std::pair<AllEdgeIterator,AllEdgeIterator> allEdges() const;
+
+    inline size_t outDegree( const Vertex &v ) const { return this->degree( v, false ); }
+    inline size_t inDegree( const Vertex &v ) const { return this->degree( v, true ); }
+
+    //! Gets the edge (u,v), if any.
+    std::pair<Edge,bool> edge( const Vertex &u, const Vertex &v ) const;
+
+    //! Adds the edge (u,v) to the overlay, unless it already exists.
+    /*!
+     * \return the edge and whether it has been added
+     */
+    std::pair<Edge,bool> addEdge( const Vertex &u, const Vertex &v );
+
+    //! Removes an edge.
+    void removeEdge( const Edge &e );
+
+    //! Removes the edge (u,v), if any.
+    void removeEdge( const Vertex &u, const Vertex &v );
+
+    inline const EdgeProperty& property( const Edge &e ) const { return this->_props[e.id]; }
+    inline void setProperty( const Edge &e, const EdgeProperty &prop ) { this->_props[e.id] = prop; }
+
+    //! Sorts the vertices topologically (Kahn's algorithm).
+    /*!
+     * \param order vertices in topological order
+     * \throws boost::not_a_dag if the graph has a cycle
+     */
+    void topologicalSort( std::vector<Vertex> &order ) const;
+};
+
+
+inline std::pair<CsrGraph::IncidentEdgeIterator,CsrGraph::IncidentEdgeIterator>
+CsrGraph::incidentEdges( const Vertex &v, bool in ) const
+{
+    const std::vector<uint32_t> &offsets = in ? this->_inOffsets : this->_outOffsets;
+    const AddedEdgesMap &added = in ? this->_addedIn : this->_addedOut;
+
+    IncidentEdgeIterator begin;
+    begin._graph = this;
+    begin._in = in;
+    begin._pos = offsets[v];
+    begin._end = offsets[v+1];
+
+    // most graphs have no added edges
+    if( !added.empty() )
+    {
+        AddedEdgesMap::const_iterator a = added.find(v);
+        if( a != added.end() && !a->second.empty() )
+        {
+            begin._added = &(a->second[0]);
+            begin._addedEnd = begin._added + a->second.size();
+        }
+    }
+
+    IncidentEdgeIterator end = begin;
+    end._pos = end._end;
+    end._added = end._addedEnd;
+
+    begin.settle();
+
+    return std::make_pair( begin, end );
+}
+
+
+inline size_t
+CsrGraph::degree( const Vertex &v, bool in ) const
+{
+    const std::vector<uint32_t> &offsets = in ? this->_inOffsets : this->_outOffsets;
+    const AddedEdgesMap &added = in ? this->_addedIn : this->_addedOut;
+
+    if( this->_removedNum == 0 && added.empty() ) return offsets[v+1] - offsets[v];
+
+    size_t degree = 0;
+
+    std::pair<IncidentEdgeIterator,IncidentEdgeIterator> e = this->incidentEdges( v, in );
+    for( ; e.first != e.second; ++e.first ) degree++;
+
+    return degree;
+}
+
+
+namespace boost
+{
+    inline std::pair<CsrGraph::vertex_iterator,CsrGraph::vertex_iterator> vertices( const CsrGraph &g )
+    {
+        return std::make_pair( CsrGraph::vertex_iterator(0), CsrGraph::vertex_iterator(g.numVertices()) );
+    }
+
+    inline size_t num_vertices( const CsrGraph &g ) { return g.numVertices(); }
+    inline size_t num_edges( const CsrGraph &g ) { return g.numEdges(); }
+
+    inline std::pair<CsrGraph::edge_iterator,CsrGraph::edge_iterator> edges( const CsrGraph &g ) { return g.allEdges(); }
+
+    inline std::pair<CsrGraph::out_edge_iterator,CsrGraph::out_edge_iterator> out_edges( CsrGraph::Vertex v, const CsrGraph &g ) { return g.outEdges(v); }
+    inline std::pair<CsrGraph::in_edge_iterator,CsrGraph::in_edge_iterator> in_edges( CsrGraph::Vertex v, const CsrGraph &g ) { return g.inEdges(v); }
+    inline std::pair<CsrGraph::adjacency_iterator,CsrGraph::adjacency_iterator> adjacent_vertices( CsrGraph::Vertex v, const CsrGraph &g ) { return g.adjacentVertices(v); }
+
+    inline size_t out_degree( CsrGraph::Vertex v, const CsrGraph &g ) { return g.outDegree(v); }
+    inline size_t in_degree( CsrGraph::Vertex v, const CsrGraph &g ) { return g.inDegree(v); }
+
+    inline CsrGraph::Vertex source( const CsrGraph::Edge &e, const CsrGraph &g ) { return g.source(e); }
+    inline CsrGraph::Vertex target( const CsrGraph::Edge &e, const CsrGraph &g ) { return g.target(e); }
+
+    inline std::pair<CsrGraph::Edge,bool> edge( CsrGraph::Vertex u, CsrGraph::Vertex v, const CsrGraph &g ) { return g.edge(u,v); }
+    inline std::pair<CsrGraph::Edge,bool> add_edge( CsrGraph::Vertex u, CsrGraph::Vertex v, CsrGraph &g ) { return g.addEdge(u,v); }
+
+    inline void remove_edge( CsrGraph::Vertex u, CsrGraph::Vertex v, CsrGraph &g ) { g.removeEdge(u,v); }
+    inline void remove_edge( const CsrGraph::Edge &e, CsrGraph &g ) { g.removeEdge(e); }
+    inline void remove_edge( const CsrGraph::out_edge_iterator &e, CsrGraph &g ) { g.removeEdge(*e); }
+
+    inline const EdgeProperty& get( edge_kind_t, const CsrGraph &g, const CsrGraph::Edge &e ) { return g.property(e); }
+    inline void put( edge_kind_t, CsrGraph &g, const CsrGraph::Edge &e, const EdgeProperty &prop ) { g.setProperty(e,prop); }
+}
+
+#endif	/* CSRGRAPH_HPP */
@@ -108,7 +108,7 @@ PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::PairedContigGraph(
 
 
 template <class VERTEX_PROP, class EDGE_WEIGHT>
-PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::PairedContigGraph( const std::list<Block> &blocks )
+PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::PairedContigGraph( const BlockSpan &blocks )
 {
     this->initGraph( blocks );
 }
@@ -116,12 +116,12 @@ PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::PairedContigGraph( const std::list<B
 
 template <class VERTEX_PROP, class EDGE_WEIGHT>
 void
-PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::initGraph( const std::list<Block> &blocks )
+PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::initGraph( const BlockSpan &blocks )
 {
     this->initVertexLabels(blocks);
 
     // add an edge connected the master and slave contigs vertices of a block.
-	for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
+	for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
     {
         int32_t masterCtgId = b->getMasterId();
 		int32_t slaveCtgId = b->getSlaveId();
@@ -133,13 +133,13 @@ PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::initGraph( const std::list<Block> &b
 
 template <class VERTEX_PROP, class EDGE_WEIGHT>
 void
-PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::initVertexLabels( const std::list<Block>& blocks )
+PairedContigGraph<VERTEX_PROP,EDGE_WEIGHT>::initVertexLabels( const BlockSpan& blocks )
 {
     // collect master and slave contigs
     std::set< int32_t > masterCtgIdSet;
     std::set< int32_t > slaveCtgIdSet;
 
-	for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
+	for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
     {
 		masterCtgIdSet.insert( b->getMasterId() );
 		slaveCtgIdSet.insert( b->getSlaveId() );
@@ -142,13 +142,13 @@ private:
      *
      * \param blocks a vector of blocks.
      */
-    void initGraph( const std::list<Block>& blocks );
+    void initGraph( const BlockSpan& blocks );
 
     //! Creates a vertex for each contig.
     /*!
      * \param blocks a vector of blocks.
      */
-    void initVertexLabels( const std::list<Block>& blocks );
+    void initVertexLabels( const BlockSpan& blocks );
 
 public:
     //! A constructor.
@@ -169,7 +169,7 @@ public:
      * Creates and initialises a PairedContigGraph, given a vector of blocks.
      * \param blocks a vector of blocks.
      */
-    PairedContigGraph( const std::list<Block> &blocks );
+    PairedContigGraph( const BlockSpan &blocks );
 
     //! Write the graph in dot format.
     /*!
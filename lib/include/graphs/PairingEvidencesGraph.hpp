@@ -58,14 +58,14 @@ private:
      * is increased by 1.
      * \param blocks a list of blocks.
      */
-    void addEdgeWeights( const std::list<Block>& blocks );
+    void addEdgeWeights( const BlockSpan& blocks );
 
 public:
     //! A constructor.
     /*!
      * \param blocks a list of blocks.
      */
-    PairingEvidencesGraph( const std::list<Block> &blocks );
+    PairingEvidencesGraph( const BlockSpan &blocks );
 
 };
 
@@ -78,7 +78,7 @@ public:
 //std::vector<Block> filterBlocksByPairingEvidences( const std::vector<Block> &blocks, const int minPairEvid = 1 );
 
 void getSingleLinkBlocks(
-	const std::list<Block> &blocks,
+	const BlockSpan &blocks,
 	std::set< std::pair<int32_t,int32_t> > &slb
 );
 
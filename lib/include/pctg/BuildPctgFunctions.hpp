@@ -54,15 +54,20 @@
 std::list< PairedContig >& buildPctg(
         CompactAssemblyGraph &ag,
         PctgBuilder &builder,
-        std::list< PairedContig > &pctgList
+        std::list< PairedContig > &pctgList,
+        ThreadedBuildPctg *tbp = NULL,
+        uint64_t tid = 0
 );
 
 
 std::list< PairedContig >& buildPctg(
 		ThreadedBuildPctg *tbp,
+        uint64_t tid,
         CompactAssemblyGraph &ag,
         const RefSequence &masterRef,
 		const RefSequence &slaveRef,
+        MultiBamReader *masterBamReader,
+        MultiBamReader *slaveBamReader,
         std::list< PairedContig > &pctgList
 );
 
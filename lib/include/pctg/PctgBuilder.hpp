@@ -39,6 +39,7 @@
 #define	PCTGBUILDER_HPP
 
 #include <iostream>
+#include <map>
 #include <stdexcept>
 #include <pthread.h>
 
@@ -46,8 +47,10 @@
 #include "api/BamMultiReader.h"
 
 #include "types.hpp"
+#include "alignment/chained_aligner.hpp"
 #include "alignment/my_alignment.hpp"
 #include "assembly/Block.hpp"
+#include "assembly/contig_view.hpp"
 #include "assembly/RefSequence.hpp"
 #include "pctg/BestCtgAlignment.hpp"
 #include "pctg/ContigInPctgInfo.hpp"
@@ -90,10 +93,23 @@ private:
 	const RefSequence *_masterRef;        //!< Reference to the id->name vector of the master contigs.
 	const RefSequence *_slaveRef;         //!< Reference to the id->name vector of the slave contigs.
 
+	MultiBamReader *_masterBam;           //!< BAM reader of the master assembly (the global one, if \c NULL).
+	MultiBamReader *_slaveBam;            //!< BAM reader of the slave assembly (the global one, if \c NULL).
+
     UIntType _maxAlignment;                             //!< Maximum alignment size
     UIntType _maxPctgGap;                               //!< Maximum paired contig gaps
     UIntType _maxCtgGap;                                //!< Maximum contig gaps
 
+    mutable ChainedAligner _tailAligner;                //!< Aligner of the contigs' tails (its buffers are reused)
+
+    mutable std::map< int32_t, const Contig* > _masterCtgs; //!< master contigs acquired from the FASTA index (released by the destructor)
+    mutable std::map< int32_t, const Contig* > _slaveCtgs;  //!< slave contigs acquired from the FASTA index (released by the destructor)
+
+    const Contig& loadContig( const RefSequence &ref, std::map< int32_t, const Contig* > &loaded, const int32_t ctgId ) const;
+
+    PctgBuilder( const PctgBuilder &orig );
+    PctgBuilder& operator=( const PctgBuilder &orig );
+
 public:
     //! A constructor.
     /*!
@@ -102,30 +118,39 @@ public:
      * \param slavePool reference to the slave contigs pool
      * \param masterRefVector reference to the vector id->name of master contigs
      * \param slaveRefVector reference to the vector id->name of slave contigs
+     * \param masterBamReader BAM reader of the master assembly (private to the calling thread)
+     * \param slaveBamReader BAM reader of the slave assembly (private to the calling thread)
      */
     PctgBuilder(
 			ThreadedBuildPctg *tbp = NULL,
             const RefSequence *masterRef = NULL,
-            const RefSequence *slaveRef = NULL);
+            const RefSequence *slaveRef = NULL,
+            MultiBamReader *masterBamReader = NULL,
+            MultiBamReader *slaveBamReader = NULL);
+
+    //! A destructor (releases the contigs loaded by the builder).
+    ~PctgBuilder();
 
     //! Gets a master contig, given its ID.
     /*!
      * \param ctgId pair consisting in master sequence's assembly and contig identifiers.
+     * The contig is loaded from the FASTA index on first use and kept until the builder is destroyed.
      * \return reference to the master contig with ID \c ctgId.
      */
     inline const Contig& loadMasterContig(const int32_t ctgId) const
 	{
-		return *(this->_masterRef->at(ctgId)).Sequence;
+		return this->loadContig( *(this->_masterRef), this->_masterCtgs, ctgId );
 	}
 
     //! Gets a slave contig, given its ID.
     /*!
      * \param ctgId pair consisting in slave sequence's assembly and contig identifiers.
+     * The contig is loaded from the FASTA index on first use and kept until the builder is destroyed.
      * \return reference to the slave contig with ID \c ctgId.
      */
     inline const Contig& loadSlaveContig(const int32_t ctgId) const
 	{
-		return *(this->_slaveRef->at(ctgId)).Sequence;
+		return this->loadContig( *(this->_slaveRef), this->_slaveCtgs, ctgId );
 	}
 
 	//! Adds the first contig to a paired contig.
@@ -147,10 +172,10 @@ public:
      */
     PairedContig initByContig(const IdType &pctgId, const int32_t ctgId) const;
 
-	void appendMasterToPctg( PairedContig &pctg, int32_t id, Contig &ctg, int32_t start, int32_t end, bool rev );
-	void appendSlaveToPctg( PairedContig &pctg, int32_t id, Contig &ctg, int32_t start, int32_t end, bool rev );
-	void appendBlocksRegionToPctg( PairedContig &pctg, int32_t m_id, Contig &m_ctg, int32_t m_start, int32_t m_end, bool m_rev,
-								   int32_t s_id, Contig &s_ctg, int32_t s_start, int32_t s_end, bool s_rev );
+	void appendMasterToPctg( PairedContig &pctg, int32_t id, const ContigView &ctg, int32_t start, int32_t end, bool rev );
+	void appendSlaveToPctg( PairedContig &pctg, int32_t id, const ContigView &ctg, int32_t start, int32_t end, bool rev );
+	void appendBlocksRegionToPctg( PairedContig &pctg, int32_t m_id, const ContigView &m_ctg, int32_t m_start, int32_t m_end, bool m_rev,
+								   int32_t s_id, const ContigView &s_ctg, int32_t s_start, int32_t s_end, bool s_rev );
 
 	void buildPctgs( std::list<PairedContig> &pctgList, MergeBlockLists &mergeLists );
 	void buildPctgs( std::list<PairedContig> &pctgList, std::list<MergeBlock> &ml );
@@ -179,20 +204,20 @@ public:
      */
     void findBestAlignment(
         BestCtgAlignment &bestAlign,
-        Contig &masterCtg,
+        const ContigView &masterCtg,
 		uint64_t masterStart,
 		uint64_t masterEnd,
-		Contig &slaveCtg,
+		ContigView &slaveCtg,
         uint64_t slaveStart,
         uint64_t slaveEnd,
-        const std::list<Block>& blocks_list ) const;
+        const BlockSpan& blocks_list ) const;
 
 	void alignBlocks(
-		const Contig &masterCtg,
+		const ContigView &masterCtg,
 		const uint64_t &masterStart,
-		const Contig &slaveCtg,
+		const ContigView &slaveCtg,
 		const uint64_t &slaveStart,
-		const std::list<Block> &blocks_list,
+		const BlockSpan &blocks_list,
 		std::vector< MyAlignment > &alignments ) const;
 
 	bool is_good( const std::vector<MyAlignment> &align, uint64_t min_align_len = MIN_ALIGNMENT_LEN ) const;
@@ -32,14 +32,31 @@
 #define	THREADEDBUILDPCTG_HPP
 
 #include <pthread.h>
+#include <deque>
 #include <list>
+#include <ostream>
+#include <vector>
 
 #include "bam/MultiBamReader.hpp"
 #include "graphs/CompactAssemblyGraph.hpp"
+#include "pctg/MergeDescriptor.hpp"
 #include "pctg/PairedContig.hpp"
+#include "PartitionFunctions.hpp"
+
+class PctgBuilder;
 
 void * buildPctgThread(void *argv);
 
+//! Kinds of alignments counted while merging.
+typedef enum
+{
+    CTG_PAIR_ALIGNMENT = 0, /*!< pairs of contigs aligned to be merged. */
+    BLOCK_ALIGNMENT,        /*!< banded alignments of single blocks. */
+    STRAND_RETRY,           /*!< pairs of contigs realigned with the other orientation. */
+    TAIL_ALIGNMENT,         /*!< banded alignments of contigs' tails. */
+    ALIGNMENT_KINDS
+} AlignmentKind;
+
 class ThreadedBuildPctg
 {
 
@@ -49,10 +66,32 @@ private:
     {
 		ThreadedBuildPctg *tbp;
 		uint64_t tid;
-		std::list< PairedContig > *output;
+
+		// BAM readers private to the thread, opened on its first partition
+		bool readersOpen;
+		MultiBamReader masterBam;
+		MultiBamReader masterMpBam;
+		MultiBamReader slaveBam;
+		MultiBamReader slaveMpBam;
+
+		int64_t part;               //!< partition being processed
+		uint64_t excludedTime;      //!< time (microseconds) spent on other partitions' tasks or waiting for stolen ones
 
     } thread_arg_t;
 
+    //! Alignment of a merge block, which may be run by any of the threads.
+    typedef struct align_task
+    {
+		const CompactAssemblyGraph *graph;
+		MergeBlock *mb;
+		PctgBuilder *builder;       //!< builder of the thread which submitted the task
+		uint64_t owner;             //!< thread which submitted the task
+		uint64_t part;              //!< partition of the merge block
+		volatile uint64_t *pending; //!< tasks of the same partition not completed yet
+		volatile bool *failed;      //!< whether a task of the same partition threw an exception
+
+    } align_task_t;
+
     // input
     const RefSequence& _masterRef;
     const RefSequence& _slaveRef;
@@ -61,39 +100,95 @@ private:
     UIntType _pctgsDone;
     UIntType _lastPerc;
 
-    std::vector< CompactAssemblyGraph* > _graphs;
-    uint64_t _nextPctg;
+    const std::vector< BlockSpan > &_partitions;
+
+    // scheduling (partitions are processed in decreasing order of predicted cost)
+    std::vector< uint64_t > _schedule;      //!< indexes of the partitions, in processing order
+    volatile uint64_t _nextPctg;            //!< position in _schedule of the next partition to process
+    std::vector< uint64_t > _predictedCost; //!< predicted cost of each partition
+    std::vector< uint64_t > _actualCost;    //!< processing time (microseconds) of each partition, summed over the threads working on it
+
+    // alignments of merge blocks, shared among the threads (work-stealing)
+    std::vector< thread_arg_t* > _threadArgs;                 //!< arguments of the worker threads
+    std::vector< std::deque< align_task_t > > _alignTasks;    //!< tasks submitted by each thread, not started yet
+    uint64_t _activeThreads;                                  //!< threads still processing partitions
+    uint64_t _stolenTasks;                                    //!< tasks run by a thread other than their owner
+
+    uint32_t _graphKinds[CYCLIC_GRAPH+1];  //!< number of assemblies' graphs of each kind
+    uint64_t _alignments[ALIGNMENT_KINDS]; //!< number of alignments of each kind
 
     uint64_t _procBlocks;
     uint64_t _totBlocks;
 
-    // output
-    std::list< PairedContig > _pctgList;
+    // output (paired contigs of each partition)
+    std::vector< std::list< PairedContig > > _pctgLists;
 
     // mutex
     pthread_mutex_t _mutexRemoveCtgId;
-    pthread_mutex_t _mutex;
     pthread_mutex_t _mutexProcBlocks;
     pthread_mutex_t _mutexPctgNumInc;
-
-    pthread_mutex_t _mutexMasterBam; // mutex per accedere al BAM master
-    pthread_mutex_t _mutexSlaveBam; // mutex per accedere al BAM slave
+    pthread_mutex_t _mutexGraphKinds;
+    pthread_mutex_t _mutexAlignments;
+    pthread_mutex_t _mutexTasks;            //!< protects the fields of the alignment tasks
+    pthread_cond_t _condTasks;              //!< signals submitted tasks, completed partitions and idle threads
 
 	// private methods
-    CompactAssemblyGraph* extractNextPctg();
+    uint64_t estimateCost( const BlockSpan &blocks ) const;
+    void schedulePartitions();
+    int64_t extractNextPartition();
+    void incGraphKind( AssemblyGraphKind kind );
 	IdType readPctgNumAndIncrease();
 	void incProcBlocks( uint64_t num, uint64_t tid );
+    void openReaders( thread_arg_t *thread_argv );
+    bool extractAlignTask( uint64_t tid, align_task_t &task );
+    void runAlignTask( uint64_t tid, const align_task_t &task );
+    void helpAlignments( uint64_t tid );
 
 public:
 
+    //! A constructor.
+    /*!
+     * \param partitions partitions of the blocks, each one processed independently:
+     *        assemblies' graphs are built, weighted and merged by the worker threads.
+     * \param masterRef master's contigs.
+     * \param slaveRef slave's contigs.
+     */
     ThreadedBuildPctg(
-            const std::list< CompactAssemblyGraph* > &graphsList,
+            const std::vector< BlockSpan > &partitions,
             const RefSequence &masterRef,
             const RefSequence &slaveRef
 	);
 
+    //! Builds the paired contigs of every partition.
+    /*!
+     * \return paired contigs, in the order of the partitions.
+     */
     std::list<PairedContig>* run();
 
+    //! Writes the number of assemblies' graphs of each kind.
+    void writeGraphsStats( std::ostream &os ) const;
+
+    //! Counts alignments computed by the worker threads.
+    void incAlignments( AlignmentKind kind, uint64_t num = 1 );
+
+    //! Writes the number of alignments of each kind and the gap model used.
+    void writeAlignmentStats( std::ostream &os ) const;
+
+    //! Aligns the merge blocks of a partition.
+    /*!
+     * Alignments are submitted as tasks which idle threads may steal, while
+     * the calling thread runs its own tasks (or other threads' ones) until
+     * all of them are completed.
+     * \param tid thread processing the partition.
+     * \param graph assemblies' graph of the partition.
+     * \param builder builder of the paired contigs of the partition.
+     * \param mergeLists merge blocks to be aligned.
+     */
+    void alignMergeBlocks( uint64_t tid, const CompactAssemblyGraph &graph, PctgBuilder &builder, MergeBlockLists &mergeLists );
+
+    //! Writes predicted costs and processing times of the largest partitions.
+    void writeSchedulingStats( std::ostream &os ) const;
+
 	double computeZScore( MultiBamReader &multiBamReader, int32_t ctgId, uint32_t start, uint32_t end, bool isMaster );
 
     friend void* buildPctgThread(void *argv);
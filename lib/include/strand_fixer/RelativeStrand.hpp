@@ -39,6 +39,7 @@
 #define	RELATIVESTRAND_HPP
 
 #include <map>
+#include <iostream>
 #include <boost/config.hpp>
 #include <boost/graph/adjacency_list.hpp>
 
@@ -109,21 +110,45 @@ class RelativeStrandEvidencesGraph : public PairedContigGraph< unsigned short in
         const Vertex &node
     );
 
-    void addEdgeWeights( const std::list<Block> &blocks ); //
+    void addEdgeWeights( const BlockSpan &blocks ); //
 
 public:
 
-    RelativeStrandEvidencesGraph(const std::list<Block> &blocks); //
+    RelativeStrandEvidencesGraph(const BlockSpan &blocks); //
 
     StrandProbMapPair computeRelativeStrandsWithRespectTo(const Vertex &node); //
 
     StrandProbMapPair computeRelativeStrands(); //
 
+    //! Computes the relative strands along a maximum evidence spanning tree.
+    /*!
+     * The tree is built with Prim's algorithm from \c node, using the number
+     * of evidences of the edges as weights, and each probability is composed
+     * along the tree path from \c node. Since the path between two vertices of
+     * a maximum spanning tree has the largest minimum number of evidences, it
+     * is the path the enumeration of computeRelativeStrandsWithRespectTo()
+     * trusts the most. It takes O(E log V) time, whatever the number of
+     * simple paths of the graph.
+     */
+    StrandProbMapPair computeTreeRelativeStrandsWithRespectTo(const Vertex &node);
+
+    //! Computes the relative strands along a maximum evidence spanning tree rooted at the first vertex.
+    StrandProbMapPair computeTreeRelativeStrands();
+
 }; // class RelativeStrandEvidencesGraph
 
 
+//! Computes the relative strand of the contigs of a set of blocks.
+/*!
+ * The solver is selected by the \c --strand-solver option: when the solvers
+ * are compared, the result of the path enumeration is returned and each
+ * contig with a different strand is reported.
+ */
 std::pair< std::map<int32_t,StrandProbability>, std::map<int32_t,StrandProbability> >
-computeRelativeStrandMap( const std::list<Block> &blocks );
+computeRelativeStrandMap( const BlockSpan &blocks );
+
+//! Writes how many strands of the two solvers have been compared and how many differ.
+void writeStrandSolverStats( std::ostream &os );
 
 #endif	/* RELATIVESTRAND_HPP */
 
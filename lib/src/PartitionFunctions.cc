@@ -35,7 +35,6 @@
 
 #include <boost/config.hpp>
 #include <boost/graph/connected_components.hpp>
-#include <boost/graph/topological_sort.hpp>
 #include <boost/filesystem.hpp>
 
 #include "api/BamAux.h"
@@ -54,119 +53,95 @@
 
 extern OptionsMerge g_options;
 
-extern std::ofstream _g_statsFile;
 
-extern MultiBamReader masterBam;
-extern MultiBamReader masterMpBam;
-extern MultiBamReader slaveBam;
-extern MultiBamReader slaveMpBam;
-
-std::list< CompactAssemblyGraph* >
-partitionBlocks( const std::list<Block> &blocks )
+CompactAssemblyGraph*
+buildCompactGraph(
+	const BlockSpan &blocks,
+	uint64_t agId,
+	MultiBamReader &masterBamReader, MultiBamReader &masterMpBamReader,
+	MultiBamReader &slaveBamReader, MultiBamReader &slaveMpBamReader,
+	AssemblyGraphKind &kind )
 {
-    typedef AssemblyGraph::vertex_iterator VertexIterator;
-    typedef AssemblyGraph::vertex_descriptor Vertex;
-    typedef AssemblyGraph::adjacency_iterator AdjacencyIterator;
-    typedef AssemblyGraph::inv_adjacency_iterator InvAdjacencyIterator;
+	std::stringstream ff1,ff2;
 
-    std::list< CompactAssemblyGraph* > outList;
+	// create an assembly graph
+	AssemblyGraph *ag = new AssemblyGraph( blocks, agId );
 
-	// group blocks between contigs which may be merged together through weaving
-    std::vector< std::list<Block> > pairedContigsBlocks = partitionBlocksByPairedContigs( blocks );
+	// collapse paths which shares the same master/slave contigs
+	CompactAssemblyGraph *cg = new CompactAssemblyGraph(*ag);
 
-    uint64_t agId = 1; // assembly graph counter
+	try
+	{
+		// check if graph contains cycles
+		std::vector< AssemblyGraph::Vertex > ts;
+		ag->topologicalSort( ts );
 
-    uint32_t ag_forks = 0, ag_linears = 0, ag_cycles = 0, ag_bubbles = 0; // counters for the different types of assemblies's graphs.
+		// at this point, ag does not contain cycles
 
-    // for each partition of blocks
-    std::vector< std::list<Block> >::iterator pcb;
-    for( pcb = pairedContigsBlocks.begin(); pcb != pairedContigsBlocks.end(); ++pcb )
-    {
-		std::stringstream ff1,ff2,ff3;
+		cg->computeEdgeWeights( masterBamReader, masterMpBamReader, slaveBamReader, slaveMpBamReader );
 
-        // create an assembly graph
-        AssemblyGraph *ag = new AssemblyGraph( *pcb, agId );
+		bool has_bubbles = ag->hasBubbles();
+		bool has_forks = ag->hasForks();
 
-		// collapse paths which shares the same master/slave contigs
-		CompactAssemblyGraph *cg = new CompactAssemblyGraph(*ag);
-		//std::cerr << "CompactAssemblyGraph_" << agId << " created." << std::endl;
-		cg->computeEdgeWeights( masterBam, masterMpBam, slaveBam, slaveMpBam );
-		//std::cerr << "CompactAssemblyGraph_" << agId << " weights computed." << std::endl;
+		ff1 << "./gam_graphs/AssemblyGraph_" << agId;
+		ff2 << "./gam_graphs/CompactGraph_" << agId;
 
-		try
+		if( has_bubbles )
 		{
-			// check if graph contains cycles
-			std::vector< size_t > ts;
-			boost::topological_sort( *ag, std::back_inserter(ts) );
-
-			// at this point, ag does not contain cycles
-
-			outList.push_back(cg);
-
-			bool has_bubbles = ag->hasBubbles();
-			bool has_forks = ag->hasForks();
-
-			ff1 << "./gam_graphs/AssemblyGraph_" << agId;
-			ff2 << "./gam_graphs/CompactGraph_" << agId;
-
-			if( has_bubbles )
-			{
-				ag_bubbles++;
-				ff1 << "_bubbles.dot";
-				ff2 << "_bubbles.dot";
-			}
-			else if( has_forks )
-			{
-				ag_forks++;
-				ff1 << "_forks.dot";
-				ff2 << "_forks.dot";
-			}
-			else
-			{
-				ag_linears++;
-				ff1 << "_linear.dot";
-				ff2 << "_linear.dot";
-			}
+			kind = BUBBLES_GRAPH;
+			ff1 << "_bubbles.dot";
+			ff2 << "_bubbles.dot";
 		}
-		catch( boost::not_a_dag ) // if the graph is cyclic.
+		else if( has_forks )
 		{
-			ag_cycles++;
-
-			ff1 << "./gam_graphs/AssemblyGraph_" << agId << "_cyclic.dot";
-			ff2 << "./gam_graphs/CompactGraph_" << agId << "_cyclic.dot";
+			kind = FORKS_GRAPH;
+			ff1 << "_forks.dot";
+			ff2 << "_forks.dot";
 		}
+		else
+		{
+			kind = LINEAR_GRAPH;
+			ff1 << "_linear.dot";
+			ff2 << "_linear.dot";
+		}
+	}
+	catch( boost::not_a_dag ) // if the graph is cyclic.
+	{
+		kind = CYCLIC_GRAPH;
 
-		if( g_options.outputGraphs )
+		ff1 << "./gam_graphs/AssemblyGraph_" << agId << "_cyclic.dot";
+		ff2 << "./gam_graphs/CompactGraph_" << agId << "_cyclic.dot";
+	}
+
+	if( g_options.outputGraphs )
+	{
+		boost::filesystem::path p1(ff1.str().c_str());
+		if( not boost::filesystem::exists(p1) )
 		{
-			boost::filesystem::path p1(ff1.str().c_str());
-			if( not boost::filesystem::exists(p1) )
-			{
-				std::ofstream ss( ff1.str().c_str() );
-				ag->writeGraphviz(ss);
-				ss.close();
-			}
+			std::ofstream ss( ff1.str().c_str() );
+			ag->writeGraphviz(ss);
+			ss.close();
+		}
 
-			boost::filesystem::path p2(ff2.str().c_str());
-			if( not boost::filesystem::exists(p2) )
-			{
-				std::ofstream ss( ff2.str().c_str() );
-				cg->writeGraphviz(ss);
-				ss.close();
-			}
+		boost::filesystem::path p2(ff2.str().c_str());
+		if( not boost::filesystem::exists(p2) )
+		{
+			std::ofstream ss( ff2.str().c_str() );
+			cg->writeGraphviz(ss);
+			ss.close();
 		}
+	}
 
-        agId++; // increase assembly graph counter
-		delete ag; // free AssemblyGraph
-    }
+	delete ag; // free AssemblyGraph
 
-    _g_statsFile << "[graphs stats]\n"
-		<< "Linears = " << ag_linears << "\n"
-		<< "Forks = " << ag_forks << "\n"
-		<< "Bubbles = " << ag_bubbles << "\n"
-		<< "Cyclics = " << ag_cycles << "\n"
-		<< std::endl;
+	// cyclic graphs are not merged
+	if( kind == CYCLIC_GRAPH )
+	{
+		delete cg;
+		return NULL;
+	}
 
-    return outList;
+	return cg;
 }
 
 
@@ -200,8 +175,6 @@ std::vector<double> computeZScore( MultiBamReader &multiBamReader, const uint64_
 		uint64_t inserts=0, spanCov=0;
 		int32_t nh, xt; // molteplicità delle read (nh->standard, xt->bwa)
 
-		multiBamReader.lockBamReader(i);
-
 		bamReader->SetRegion( refID, start, refID, end+1 );
 		while( bamReader->GetNextAlignmentCore(align) ) // for each read in the region
 		{
@@ -245,8 +218,6 @@ std::vector<double> computeZScore( MultiBamReader &multiBamReader, const uint64_
 			}
 		} // end while
 
-		multiBamReader.unlockBamReader(i);
-
 		if( inserts > minInsertNum )
 		{
 			double localMean = spanCov/(double)inserts;
@@ -258,8 +229,8 @@ std::vector<double> computeZScore( MultiBamReader &multiBamReader, const uint64_
 }
 
 
-std::vector< std::list<Block> >
-partitionBlocksByPairedContigs( const std::list< Block > &blocks )
+std::vector< BlockSpan >
+partitionBlocksByPairedContigs( std::vector<Block> &blocks )
 {
     typedef PairedContigGraph<> PCGraph;
     typedef boost::graph_traits< PCGraph >::vertex_descriptor Vertex;
@@ -270,13 +241,27 @@ partitionBlocksByPairedContigs( const std::list< Block > &blocks )
     std::vector< uint64_t > component( boost::num_vertices(pcg) );
     int num = boost::connected_components( pcg, &component[0] );
 
-    // each connected component consists of blocks of contigs which may be extended through weaving.
-    std::vector< std::list< Block > > pairedContigs(num);
-    for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); ++b )
+    // each connected component consists of blocks of contigs which may be extended through weaving:
+    // blocks are grouped by component (keeping their relative order) with a counting sort.
+    std::vector< uint64_t > blockComponent( blocks.size() );
+    std::vector< size_t > offsets( num+1, 0 );
+    for( size_t i=0; i < blocks.size(); i++ )
     {
-        Vertex v = pcg.getMasterVertex(*b);
-        pairedContigs.at( component.at(v) ).push_back(*b);
+        Vertex v = pcg.getMasterVertex( blocks[i] );
+        blockComponent[i] = component.at(v);
+        offsets[ blockComponent[i]+1 ]++;
     }
+    for( int c=1; c <= num; c++ ) offsets[c] += offsets[c-1];
+
+    std::vector< Block > sortedBlocks( blocks.size() );
+    std::vector< size_t > next( offsets.begin(), offsets.end()-1 );
+    for( size_t i=0; i < blocks.size(); i++ ) sortedBlocks[ next[blockComponent[i]]++ ] = blocks[i];
+
+    blocks.swap( sortedBlocks );
+
+    std::vector< BlockSpan > pairedContigs(num);
+    const Block *base = blocks.empty() ? NULL : &blocks[0];
+    for( int c=0; c < num; c++ ) pairedContigs[c] = BlockSpan( base + offsets[c], base + offsets[c+1] );
 
     // print pairedcontigs graphs
     for( UIntType i=0; i < pairedContigs.size(); i++ )
@@ -28,21 +28,374 @@
  *
  */
 
+
 #include <list>
 #include <limits>
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
+#include <vector>
+#include <cstdlib>
 #include <stdio.h>
 
 #include "alignment/banded_smith_waterman.hpp"
 
+namespace
+{
+
+typedef BandedSmithWaterman::int_type int_type;
+
+const int8_t SCORING_MATRIX[5][5] =
+{
+   // A   T   C   G   N
+   {  5, -4, -4, -4,  0 }, // A
+   { -4,  5, -4, -4,  0 }, // T
+   { -4, -4,  5, -4,  0 }, // C
+   { -4, -4, -4,  5,  0 }, // G
+   {  0,  0,  0,  0,  5 }, // N
+};
+
+const int64_t MAX_ABS_SCORE = 5; // largest absolute value in SCORING_MATRIX
+
+// vectorized fill of row i (false if no kernel is available)
+bool fill_row_vectorized( BandedKernelType kernel, const int16_t* prev, int16_t* cur, uint8_t* moves,
+                          size_t i, const BandedFillArgs& args )
+{
+    if( kernel >= BSW_KERNEL_AVX2 && bandedFillRowAVX2(prev,cur,moves,i,args) ) return true;
+    return kernel >= BSW_KERNEL_SSE41 && bandedFillRowSSE41(prev,cur,moves,i,args);
+}
+
+bool fill_row_vectorized( BandedKernelType kernel, const int32_t* prev, int32_t* cur, uint8_t* moves,
+                          size_t i, const BandedFillArgs& args )
+{
+    if( kernel >= BSW_KERNEL_AVX2 && bandedFillRowAVX2(prev,cur,moves,i,args) ) return true;
+    return kernel >= BSW_KERNEL_SSE41 && bandedFillRowSSE41(prev,cur,moves,i,args);
+}
+
+bool fill_row_vectorized( BandedKernelType, const int64_t*, int64_t*, uint8_t*, size_t, const BandedFillArgs& )
+{
+    return false;
+}
+
+bool fill_affine_row_vectorized( BandedKernelType kernel, const int16_t* prev_h, const int16_t* prev_e,
+                                 int16_t* cur_h, int16_t* cur_e, uint8_t* moves, size_t i, const BandedFillArgs& args )
+{
+    if( kernel >= BSW_KERNEL_AVX2 && bandedFillAffineRowAVX2(prev_h,prev_e,cur_h,cur_e,moves,i,args) ) return true;
+    return kernel >= BSW_KERNEL_SSE41 && bandedFillAffineRowSSE41(prev_h,prev_e,cur_h,cur_e,moves,i,args);
+}
+
+bool fill_affine_row_vectorized( BandedKernelType kernel, const int32_t* prev_h, const int32_t* prev_e,
+                                 int32_t* cur_h, int32_t* cur_e, uint8_t* moves, size_t i, const BandedFillArgs& args )
+{
+    if( kernel >= BSW_KERNEL_AVX2 && bandedFillAffineRowAVX2(prev_h,prev_e,cur_h,cur_e,moves,i,args) ) return true;
+    return kernel >= BSW_KERNEL_SSE41 && bandedFillAffineRowSSE41(prev_h,prev_e,cur_h,cur_e,moves,i,args);
+}
+
+bool fill_affine_row_vectorized( BandedKernelType, const int64_t*, const int64_t*, int64_t*, int64_t*, uint8_t*,
+                                 size_t, const BandedFillArgs& )
+{
+    return false;
+}
+
+// score of the cells with no gap (E) yet, as in the vector kernels
+template< typename CellType > struct AffineLimits;
+template<> struct AffineLimits< int16_t > { static const int16_t NEG_INF = -32768; };
+template<> struct AffineLimits< int32_t > { static const int32_t NEG_INF = -(1 << 29); };
+template<> struct AffineLimits< int64_t > { static const int64_t NEG_INF = -(int64_t(1) << 60); };
+
+// move taken by the traceback from cell (x,y), given rows x-1 and x
+template< typename CellType >
+uint8_t traceback_move( const BandedFillArgs& args, const CellType* prev, const CellType* cur, int_type x, int_type y )
+{
+    int_type y_size = args.y_size;
+    int_type pos = args.first_pos + x + y;
+    ScoreType score = args.score_tables[ 16*args.b_codes[x] + args.a_codes[x+y] ];
+
+    if( pos == 0 )
+    {
+        ScoreType diag = score;
+        ScoreType left = args.gap_score;
+
+        if( args.force_start && x > args.force_maxgap ) left = std::numeric_limits<int64_t>::min();
+
+        if( cur[y] == diag ) return BSW_MOVE_DIAG;
+        if( y == y_size-1 || cur[y] == left ) return BSW_MOVE_LEFT;
+        return BSW_MOVE_UP;
+    }
+
+    ScoreType diag = (x > 0 ? prev[y] : 0) + score;
+    ScoreType up = (x > 0 && y < y_size-1) ? prev[y+1] + args.gap_score : args.gap_score;
+
+    if( args.force_start && x == 0 && pos >= 0 && pos <= args.force_maxgap ) up = args.gap_score;
+    else if( args.force_start && x == 0 ) up = std::numeric_limits<int64_t>::min();
+
+    if( cur[y] == diag ) return BSW_MOVE_DIAG;
+    if( y < y_size-1 && y > 0 ) return cur[y] == up ? BSW_MOVE_UP : BSW_MOVE_LEFT;
+    return y < y_size-1 ? BSW_MOVE_UP : BSW_MOVE_LEFT; // up on the first diagonal, left on the last one
+}
+
+// initialization of the first row
+template< typename CellType >
+void fill_first_row( const BandedFillArgs& args, const ContigView& a, CellType* cur, uint8_t* moves )
+{
+    std::fill( cur, cur + args.stride, CellType(0) );
+
+    for( size_t j = 0; j < args.y_size; j++ )
+    {
+        int_type pos = args.first_pos + j;
+
+		if( (!args.force_start && pos >= 0 && pos < int_type(a.size())) || (args.force_start && pos >= 0 && pos <= args.force_maxgap ) )
+        {
+            ScoreType diag = SCORING_MATRIX[a.at(pos).base()][args.b_codes[0]]; // at() also checks forced starts on short contigs
+            ScoreType up = args.gap_score;
+            ScoreType left = (pos > 0 && j > 0) ? cur[j-1] : args.gap_score;
+
+            cur[j] = (pos > 0 && j > 0) ? std::max(std::max(diag,up),left) : std::max(up,diag);
+        }
+
+        if( args.force_start && pos > args.force_maxgap && pos < int_type(a.size()) )
+		{
+			ScoreType diag = SCORING_MATRIX[a.at(pos).base()][args.b_codes[0]];
+			ScoreType left = (pos > 0 && j > 0) ? cur[j-1] : args.gap_score;
+
+			cur[j] = (pos > 0 && j > 0) ? std::max(diag,left) : diag;
+		}
+
+        if( pos >= 0 && pos < args.a_size ) moves[j] = traceback_move( args, (const CellType*)NULL, cur, 0, j );
+    }
+}
+
+// fill of row i >= 1 from row i-1
+template< typename CellType >
+void fill_row( BandedKernelType kernel, const BandedFillArgs& args, size_t i,
+               const CellType* prev, CellType* cur, uint8_t* moves )
+{
+    int_type y_size = args.y_size;
+    int_type row_pos = args.first_pos + int_type(i); // position in a of cell (i,0)
+
+    if( fill_row_vectorized(kernel, prev, cur, moves, i, args) )
+    {
+        // kernels leave the move of the cell on the first base of a to us
+        if( row_pos <= 0 && -row_pos < y_size && args.a_size > 0 ) moves[-row_pos] = traceback_move( args, prev, cur, i, -row_pos );
+        return;
+    }
+
+    const int8_t* table = args.score_tables + 16*args.b_codes[i];
+    const uint8_t* a_row = args.a_codes + i;
+
+    for( int_type j = 0; j < y_size; j++ )
+    {
+        int_type pos = row_pos + j;
+
+        if( pos >= 0 && pos < args.a_size )
+        {
+            if( (!args.force_start && pos == 0) || (args.force_start && pos == 0 && int_type(i) <= args.force_maxgap ) )
+            {
+                ScoreType diag = table[ a_row[j] ];
+                ScoreType up = (j < y_size-1) ? prev[j+1] + args.gap_score : args.gap_score;
+                ScoreType left = args.gap_score;
+
+                cur[j] = (j < y_size-1) ? std::max(std::max(diag,up),left) : std::max(diag,left);
+            }
+            else if( args.force_start && pos == 0 && int_type(i) > args.force_maxgap )
+            {
+                ScoreType diag = table[ a_row[j] ];
+                ScoreType up = (j < y_size-1) ? prev[j+1] + args.gap_score : args.gap_score;
+
+                cur[j] = (j < y_size-1) ? std::max(diag,up) : diag;
+            }
+            else
+            {
+                ScoreType diag = prev[j] + table[ a_row[j] ];
+                ScoreType up = (j < y_size-1) ? prev[j+1] + args.gap_score : args.gap_score;
+                ScoreType left = (j > 0) ? cur[j-1] + args.gap_score : args.gap_score;
+
+                if( j < y_size-1 && j > 0 ){ cur[j] = std::max(std::max(diag,up),left); }
+                else if( j < y_size-1 ){ cur[j] = std::max( diag,up ); } // j == 0
+                else if( j > 0 ){ cur[j] = std::max( diag,left ); } // j == y_size-1
+                else { cur[j] = diag; } // j == 0 AND j == y_size-1 (only when _band_size == 0)
+            }
+
+            moves[j] = traceback_move( args, prev, cur, i, j );
+        }
+        else
+        {
+            cur[j] = 0;
+        }
+    }
+}
+
+// score of an alignment starting in cell (i,j) (i == 0 or on the first base of a) with affine
+// gaps: a forced start after more than FORCE_MAXGAP_LEN unaligned bases pays them as a gap
+ScoreType affine_start( const BandedFillArgs& args, int_type i, int_type j )
+{
+    int_type pos = args.first_pos + i + j;
+    int_type skipped = (pos == 0) ? i : pos; // bases of b (or of a) left out before the start
+    ScoreType start = args.score_tables[ 16*args.b_codes[i] + args.a_codes[i+j] ];
+
+    if( args.force_start && skipped > args.force_maxgap ) start += args.gap_score + (skipped-1) * args.gap_ext_score;
+    return start;
+}
+
+// initialization of the first row with affine gaps
+template< typename CellType >
+void fill_affine_first_row( const BandedFillArgs& args, CellType* cur_h, CellType* cur_e, uint8_t* moves )
+{
+    const CellType neg_inf = AffineLimits< CellType >::NEG_INF;
+
+    std::fill( cur_h, cur_h + args.stride, CellType(0) );
+    std::fill( cur_e, cur_e + args.stride, neg_inf );
+
+    ScoreType f = neg_inf;
+    bool has_left = false;
+
+    for( int_type j = 0; j < int_type(args.y_size); j++ )
+    {
+        int_type pos = args.first_pos + j;
+        if( pos < 0 || pos >= args.a_size ) continue;
+
+        ScoreType diag = affine_start( args, 0, j );
+        f = has_left ? std::max( ScoreType(cur_h[j-1]) + args.gap_score, f + args.gap_ext_score ) : ScoreType(neg_inf);
+
+        cur_h[j] = std::max( diag, f );
+        moves[j] = (cur_h[j] == diag) ? BSW_MOVE_DIAG : BSW_MOVE_LEFT;
+        if( has_left && f == cur_h[j-1] + args.gap_score ) moves[j] |= BSW_MOVE_F_OPEN;
+
+        has_left = true;
+    }
+}
+
+// fill of row i >= 1 from row i-1 with affine gaps: H holds the best scores and E the
+// scores of the alignments ending with a gap in a; gaps in b (F) are only needed along the row
+template< typename CellType >
+void fill_affine_row( BandedKernelType kernel, const BandedFillArgs& args, size_t i,
+                      const CellType* prev_h, const CellType* prev_e, CellType* cur_h, CellType* cur_e, uint8_t* moves )
+{
+    const CellType neg_inf = AffineLimits< CellType >::NEG_INF;
+    int_type y_size = args.y_size;
+    int_type row_pos = args.first_pos + int_type(i); // position in a of cell (i,0)
+
+    if( args.gap_score <= args.gap_ext_score && fill_affine_row_vectorized(kernel, prev_h, prev_e, cur_h, cur_e, moves, i, args) )
+    {
+        // kernels leave the move of the cell on the first base of a to us
+        if( row_pos <= 0 && -row_pos < y_size && args.a_size > 0 )
+        {
+            int_type j = -row_pos;
+            moves[j] = (cur_h[j] == affine_start(args, i, j)) ? BSW_MOVE_DIAG : BSW_MOVE_UP;
+            if( j < y_size-1 && cur_e[j] == prev_h[j+1] + args.gap_score ) moves[j] |= BSW_MOVE_E_OPEN;
+        }
+        return;
+    }
+
+    const int8_t* table = args.score_tables + 16*args.b_codes[i];
+    const uint8_t* a_row = args.a_codes + i;
+
+    ScoreType f = neg_inf;
+    bool has_left = false;
+
+    for( int_type j = 0; j < y_size; j++ )
+    {
+        int_type pos = row_pos + j;
+
+        if( pos < 0 || pos >= args.a_size )
+        {
+            cur_h[j] = 0;
+            cur_e[j] = neg_inf;
+            continue;
+        }
+
+        ScoreType e = (j < y_size-1) ? std::max( ScoreType(prev_h[j+1]) + args.gap_score, ScoreType(prev_e[j+1]) + args.gap_ext_score ) : ScoreType(neg_inf);
+        f = has_left ? std::max( ScoreType(cur_h[j-1]) + args.gap_score, f + args.gap_ext_score ) : ScoreType(neg_inf);
+        ScoreType diag = (pos == 0) ? affine_start( args, i, j ) : prev_h[j] + table[ a_row[j] ];
+
+        cur_h[j] = std::max( std::max(diag,e), f );
+        cur_e[j] = e;
+
+        // diagonal first, then gap in a, then gap in b; opening a gap is preferred to extending it
+        moves[j] = (cur_h[j] == diag) ? BSW_MOVE_DIAG : (cur_h[j] == e ? BSW_MOVE_UP : BSW_MOVE_LEFT);
+        if( j < y_size-1 && e == prev_h[j+1] + args.gap_score ) moves[j] |= BSW_MOVE_E_OPEN;
+        if( has_left && f == cur_h[j-1] + args.gap_score ) moves[j] |= BSW_MOVE_F_OPEN;
+
+        has_left = true;
+    }
+}
+
+// traceback moves of a block of consecutive rows, 2 bits per cell (4 with affine gaps)
+class BandedMoves
+{
+private:
+    size_t _first_row;
+    size_t _rows;
+    size_t _row_bytes;
+    unsigned _cell_bits;
+    std::vector< uint8_t > _bits;
+
+public:
+    BandedMoves() : _first_row(0), _rows(0), _row_bytes(0), _cell_bits(2) {}
+
+    void reset( size_t first_row, size_t rows, size_t y_size, unsigned cell_bits )
+    {
+        _first_row = first_row;
+        _rows = rows;
+        _cell_bits = cell_bits;
+        _row_bytes = (y_size * cell_bits + 7) / 8;
+        _bits.assign( rows * _row_bytes, 0 );
+    }
+
+    bool has_row( size_t i ) const { return i >= _first_row && i < _first_row + _rows; }
+
+    // stores the moves of row i (moves must have room for y_size rounded up to 4)
+    void set_row( size_t i, const uint8_t* moves )
+    {
+        uint8_t* row = &_bits[ (i - _first_row) * _row_bytes ];
+
+        if( _cell_bits == 2 )
+        {
+            for( size_t k = 0; k < _row_bytes; k++, moves += 4 )
+                row[k] = (moves[0] & 3) | ((moves[1] & 3) << 2) | ((moves[2] & 3) << 4) | ((moves[3] & 3) << 6);
+        }
+        else
+        {
+            for( size_t k = 0; k < _row_bytes; k++, moves += 2 ) row[k] = (moves[0] & 15) | ((moves[1] & 15) << 4);
+        }
+    }
+
+    uint8_t get( size_t i, size_t j ) const
+    {
+        size_t bit = j * _cell_bits;
+        return (_bits[ (i - _first_row) * _row_bytes + (bit >> 3) ] >> (bit & 7)) & ((1 << _cell_bits) - 1);
+    }
+};
+
+} // anonymous namespace
+
+BandedKernelType bandedKernelDetect()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if( __builtin_cpu_supports("avx2") ) return BSW_KERNEL_AVX2;
+    if( __builtin_cpu_supports("sse4.1") ) return BSW_KERNEL_SSE41;
+#endif
+    return BSW_KERNEL_SCALAR;
+}
+
+const char* bandedKernelName( BandedKernelType kernel )
+{
+    switch( kernel )
+    {
+        case BSW_KERNEL_AVX2: return "avx2";
+        case BSW_KERNEL_SSE41: return "sse4.1";
+        default: return "scalar";
+    }
+}
+
 BandedSmithWaterman::BandedSmithWaterman() :
         _match_score(MATCH_SCORE),
         _mismatch_score(MISMATCH_SCORE),
         _gap_score(GAP_SCORE),
         _gap_ext_score(GAP_EXT_SCORE),
-        _band_size(DEFAULT_BAND_SIZE)
+        _band_size(DEFAULT_BAND_SIZE),
+        _kernel(bandedKernelDetect()),
+        _gap_model(BSW_GAPS_LINEAR)
 {}
 
 BandedSmithWaterman::BandedSmithWaterman(
@@ -55,7 +408,9 @@ BandedSmithWaterman::BandedSmithWaterman(
         _mismatch_score(mismatch_score),
         _gap_score(gap_score),
         _gap_ext_score(gap_ext_score),
-        _band_size(band_size)
+        _band_size(band_size),
+        _kernel(bandedKernelDetect()),
+        _gap_model(BSW_GAPS_LINEAR)
 {}
 
 BandedSmithWaterman::BandedSmithWaterman( const size_type& band_size ) :
@@ -63,30 +418,46 @@ BandedSmithWaterman::BandedSmithWaterman( const size_type& band_size ) :
         _mismatch_score(MISMATCH_SCORE),
         _gap_score(GAP_SCORE),
         _gap_ext_score(GAP_EXT_SCORE),
-        _band_size(band_size)
+        _band_size(band_size),
+        _kernel(bandedKernelDetect()),
+        _gap_model(BSW_GAPS_LINEAR)
 {}
 
+void
+BandedSmithWaterman::set_kernel( BandedKernelType kernel )
+{
+    this->_kernel = std::min( kernel, bandedKernelDetect() );
+}
+
+BandedKernelType
+BandedSmithWaterman::kernel() const
+{
+    return this->_kernel;
+}
+
+void
+BandedSmithWaterman::set_gap_model( BandedGapModel gap_model )
+{
+    this->_gap_model = gap_model;
+}
+
+BandedGapModel
+BandedSmithWaterman::gap_model() const
+{
+    return this->_gap_model;
+}
+
 MyAlignment
 BandedSmithWaterman::find_alignment(
-        const Contig& a,
+        const ContigView& a,
         size_type begin_a,
         size_type end_a,
-        const Contig& b,
+        const ContigView& b,
         size_type begin_b,
         size_type end_b,
 		bool force_start,
 		bool force_end ) const
 {
-    int SCORING_MATRIX[5][5] =
-    {
-       // A   T   C   G   N
-       {  5, -4, -4, -4,  0 }, // A
-       { -4,  5, -4, -4,  0 }, // T
-       { -4, -4,  5, -4,  0 }, // C
-       { -4, -4, -4,  5,  0 }, // G
-       {  0,  0,  0,  0,  5 }, // N
-    };
-
     if( end_b < begin_b ) return MyAlignment();
 	if( end_b >= b.size() ) end_b = b.size()-1;
 
@@ -96,78 +467,123 @@ BandedSmithWaterman::find_alignment(
 
     size_type y_size = (2 * this->_band_size) + 1;
 
-    // allocate smith waterman matrix
-    //std::vector< std::vector<ScoreType> > sw( x_size, std::vector<ScoreType>(y_size) );
+    // every score is a path of at most 2*(x_size+y_size) moves: choose the
+    // narrowest cells that cannot overflow (kernels also add up to y_size gaps)
+    int64_t max_step = std::max( MAX_ABS_SCORE, int64_t(std::abs(this->_gap_score)) );
+    if( this->_gap_model == BSW_GAPS_AFFINE ) max_step = std::max( max_step, int64_t(std::abs(this->_gap_ext_score)) );
+    int64_t bound = max_step * int64_t(2 * (x_size + y_size) + 2);
 
-	ScoreType** sw = new ScoreType*[x_size];
-	for( size_type i=0; i < x_size; i++ )
-	{
-		sw[i] = new ScoreType[y_size];
-		for( size_type j=0; j < y_size; j++ ) sw[i][j] = 0;
-	}
+    // affine forced starts also pay the unaligned bases before them
+    if( this->_gap_model == BSW_GAPS_AFFINE && force_start ) bound += max_step * int64_t(begin_a + x_size + y_size + 1);
 
-	// end allocation sw diagonal matrix
+    if( bound < 32000 ) return align_band<int16_t>( a, begin_a, end_a, b, begin_b, x_size, force_start, force_end );
+    if( bound < (int64_t(1) << 28) ) return align_band<int32_t>( a, begin_a, end_a, b, begin_b, x_size, force_start, force_end );
+    return align_band<ScoreType>( a, begin_a, end_a, b, begin_b, x_size, force_start, force_end );
+}
+
+template< typename CellType >
+MyAlignment
+BandedSmithWaterman::align_band(
+        const ContigView& a,
+        size_type begin_a,
+        size_type end_a,
+        const ContigView& b,
+        size_type begin_b,
+        size_type x_size,
+		bool force_start,
+		bool force_end ) const
+{
+    size_type y_size = (2 * this->_band_size) + 1;
+    size_type stride = (y_size + 16) & ~size_type(15); // room for whole vectors and the up cell of the last one
+
+    // base codes of the two sequences and one score table for each base of b
+    int_type first_pos = int_type(begin_a) - int_type(this->_band_size);
+
+    std::vector< uint8_t > a_codes( x_size + stride + 16, uint8_t(N) );
+    int_type codes_begin = std::max( first_pos, int_type(0) );
+    int_type codes_end = std::min( first_pos + int_type(x_size + y_size), int_type(a.size()) );
+    if( codes_begin < codes_end ) a.codes( codes_begin, codes_end - codes_begin, &a_codes[codes_begin - first_pos] );
+
+    if( begin_b + x_size > b.size() ) throw std::out_of_range( "BandedSmithWaterman: b is too short" );
+    std::vector< uint8_t > b_codes( x_size + 1 );
+    b.codes( begin_b, x_size, &b_codes[0] );
+
+    int8_t score_tables[5*16] = {0};
+    for( int bb = 0; bb < 5; bb++ )
+        for( int ab = 0; ab < 5; ab++ ) score_tables[16*bb + ab] = SCORING_MATRIX[ab][bb];
+
+    BandedFillArgs args;
+    args.x_size = x_size;
+    args.y_size = y_size;
+    args.stride = stride;
+    args.a_codes = &a_codes[0];
+    args.b_codes = &b_codes[0];
+    args.first_pos = first_pos;
+    args.a_size = a.size();
+    args.score_tables = score_tables;
+    args.gap_score = int(this->_gap_score);
+    args.gap_ext_score = int(this->_gap_ext_score);
+    args.force_start = force_start;
+    args.force_maxgap = FORCE_MAXGAP_LEN;
+
+    // only two rows of scores are kept (plus one stride read past the second).
+    // Traceback moves take 2 bits per cell: when the band has more than
+    // BSW_TRACEBACK_BLOCK_CELLS cells, the row before each block of rows is
+    // saved and the moves of a block are recomputed when the traceback gets there.
+    // Affine gaps add a row of E scores and 2 bits per cell for the gap openings.
+    bool affine = (this->_gap_model == BSW_GAPS_AFFINE);
+    unsigned move_bits = affine ? 4 : 2;
+
+    std::vector< CellType > rows( 3 * stride, 0 );
+    CellType* prev = &rows[0];
+    CellType* cur = &rows[stride];
+    std::vector< CellType > e_rows( affine ? 3 * stride : 0, CellType(AffineLimits< CellType >::NEG_INF) );
+    CellType* prev_e = affine ? &e_rows[0] : NULL;
+    CellType* cur_e = affine ? &e_rows[stride] : NULL;
+    std::vector< uint8_t > row_moves( stride, 0 );
+
+    size_type block_rows = std::max( size_type(1), size_type(BSW_TRACEBACK_BLOCK_CELLS) * 2 / move_bits / y_size );
+    bool checkpoints_needed = block_rows < x_size;
+    std::vector< CellType > checkpoints;
+
+    BandedMoves moves;
+    if( !checkpoints_needed ) moves.reset( 0, x_size, y_size, move_bits );
+
+	// the last column of the band is visited with increasing i, as a scan of the whole matrix would do
+	int_type col_i = ( int_type(end_a) >= int_type(begin_a+_band_size) ) ? int_type(end_a) - int_type(begin_a+_band_size) : 0;
+	int_type col_j = ( int_type(end_a) >= int_type(begin_a+_band_size) ) ? int_type(2 * this->_band_size) : int_type(2 * this->_band_size - (begin_a + _band_size - end_a));
+    bool found_col_max = false;
+    int_type col_max_i = 0, col_max_j = 0;
+    ScoreType col_max_score = 0;
 
-    // initialization of the first row
-    for( size_type j = 0; j < y_size; j++ )
+    // fill SmithWaterman matrix
+    for( size_type i = 0; i < x_size; i++ )
     {
-        int_type pos = begin_a - this->_band_size + j;
+        if( affine && i == 0 ) fill_affine_first_row( args, cur, cur_e, &row_moves[0] );
+        else if( affine ) fill_affine_row( this->_kernel, args, i, prev, prev_e, cur, cur_e, &row_moves[0] );
+        else if( i == 0 ) fill_first_row( args, a, cur, &row_moves[0] );
+        else fill_row( this->_kernel, args, i, prev, cur, &row_moves[0] );
 
-		if( (!force_start && pos >= 0 && pos < a.size()) || (force_start && pos >= 0 && pos <= FORCE_MAXGAP_LEN ) )
+        if( !checkpoints_needed ) moves.set_row( i, &row_moves[0] );
+        else if( (i+1) % block_rows == 0 && i+1 < x_size )
         {
-            ScoreType diag = SCORING_MATRIX[a.at(pos).base()][b.at(begin_b).base()]; //(a.at(pos) == b.at(begin_b)) ? this->_match_score : this->_mismatch_score;
-            ScoreType up = this->_gap_score;
-            ScoreType left = (pos > 0 && j > 0) ? sw[0][j-1] : this->_gap_score;
-
-            sw[0][j] = (pos > 0 && j > 0) ? std::max(std::max(diag,up),left) : std::max(up,diag);
+            checkpoints.insert( checkpoints.end(), cur, cur + stride );
+            if( affine ) checkpoints.insert( checkpoints.end(), cur_e, cur_e + stride );
         }
 
-        if( force_start && pos > FORCE_MAXGAP_LEN && pos < a.size() )
-		{
-			ScoreType diag = SCORING_MATRIX[a.at(pos).base()][b.at(begin_b).base()]; //(a.at(pos) == b.at(begin_b)) ? this->_match_score : this->_mismatch_score;
-			ScoreType left = (pos > 0 && j > 0) ? sw[0][j-1] : this->_gap_score;
-
-			sw[0][j] = (pos > 0 && j > 0) ? std::max(diag,left) : diag;
-		}
-    }
-
-    // fill SmithWaterman matrix
-    for( size_type i = 1; i < x_size; i++ )
-    {
-        for( size_type j = 0; j < y_size; j++ )
+        int_type j = col_j - (int_type(i) - col_i);
+        if( int_type(i) >= col_i && j >= 0 && (!force_end || (force_end && i >= x_size-1-FORCE_MAXGAP_LEN && i < x_size)) )
         {
-            int_type pos = begin_a + i + j - this->_band_size;
-
-            if( pos >= 0 && pos < a.size() )
+            if( !found_col_max || cur[j] > col_max_score )
             {
-                if( (!force_start && pos == 0) || (force_start && pos == 0 && i <= FORCE_MAXGAP_LEN ) )
-                {
-                    ScoreType diag = SCORING_MATRIX[a.at(pos).base()][b.at(begin_b+i).base()]; // ((a.at(pos) == b.at(begin_b+i)) ? this->_match_score : this->_mismatch_score);
-                    ScoreType up = (j < y_size-1) ? sw[i-1][j+1] + this->_gap_score : this->_gap_score;
-                    ScoreType left = this->_gap_score;
-
-                    sw[i][j] = (j < y_size-1) ? std::max(std::max(diag,up),left) : std::max(diag,left);
-                }
-                else if( force_start && pos == 0 && i > FORCE_MAXGAP_LEN )
-				{
-					ScoreType diag = SCORING_MATRIX[a.at(pos).base()][b.at(begin_b+i).base()]; // ((a.at(pos) == b.at(begin_b+i)) ? this->_match_score : this->_mismatch_score);
-					ScoreType up = (j < y_size-1) ? sw[i-1][j+1] + this->_gap_score : this->_gap_score;
-
-					sw[i][j] = (j < y_size-1) ? std::max(diag,up) : diag;
-				}
-                else
-                {
-                    ScoreType diag = sw[i-1][j] + SCORING_MATRIX[a.at(pos).base()][b.at(begin_b+i).base()]; //((a.at(pos) == b.at(begin_b+i)) ? this->_match_score : this->_mismatch_score);
-                    ScoreType up = (j < y_size-1) ? sw[i-1][j+1] + this->_gap_score : this->_gap_score;
-                    ScoreType left = (j > 0) ? sw[i][j-1] + this->_gap_score : this->_gap_score;
-
-                    if( j < y_size-1 && j > 0 ){ sw[i][j] = std::max(std::max(diag,up),left); }
-                    else if( j < y_size-1 ){ sw[i][j] = std::max( diag,up ); } // j == 0
-                    else if( j > 0 ){ sw[i][j] = std::max( diag,left ); } // j == y_size-1
-                    else { sw[i][j] = diag; } // j == 0 AND j == y_size-1 (only when _band_size == 0)
-                }
+                found_col_max = true;
+                col_max_i = i; col_max_j = j;
+                col_max_score = cur[j];
             }
         }
+
+        std::swap( prev, cur );
+        std::swap( prev_e, cur_e );
     }
 
     // find max score
@@ -175,43 +591,30 @@ BandedSmithWaterman::find_alignment(
     int_type max_i = 0, max_j = 0;
     ScoreType max_score = 0;
 
-	// find possible max score in the last row
+	// find possible max score in the last row (now in prev)
 	for( size_type j = 0; !force_end && j < y_size; j++ )
 	{
 		int_type pos = begin_a + (x_size-1) + j - this->_band_size;
 
 		if( (!force_end && pos >= 0 && pos <= end_a) || (force_end && pos >= (end_a - FORCE_MAXGAP_LEN) && pos <= end_a) )
 		{
-			if( !found_max || sw[x_size-1][j] > max_score )
+			if( !found_max || prev[j] > max_score )
 			{
 				found_max = true;
 				max_i = x_size-1; max_j = j;
-				max_score = sw[x_size-1][j];
+				max_score = prev[j];
 			}
 		}
 	}
 
-	// find possible max score in the last column
-	//int_type j = 2 * this->_band_size;
-	//int_type i = ( int_type(a.size()) >= (begin_a+_band_size+1) ) ? int_type(a.size()) - (begin_a+_band_size+1) : 0;
-	int_type i = ( int_type(end_a) >= (begin_a+_band_size) ) ? int_type(end_a) - int_type(begin_a+_band_size) : 0;
-	int_type j = ( int_type(end_a) >= (begin_a+_band_size) ) ? 2 * this->_band_size : 2 * this->_band_size - (begin_a + _band_size - end_a);
-	for( ; i < x_size && j >= 0; i++ )
+	// the last column wins only with a strictly greater score
+	if( found_col_max && (!found_max || col_max_score > max_score) )
 	{
-		if( !force_end || (force_end && i >= x_size-1-FORCE_MAXGAP_LEN && i < x_size) )
-		{
-			if( !found_max || sw[i][j] > max_score )
-			{
-				found_max = true;
-				max_i = i; max_j = j;
-				max_score = sw[i][j];
-			}
-		}
-
-		j--;
+		found_max = true;
+		max_i = col_max_i; max_j = col_max_j;
+		max_score = col_max_score;
 	}
 
-
     if( !found_max ) return MyAlignment(); // this case shouldn't happen
 
     std::list< AlignmentAlphabet > edit_string;
@@ -221,103 +624,83 @@ BandedSmithWaterman::find_alignment(
     int_type y = max_j;
     int_type pos = begin_a + x + y - this->_band_size;
 	uint64_t num_of_matches = 0;
-
-    //std::cout << "max_x=" << x << "\tmax_y=" << y << "pos_a=" << pos << std::endl;
+    uint8_t state = BSW_MOVE_DIAG; // with affine gaps, BSW_MOVE_UP (LEFT) while inside a gap in a (b)
 
     while( x >= 0 && y >= 0 && pos >= 0 )
     {
-        if( pos == 0 )
-        {
-            ScoreType diag = SCORING_MATRIX[a.at(pos).base()][b.at(begin_b+x).base()]; // ((a.at(pos) == b.at(begin_b+x)) ? this->_match_score : this->_mismatch_score);
-            ScoreType up = (x > 0 && y < y_size-1) ? sw[x-1][y+1] + this->_gap_score : this->_gap_score;
-            ScoreType left = this->_gap_score;
+        const Nucleotide& base_a = a.at(pos);
+        const Nucleotide& base_b = b.at(begin_b + x);
 
-			if( force_start && x > FORCE_MAXGAP_LEN ) left = std::numeric_limits<int64_t>::min();
+        if( !moves.has_row(x) ) // recompute the block of rows from its checkpoint
+        {
+            size_type first = (x / block_rows) * block_rows;
+            size_type last = std::min( first + block_rows, x_size );
+            moves.reset( first, last - first, y_size, move_bits );
 
-            if( sw[x][y] == diag )
+            if( first == 0 )
             {
-				if( a.at(pos) == b.at(begin_b + x) || char(a.at(pos)) == 'N' || char(b.at(begin_b + x)) == 'N' )
-				{
-					edit_string.push_front(MATCH);
-					num_of_matches++;
-				}
-				else
-				{
-					edit_string.push_front(MISMATCH);
-				}
-				//edit_string.push_front( a.at(pos) == b.at(begin_b + x) ? MATCH : MISMATCH );
-                x--;
+                if( affine ) fill_affine_first_row( args, cur, cur_e, &row_moves[0] );
+                else fill_first_row( args, a, cur, &row_moves[0] );
+                moves.set_row( 0, &row_moves[0] );
             }
-            else if( y == y_size-1 || sw[x][y] == left )
+            else
             {
-                edit_string.push_front( GAP_B );
-                y--;
+                size_type saved_rows = affine ? 2 : 1;
+                typename std::vector< CellType >::const_iterator saved = checkpoints.begin() + (first/block_rows - 1) * saved_rows * stride;
+
+                std::copy( saved, saved + stride, cur );
+                if( affine ) std::copy( saved + stride, saved + 2*stride, cur_e );
             }
-            else
+            std::swap( prev, cur );
+            std::swap( prev_e, cur_e );
+
+            for( size_type i = std::max( first, size_type(1) ); i < last; i++ )
             {
-                edit_string.push_front( GAP_A );
-                x--;
-                y++;
+                if( affine ) fill_affine_row( this->_kernel, args, i, prev, prev_e, cur, cur_e, &row_moves[0] );
+                else fill_row( this->_kernel, args, i, prev, cur, &row_moves[0] );
+                moves.set_row( i, &row_moves[0] );
+                std::swap( prev, cur );
+                std::swap( prev_e, cur_e );
             }
         }
-        else
-        {
-			ScoreType diag = (x > 0 ? sw[x-1][y] : 0) + SCORING_MATRIX[a.at(pos).base()][b.at(begin_b+x).base()]; //((a.at(pos) == b.at(begin_b + x)) ? this->_match_score : this->_mismatch_score);
-            ScoreType up = (x > 0 && y < y_size-1) ? sw[x-1][y+1] + this->_gap_score : this->_gap_score;
-            ScoreType left = (y > 0) ? sw[x][y-1] + this->_gap_score : this->_gap_score;
 
-			if( force_start && x == 0 && pos >= 0 && pos <= FORCE_MAXGAP_LEN ) up = this->_gap_score;
-			else if( force_start && x == 0 ) up = std::numeric_limits<int64_t>::min();;
+        uint8_t move = moves.get(x,y);
+        uint8_t step = (state == BSW_MOVE_DIAG) ? (move & 3) : state;
 
-            if( sw[x][y] == diag )
-            {
-				if( a.at(pos) == b.at(begin_b + x) || char(a.at(pos)) == 'N' || char(b.at(begin_b + x)) == 'N' )
-				{
-					edit_string.push_front(MATCH);
-					num_of_matches++;
-				}
-				else
-				{
-					edit_string.push_front(MISMATCH);
-				}
-				//edit_string.push_front( a.at(pos) == b.at(begin_b+x) ? MATCH : MISMATCH );
-                x--;
-            }
-            else if( y < y_size-1 && y > 0 && sw[x][y] == up )
-            {
-                edit_string.push_front( GAP_A );
+        switch( step )
+        {
+            case BSW_MOVE_DIAG:
+                if( base_a == base_b || char(base_a) == 'N' || char(base_b) == 'N' )
+                {
+                    edit_string.push_front(MATCH);
+                    num_of_matches++;
+                }
+                else
+                {
+                    edit_string.push_front(MISMATCH);
+                }
                 x--;
-                y++;
-            }
-            else if( y < y_size-1 && y > 0 ) // left
-            {
-                edit_string.push_front( GAP_B );
-                y--;
-            }
-            else if( y < y_size-1 ) // y == 0 => up
-            {
+                break;
+
+            case BSW_MOVE_UP:
                 edit_string.push_front( GAP_A );
+                if( affine ) state = (move & BSW_MOVE_E_OPEN) ? BSW_MOVE_DIAG : BSW_MOVE_UP;
                 x--;
                 y++;
-            }
-            else // y == y_size-1 => left
-            {
+                break;
+
+            default:
                 edit_string.push_front( GAP_B );
+                if( affine ) state = (move & BSW_MOVE_F_OPEN) ? BSW_MOVE_DIAG : BSW_MOVE_LEFT;
                 y--;
-            }
         }
 
         pos = begin_a + x + y - this->_band_size;
     }
 
-    // deallocate sw matrix
-    for( size_type i=0; i < x_size; i++ ) delete[] sw[i];
-	delete[] sw;
-	// end of deallocation of sw matrix
-
     // identity of the sequences aligned
     double homology = (edit_string.size() == 0) ? 0 : double(num_of_matches * 100) / double(edit_string.size());
 
     MyAlignment sw_alignment( pos+1, begin_b+x+1, a.size(), b.size(), max_score, homology, edit_string );
     return sw_alignment;
-}
\ No newline at end of file
+}
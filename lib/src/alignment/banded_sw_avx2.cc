@@ -0,0 +1,201 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * AVX2 kernels of BandedSmithWaterman. This file is compiled with -mavx2
+ * and must not instantiate any inline function shared with the rest of the
+ * program, otherwise the linker could pick the AVX2 copy for generic code.
+ */
+
+#include "alignment/banded_sw_kernels.hpp"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+#include "alignment/banded_sw_kernels.code.hpp"
+
+namespace
+{
+
+// shifts v up by N bytes (N <= 16) across the two 128-bit halves, filling with fill
+template< int N >
+inline __m256i shift_up( __m256i v, __m256i fill )
+{
+    __m256i low = _mm256_permute2x128_si256( v, fill, 0x02 ); // [fill.lo, v.lo]
+    return _mm256_alignr_epi8( v, low, 16-N );
+}
+
+//! 16 lanes of 16-bit saturating cells.
+struct AVX2Ops16
+{
+    typedef int16_t cell_type;
+    typedef __m256i vec_type;
+
+    enum { LANES = 16 };
+    static const int16_t NEG_INF = -32768;
+
+    static inline vec_type load( const cell_type* p ) { return _mm256_loadu_si256( (const __m256i*)p ); }
+    static inline void store( cell_type* p, vec_type v ) { _mm256_storeu_si256( (__m256i*)p, v ); }
+    static inline vec_type set1( int x ) { return _mm256_set1_epi16( int16_t(x) ); }
+    static inline vec_type lane_index() { return _mm256_setr_epi16( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ); }
+    static inline vec_type add( vec_type a, vec_type b ) { return _mm256_adds_epi16( a, b ); }
+    static inline vec_type sub( vec_type a, vec_type b ) { return _mm256_subs_epi16( a, b ); }
+    static inline vec_type mullo( vec_type a, vec_type b ) { return _mm256_mullo_epi16( a, b ); }
+    static inline vec_type max( vec_type a, vec_type b ) { return _mm256_max_epi16( a, b ); }
+    static inline vec_type cmpgt( vec_type a, vec_type b ) { return _mm256_cmpgt_epi16( a, b ); }
+    static inline vec_type cmpeq( vec_type a, vec_type b ) { return _mm256_cmpeq_epi16( a, b ); }
+    static inline vec_type andnot( vec_type a, vec_type b ) { return _mm256_andnot_si256( a, b ); }
+    static inline vec_type bor( vec_type a, vec_type b ) { return _mm256_or_si256( a, b ); }
+    static inline vec_type band( vec_type a, vec_type b ) { return _mm256_and_si256( a, b ); }
+    static inline vec_type select( vec_type mask, vec_type a, vec_type b ) { return _mm256_blendv_epi8( b, a, mask ); }
+
+    static inline vec_type scores( const uint8_t* codes, const int8_t* table )
+    {
+        __m128i c = _mm_loadu_si128( (const __m128i*)codes );
+        __m128i t = _mm_loadu_si128( (const __m128i*)table );
+        return _mm256_cvtepi8_epi16( _mm_shuffle_epi8(t,c) );
+    }
+
+    static inline vec_type prefix_max( vec_type v, vec_type ninf )
+    {
+        v = _mm256_max_epi16( v, shift_up<2>(v,ninf) );
+        v = _mm256_max_epi16( v, shift_up<4>(v,ninf) );
+        v = _mm256_max_epi16( v, shift_up<8>(v,ninf) );
+        v = _mm256_max_epi16( v, shift_up<16>(v,ninf) );
+        return v;
+    }
+
+    static inline void store_bytes( uint8_t* p, vec_type v )
+    {
+        __m256i packed = _mm256_permute4x64_epi64( _mm256_packus_epi16(v,v), 0x08 );
+        _mm_storeu_si128( (__m128i*)p, _mm256_castsi256_si128(packed) );
+    }
+
+    // lane k gets v[k-1], lane 0 gets the (broadcast) carry
+    static inline vec_type shift_in( vec_type v, vec_type carry ) { return shift_up<2>( v, carry ); }
+
+    static inline vec_type broadcast_last( vec_type v )
+    {
+        __m256i top = _mm256_permute4x64_epi64( v, 0xFF );
+        return _mm256_shufflehi_epi16( _mm256_shufflelo_epi16(top,0xFF), 0xFF );
+    }
+};
+
+//! 8 lanes of 32-bit cells.
+struct AVX2Ops32
+{
+    typedef int32_t cell_type;
+    typedef __m256i vec_type;
+
+    enum { LANES = 8 };
+    static const int32_t NEG_INF = -(1 << 29);
+
+    static inline vec_type load( const cell_type* p ) { return _mm256_loadu_si256( (const __m256i*)p ); }
+    static inline void store( cell_type* p, vec_type v ) { _mm256_storeu_si256( (__m256i*)p, v ); }
+    static inline vec_type set1( int x ) { return _mm256_set1_epi32( x ); }
+    static inline vec_type lane_index() { return _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ); }
+    static inline vec_type add( vec_type a, vec_type b ) { return _mm256_add_epi32( a, b ); }
+    static inline vec_type sub( vec_type a, vec_type b ) { return _mm256_sub_epi32( a, b ); }
+    static inline vec_type mullo( vec_type a, vec_type b ) { return _mm256_mullo_epi32( a, b ); }
+    static inline vec_type max( vec_type a, vec_type b ) { return _mm256_max_epi32( a, b ); }
+    static inline vec_type cmpgt( vec_type a, vec_type b ) { return _mm256_cmpgt_epi32( a, b ); }
+    static inline vec_type cmpeq( vec_type a, vec_type b ) { return _mm256_cmpeq_epi32( a, b ); }
+    static inline vec_type andnot( vec_type a, vec_type b ) { return _mm256_andnot_si256( a, b ); }
+    static inline vec_type bor( vec_type a, vec_type b ) { return _mm256_or_si256( a, b ); }
+    static inline vec_type band( vec_type a, vec_type b ) { return _mm256_and_si256( a, b ); }
+    static inline vec_type select( vec_type mask, vec_type a, vec_type b ) { return _mm256_blendv_epi8( b, a, mask ); }
+
+    static inline vec_type scores( const uint8_t* codes, const int8_t* table )
+    {
+        __m128i c = _mm_loadl_epi64( (const __m128i*)codes );
+        __m128i t = _mm_loadu_si128( (const __m128i*)table );
+        return _mm256_cvtepi8_epi32( _mm_shuffle_epi8(t,c) );
+    }
+
+    static inline vec_type prefix_max( vec_type v, vec_type ninf )
+    {
+        v = _mm256_max_epi32( v, shift_up<4>(v,ninf) );
+        v = _mm256_max_epi32( v, shift_up<8>(v,ninf) );
+        v = _mm256_max_epi32( v, shift_up<16>(v,ninf) );
+        return v;
+    }
+
+    static inline void store_bytes( uint8_t* p, vec_type v )
+    {
+        __m256i w = _mm256_packs_epi32( v, v );
+        __m256i packed = _mm256_permutevar8x32_epi32( _mm256_packus_epi16(w,w), _mm256_setr_epi32(0,4,0,0,0,0,0,0) );
+        _mm_storel_epi64( (__m128i*)p, _mm256_castsi256_si128(packed) );
+    }
+
+    static inline vec_type shift_in( vec_type v, vec_type carry ) { return shift_up<4>( v, carry ); }
+
+    static inline vec_type broadcast_last( vec_type v )
+    {
+        return _mm256_permutevar8x32_epi32( v, _mm256_set1_epi32(7) );
+    }
+};
+
+} // anonymous namespace
+
+bool bandedFillRowAVX2( const int16_t* prev, int16_t* cur, uint8_t* moves, size_t i, const BandedFillArgs& args )
+{
+    bandedFillRow<AVX2Ops16>( prev, cur, moves, i, args );
+    return true;
+}
+
+bool bandedFillAffineRowAVX2( const int16_t* prev_h, const int16_t* prev_e, int16_t* cur_h, int16_t* cur_e, uint8_t* moves,
+                          size_t i, const BandedFillArgs& args )
+{
+    bandedFillAffineRow<AVX2Ops16>( prev_h, prev_e, cur_h, cur_e, moves, i, args );
+    return true;
+}
+
+bool bandedFillRowAVX2( const int32_t* prev, int32_t* cur, uint8_t* moves, size_t i, const BandedFillArgs& args )
+{
+    bandedFillRow<AVX2Ops32>( prev, cur, moves, i, args );
+    return true;
+}
+
+bool bandedFillAffineRowAVX2( const int32_t* prev_h, const int32_t* prev_e, int32_t* cur_h, int32_t* cur_e, uint8_t* moves,
+                          size_t i, const BandedFillArgs& args )
+{
+    bandedFillAffineRow<AVX2Ops32>( prev_h, prev_e, cur_h, cur_e, moves, i, args );
+    return true;
+}
+
+#else // __AVX2__
+
+bool bandedFillRowAVX2( const int16_t*, int16_t*, uint8_t*, size_t, const BandedFillArgs& ) { return false; }
+bool bandedFillAffineRowAVX2( const int16_t*, const int16_t*, int16_t*, int16_t*, uint8_t*, size_t, const BandedFillArgs& ) { return false; }
+bool bandedFillRowAVX2( const int32_t*, int32_t*, uint8_t*, size_t, const BandedFillArgs& ) { return false; }
+bool bandedFillAffineRowAVX2( const int32_t*, const int32_t*, int32_t*, int32_t*, uint8_t*, size_t, const BandedFillArgs& ) { return false; }
+
+#endif // __AVX2__
@@ -0,0 +1,185 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * SSE4.1 kernels of BandedSmithWaterman. This file is compiled with -msse4.1
+ * and must not instantiate any inline function shared with the rest of the
+ * program, otherwise the linker could pick the SSE4.1 copy for generic code.
+ */
+
+#include "alignment/banded_sw_kernels.hpp"
+
+#ifdef __SSE4_1__
+
+#include <string.h>
+#include <smmintrin.h>
+
+#include "alignment/banded_sw_kernels.code.hpp"
+
+namespace
+{
+
+//! 8 lanes of 16-bit saturating cells.
+struct SSE41Ops16
+{
+    typedef int16_t cell_type;
+    typedef __m128i vec_type;
+
+    enum { LANES = 8 };
+    static const int16_t NEG_INF = -32768;
+
+    static inline vec_type load( const cell_type* p ) { return _mm_loadu_si128( (const __m128i*)p ); }
+    static inline void store( cell_type* p, vec_type v ) { _mm_storeu_si128( (__m128i*)p, v ); }
+    static inline vec_type set1( int x ) { return _mm_set1_epi16( int16_t(x) ); }
+    static inline vec_type lane_index() { return _mm_setr_epi16( 0, 1, 2, 3, 4, 5, 6, 7 ); }
+    static inline vec_type add( vec_type a, vec_type b ) { return _mm_adds_epi16( a, b ); }
+    static inline vec_type sub( vec_type a, vec_type b ) { return _mm_subs_epi16( a, b ); }
+    static inline vec_type mullo( vec_type a, vec_type b ) { return _mm_mullo_epi16( a, b ); }
+    static inline vec_type max( vec_type a, vec_type b ) { return _mm_max_epi16( a, b ); }
+    static inline vec_type cmpgt( vec_type a, vec_type b ) { return _mm_cmpgt_epi16( a, b ); }
+    static inline vec_type cmpeq( vec_type a, vec_type b ) { return _mm_cmpeq_epi16( a, b ); }
+    static inline vec_type andnot( vec_type a, vec_type b ) { return _mm_andnot_si128( a, b ); }
+    static inline vec_type bor( vec_type a, vec_type b ) { return _mm_or_si128( a, b ); }
+    static inline vec_type band( vec_type a, vec_type b ) { return _mm_and_si128( a, b ); }
+    static inline vec_type select( vec_type mask, vec_type a, vec_type b ) { return _mm_blendv_epi8( b, a, mask ); }
+
+    static inline vec_type scores( const uint8_t* codes, const int8_t* table )
+    {
+        __m128i c = _mm_loadl_epi64( (const __m128i*)codes );
+        __m128i t = _mm_loadu_si128( (const __m128i*)table );
+        return _mm_cvtepi8_epi16( _mm_shuffle_epi8(t,c) );
+    }
+
+    static inline vec_type prefix_max( vec_type v, vec_type ninf )
+    {
+        v = _mm_max_epi16( v, _mm_alignr_epi8(v,ninf,14) );
+        v = _mm_max_epi16( v, _mm_alignr_epi8(v,ninf,12) );
+        v = _mm_max_epi16( v, _mm_alignr_epi8(v,ninf,8) );
+        return v;
+    }
+
+    static inline void store_bytes( uint8_t* p, vec_type v ) { _mm_storel_epi64( (__m128i*)p, _mm_packus_epi16(v,v) ); }
+
+    // lane k gets v[k-1], lane 0 gets the (broadcast) carry
+    static inline vec_type shift_in( vec_type v, vec_type carry ) { return _mm_alignr_epi8( v, carry, 14 ); }
+
+    static inline vec_type broadcast_last( vec_type v )
+    {
+        return _mm_shuffle_epi32( _mm_shufflehi_epi16(v,0xFF), 0xFF );
+    }
+};
+
+//! 4 lanes of 32-bit cells.
+struct SSE41Ops32
+{
+    typedef int32_t cell_type;
+    typedef __m128i vec_type;
+
+    enum { LANES = 4 };
+    static const int32_t NEG_INF = -(1 << 29);
+
+    static inline vec_type load( const cell_type* p ) { return _mm_loadu_si128( (const __m128i*)p ); }
+    static inline void store( cell_type* p, vec_type v ) { _mm_storeu_si128( (__m128i*)p, v ); }
+    static inline vec_type set1( int x ) { return _mm_set1_epi32( x ); }
+    static inline vec_type lane_index() { return _mm_setr_epi32( 0, 1, 2, 3 ); }
+    static inline vec_type add( vec_type a, vec_type b ) { return _mm_add_epi32( a, b ); }
+    static inline vec_type sub( vec_type a, vec_type b ) { return _mm_sub_epi32( a, b ); }
+    static inline vec_type mullo( vec_type a, vec_type b ) { return _mm_mullo_epi32( a, b ); }
+    static inline vec_type max( vec_type a, vec_type b ) { return _mm_max_epi32( a, b ); }
+    static inline vec_type cmpgt( vec_type a, vec_type b ) { return _mm_cmpgt_epi32( a, b ); }
+    static inline vec_type cmpeq( vec_type a, vec_type b ) { return _mm_cmpeq_epi32( a, b ); }
+    static inline vec_type andnot( vec_type a, vec_type b ) { return _mm_andnot_si128( a, b ); }
+    static inline vec_type bor( vec_type a, vec_type b ) { return _mm_or_si128( a, b ); }
+    static inline vec_type band( vec_type a, vec_type b ) { return _mm_and_si128( a, b ); }
+    static inline vec_type select( vec_type mask, vec_type a, vec_type b ) { return _mm_blendv_epi8( b, a, mask ); }
+
+    static inline vec_type scores( const uint8_t* codes, const int8_t* table )
+    {
+        int32_t packed;
+        memcpy( &packed, codes, sizeof(packed) );
+        __m128i t = _mm_loadu_si128( (const __m128i*)table );
+        return _mm_cvtepi8_epi32( _mm_shuffle_epi8(t,_mm_cvtsi32_si128(packed)) );
+    }
+
+    static inline vec_type prefix_max( vec_type v, vec_type ninf )
+    {
+        v = _mm_max_epi32( v, _mm_alignr_epi8(v,ninf,12) );
+        v = _mm_max_epi32( v, _mm_alignr_epi8(v,ninf,8) );
+        return v;
+    }
+
+    static inline void store_bytes( uint8_t* p, vec_type v )
+    {
+        __m128i w = _mm_packs_epi32( v, v );
+        int32_t packed = _mm_cvtsi128_si32( _mm_packus_epi16(w,w) );
+        memcpy( p, &packed, sizeof(packed) );
+    }
+
+    static inline vec_type shift_in( vec_type v, vec_type carry ) { return _mm_alignr_epi8( v, carry, 12 ); }
+
+    static inline vec_type broadcast_last( vec_type v ) { return _mm_shuffle_epi32( v, 0xFF ); }
+};
+
+} // anonymous namespace
+
+bool bandedFillRowSSE41( const int16_t* prev, int16_t* cur, uint8_t* moves, size_t i, const BandedFillArgs& args )
+{
+    bandedFillRow<SSE41Ops16>( prev, cur, moves, i, args );
+    return true;
+}
+
+bool bandedFillAffineRowSSE41( const int16_t* prev_h, const int16_t* prev_e, int16_t* cur_h, int16_t* cur_e, uint8_t* moves,
+                          size_t i, const BandedFillArgs& args )
+{
+    bandedFillAffineRow<SSE41Ops16>( prev_h, prev_e, cur_h, cur_e, moves, i, args );
+    return true;
+}
+
+bool bandedFillRowSSE41( const int32_t* prev, int32_t* cur, uint8_t* moves, size_t i, const BandedFillArgs& args )
+{
+    bandedFillRow<SSE41Ops32>( prev, cur, moves, i, args );
+    return true;
+}
+
+bool bandedFillAffineRowSSE41( const int32_t* prev_h, const int32_t* prev_e, int32_t* cur_h, int32_t* cur_e, uint8_t* moves,
+                          size_t i, const BandedFillArgs& args )
+{
+    bandedFillAffineRow<SSE41Ops32>( prev_h, prev_e, cur_h, cur_e, moves, i, args );
+    return true;
+}
+
+#else // __SSE4_1__
+
+bool bandedFillRowSSE41( const int16_t*, int16_t*, uint8_t*, size_t, const BandedFillArgs& ) { return false; }
+bool bandedFillAffineRowSSE41( const int16_t*, const int16_t*, int16_t*, int16_t*, uint8_t*, size_t, const BandedFillArgs& ) { return false; }
+bool bandedFillRowSSE41( const int32_t*, int32_t*, uint8_t*, size_t, const BandedFillArgs& ) { return false; }
+bool bandedFillAffineRowSSE41( const int32_t*, const int32_t*, int32_t*, int32_t*, uint8_t*, size_t, const BandedFillArgs& ) { return false; }
+
+#endif // __SSE4_1__
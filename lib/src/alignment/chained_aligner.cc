@@ -0,0 +1,398 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "alignment/chained_aligner.hpp"
+
+namespace
+{
+
+typedef ChainedAligner::int_type int_type;
+typedef ChainedAligner::size_type size_type;
+
+const ScoreType NEG_INF = -(ScoreType(1) << 60);
+
+// invertible hash of a packed k-mer, so that minimizers are not biased towards low-complexity words
+inline uint64_t hash_kmer( uint64_t key, uint64_t mask )
+{
+    key = (~key + (key << 21)) & mask;
+    key = key ^ (key >> 24);
+    key = ((key + (key << 3)) + (key << 8)) & mask;
+    key = key ^ (key >> 14);
+    key = ((key + (key << 2)) + (key << 4)) & mask;
+    key = key ^ (key >> 28);
+    key = (key + (key << 31)) & mask;
+    return key;
+}
+
+// scores of BandedSmithWaterman: N only matches N
+inline ScoreType base_score( BaseType x, BaseType y )
+{
+    if( x == y ) return MATCH_SCORE;
+    return (x == N || y == N) ? 0 : MISMATCH_SCORE;
+}
+
+// edit operation of two aligned bases (N matches everything, as in BandedSmithWaterman's traceback)
+inline AlignmentAlphabet base_op( BaseType x, BaseType y )
+{
+    return (x == y || x == N || y == N) ? MATCH : MISMATCH;
+}
+
+} // anonymous namespace
+
+
+ChainedAligner::ChainedAligner( size_type k, size_type w ) :
+        _k( std::max( size_type(1), std::min( k, size_type(32) ) ) ),
+        _w( std::max( size_type(1), w ) )
+{}
+
+
+void
+ChainedAligner::find_minimizers( const ContigView& c, size_type begin, size_type end, std::vector< MinimizerType >& minimizers ) const
+{
+    const uint64_t mask = (this->_k < 32) ? (uint64_t(1) << (2*this->_k)) - 1 : ~uint64_t(0);
+    const uint64_t none = std::numeric_limits<uint64_t>::max();
+
+    minimizers.clear();
+
+    // hashes of the last w k-mers (none for k-mers with an N)
+    std::vector< MinimizerType > window( this->_w, MinimizerType(none,0) );
+    size_type min_slot = 0;
+    uint64_t code = 0;
+    size_type valid = 0; // bases since the last N
+    uint8_t bases[256];
+
+    for( size_type pos = begin; pos <= end; pos++ )
+    {
+        size_type idx = (pos - begin) % sizeof(bases);
+        if( idx == 0 ) c.codes( pos, std::min( size_type(sizeof(bases)), end + 1 - pos ), bases );
+
+        uint8_t base = bases[idx];
+
+        if( base >= N ) valid = 0;
+        else { code = ((code << 2) | uint64_t(base)) & mask; valid++; }
+
+        if( pos + 1 < begin + this->_k ) continue;
+
+        size_type kmer_pos = pos + 1 - this->_k;
+        size_type slot = (kmer_pos - begin) % this->_w;
+        window[slot] = MinimizerType( valid >= this->_k ? hash_kmer(code,mask) : none, kmer_pos );
+
+        if( slot == min_slot || window[slot].first < window[min_slot].first )
+        {
+            if( slot == min_slot ) // the minimum left the window: look for the new one
+            {
+                for( size_type s = 0; s < this->_w; s++ )
+                    if( window[s].first < window[min_slot].first || (window[s].first == window[min_slot].first && window[s].second < window[min_slot].second) )
+                        min_slot = s;
+            }
+            else
+            {
+                min_slot = slot;
+            }
+        }
+
+        if( kmer_pos + 1 < begin + this->_w || window[min_slot].first == none ) continue;
+        if( minimizers.empty() || minimizers.back().second != window[min_slot].second ) minimizers.push_back( window[min_slot] );
+    }
+}
+
+
+void
+ChainedAligner::find_chain( const ContigView& a, size_type begin_a, size_type end_a, const ContigView& b, size_type begin_b, size_type end_b )
+{
+    this->_chain.clear();
+    this->_anchors.clear();
+
+    if( end_a + 1 < begin_a + this->_k || end_b + 1 < begin_b + this->_k ) return;
+
+    // anchors: minimizers of b found in a (except the repetitive ones)
+    this->find_minimizers( a, begin_a, end_a, this->_a_minimizers );
+    this->find_minimizers( b, begin_b, end_b, this->_b_minimizers );
+    std::sort( this->_a_minimizers.begin(), this->_a_minimizers.end() );
+
+    for( size_t i = 0; i < this->_b_minimizers.size(); i++ )
+    {
+        std::vector< MinimizerType >::const_iterator lo = std::lower_bound( this->_a_minimizers.begin(), this->_a_minimizers.end(),
+                                                                            MinimizerType(this->_b_minimizers[i].first,0) );
+        std::vector< MinimizerType >::const_iterator hi = lo;
+        while( hi != this->_a_minimizers.end() && hi->first == this->_b_minimizers[i].first ) hi++;
+
+        if( hi - lo > CHAIN_MAX_OCC ) continue;
+        for( ; lo != hi; lo++ ) this->_anchors.push_back( AnchorType( lo->second, this->_b_minimizers[i].second ) );
+    }
+
+    if( this->_anchors.empty() ) return;
+    std::sort( this->_anchors.begin(), this->_anchors.end() );
+
+    // collinear chaining: anchors gain the bases they add, gaps between them cost
+    // proportionally to the difference of the distances in a and in b
+    size_t n = this->_anchors.size();
+    const double k = double(this->_k);
+
+    this->_chain_scores.assign( n, k );
+    this->_chain_preds.assign( n, -1 );
+    size_t best = 0;
+
+    for( size_t i = 0; i < n; i++ )
+    {
+        const AnchorType& cur = this->_anchors[i];
+
+        for( size_t j = i; j-- > 0 && i - j <= CHAIN_LOOKBACK; )
+        {
+            const AnchorType& prev = this->_anchors[j];
+            int_type dx = cur.first - prev.first;
+            int_type dy = cur.second - prev.second;
+
+            if( dx > CHAIN_MAX_GAP ) break;
+            if( dx <= 0 || dy <= 0 || dy > CHAIN_MAX_GAP ) continue;
+
+            int_type gap = dx > dy ? dx - dy : dy - dx;
+            double gain = double( std::min( std::min(dx,dy), int_type(this->_k) ) );
+            double cost = (gap == 0) ? 0 : 0.01 * k * double(gap) + 0.5 * std::log( double(gap) ) / std::log(2.0);
+            double score = this->_chain_scores[j] + gain - cost;
+
+            if( score > this->_chain_scores[i] )
+            {
+                this->_chain_scores[i] = score;
+                this->_chain_preds[i] = j;
+            }
+        }
+
+        if( this->_chain_scores[i] > this->_chain_scores[best] ) best = i;
+    }
+
+    for( int_type i = best; i >= 0; i = this->_chain_preds[i] ) this->_chain.push_back( this->_anchors[i] );
+    std::reverse( this->_chain.begin(), this->_chain.end() );
+}
+
+
+/* Aligns the la bases a[a0], a[a0+dir], ... with the lb bases b[b0], b[b0+dir], ...
+ * on the diagonals around the one joining the two ends. The alignment ends at
+ * (la,lb) or, when extending, at the best cell: la and lb are then set to the
+ * bases actually aligned. Edit operations are left in _segment, in the order of
+ * the walk from (a0,b0).
+ */
+ScoreType
+ChainedAligner::align_segment( const ContigView& a, int_type a0, size_type& la, const ContigView& b, int_type b0, size_type& lb,
+                               int dir, bool extend )
+{
+    this->_segment.clear();
+
+    int_type diff = int_type(lb) - int_type(la);
+    int_type lo = extend ? -CHAIN_BAND : std::min( int_type(0), diff ) - CHAIN_BAND;
+    int_type hi = extend ? CHAIN_BAND : std::max( int_type(0), diff ) + CHAIN_BAND;
+    size_type width = hi - lo + 1;
+
+    if( !extend && (la+1) * width > size_type(CHAIN_MAX_SEGMENT_CELLS) )
+    {
+        // too far apart to be worth aligning: bases side by side, then the gap
+        ScoreType score = 0;
+        for( size_type i = 0; i < std::min(la,lb); i++ )
+        {
+            BaseType x = a.base( a0 + dir*int_type(i) ), y = b.base( b0 + dir*int_type(i) );
+            score += base_score(x,y);
+            this->_segment.push_back( base_op(x,y) );
+        }
+        for( size_type i = lb; i < la; i++ ){ score += GAP_SCORE; this->_segment.push_back( GAP_B ); }
+        for( size_type i = la; i < lb; i++ ){ score += GAP_SCORE; this->_segment.push_back( GAP_A ); }
+
+        return score;
+    }
+
+    // cell (i,j) of the band is column k = j-i-lo of row i; moves: 0 diagonal, 1 gap in b, 2 gap in a
+    this->_rows.assign( 2*width, NEG_INF );
+    this->_moves.assign( (la+1) * width, 0 );
+    ScoreType* prev = &this->_rows[0];
+    ScoreType* cur = &this->_rows[width];
+
+    ScoreType best_score = 0;
+    size_type best_i = 0, best_j = 0;
+
+    for( size_type i = 0; i <= la; i++ )
+    {
+        for( size_type k = 0; k < width; k++ )
+        {
+            int_type j = int_type(i) + lo + int_type(k);
+            cur[k] = NEG_INF;
+
+            if( j < 0 || j > int_type(lb) ) continue;
+            if( i == 0 && j == 0 ){ cur[k] = 0; continue; }
+
+            ScoreType h = NEG_INF;
+            uint8_t move = 0;
+
+            if( i > 0 && j > 0 ){ h = prev[k] + base_score( a.base( a0 + dir*int_type(i-1) ), b.base( b0 + dir*(j-1) ) ); }
+            if( i > 0 && k+1 < width && prev[k+1] + GAP_SCORE > h ){ h = prev[k+1] + GAP_SCORE; move = 1; }
+            if( j > 0 && k > 0 && cur[k-1] + GAP_SCORE > h ){ h = cur[k-1] + GAP_SCORE; move = 2; }
+
+            cur[k] = h;
+            this->_moves[ i*width + k ] = move;
+
+            if( extend && h > best_score ){ best_score = h; best_i = i; best_j = j; }
+        }
+
+        std::swap( prev, cur );
+    }
+
+    if( !extend )
+    {
+        best_i = la; best_j = lb;
+        best_score = prev[ diff - lo ];
+    }
+
+    // traceback
+    for( size_type i = best_i, j = best_j; i > 0 || j > 0; )
+    {
+        switch( this->_moves[ i*width + (int_type(j) - int_type(i) - lo) ] )
+        {
+            case 0:
+                this->_segment.push_back( base_op( a.base( a0 + dir*int_type(i-1) ), b.base( b0 + dir*int_type(j-1) ) ) );
+                i--; j--;
+                break;
+            case 1:
+                this->_segment.push_back( GAP_B );
+                i--;
+                break;
+            default:
+                this->_segment.push_back( GAP_A );
+                j--;
+        }
+    }
+
+    std::reverse( this->_segment.begin(), this->_segment.end() );
+
+    la = best_i;
+    lb = best_j;
+    return best_score;
+}
+
+
+MyAlignment
+ChainedAligner::find_alignment(
+        const ContigView& a,
+        size_type begin_a,
+        size_type end_a,
+        const ContigView& b,
+        size_type begin_b,
+        size_type end_b,
+        bool force_start,
+        bool force_end )
+{
+    if( a.size() == 0 || b.size() == 0 ) return MyAlignment();
+
+    if( end_a >= a.size() ) end_a = a.size()-1;
+    if( end_b >= b.size() ) end_b = b.size()-1;
+    if( begin_a > end_a || begin_b > end_b ) return MyAlignment();
+
+    this->find_chain( a, begin_a, end_a, b, begin_b, end_b );
+    if( this->_chain.empty() && !force_start && !force_end ) return MyAlignment();
+
+    std::vector< AlignmentAlphabet >& edit = this->_edit;
+    edit.clear();
+
+    ScoreType score = 0;
+    int_type cur_a, cur_b;     // first bases not aligned yet
+    int_type start_a, start_b; // first bases aligned
+
+    // head: from the forced start to the first anchor, or extended backwards from it
+    if( force_start )
+    {
+        start_a = cur_a = begin_a;
+        start_b = cur_b = begin_b;
+    }
+    else
+    {
+        cur_a = this->_chain.empty() ? int_type(end_a+1) : this->_chain.front().first;
+        cur_b = this->_chain.empty() ? int_type(end_b+1) : this->_chain.front().second;
+
+        size_type la = std::min( size_type(cur_a - begin_a), size_type(CHAIN_MAX_EXTENSION) );
+        size_type lb = std::min( size_type(cur_b - begin_b), size_type(CHAIN_MAX_EXTENSION) );
+        score += this->align_segment( a, cur_a-1, la, b, cur_b-1, lb, -1, true );
+
+        edit.insert( edit.end(), this->_segment.rbegin(), this->_segment.rend() );
+        start_a = cur_a - la;
+        start_b = cur_b - lb;
+    }
+
+    // anchors, and the gaps between them
+    for( size_t i = 0; i < this->_chain.size(); i++ )
+    {
+        int_type pa = this->_chain[i].first, pb = this->_chain[i].second;
+        int_type ea = pa + this->_k, eb = pb + this->_k;
+
+        if( pa - pb == cur_a - cur_b && pa <= cur_a ) // overlapping anchor on the same diagonal
+        {
+            for( ; cur_a < ea; cur_a++, cur_b++ )
+            {
+                score += base_score( a.base( cur_a ), b.base( cur_b ) );
+                edit.push_back( base_op( a.base( cur_a ), b.base( cur_b ) ) );
+            }
+            continue;
+        }
+
+        if( pa < cur_a || pb < cur_b ){ pa = ea; pb = eb; } // overlapping anchor on another diagonal: realigned with the gap
+
+        size_type la = pa - cur_a, lb = pb - cur_b;
+        score += this->align_segment( a, cur_a, la, b, cur_b, lb, 1, false );
+        edit.insert( edit.end(), this->_segment.begin(), this->_segment.end() );
+
+        for( cur_a = pa, cur_b = pb; cur_a < ea; cur_a++, cur_b++ )
+        {
+            score += base_score( a.base( cur_a ), b.base( cur_b ) );
+            edit.push_back( base_op( a.base( cur_a ), b.base( cur_b ) ) );
+        }
+    }
+
+    // tail: from the last anchor to the forced end, or extended forwards from it
+    if( force_end || force_start || !this->_chain.empty() )
+    {
+        size_type la = end_a + 1 - cur_a;
+        size_type lb = end_b + 1 - cur_b;
+
+        if( !force_end )
+        {
+            la = std::min( la, size_type(CHAIN_MAX_EXTENSION) );
+            lb = std::min( lb, size_type(CHAIN_MAX_EXTENSION) );
+        }
+
+        score += this->align_segment( a, cur_a, la, b, cur_b, lb, 1, !force_end );
+        edit.insert( edit.end(), this->_segment.begin(), this->_segment.end() );
+    }
+
+    uint64_t num_of_matches = std::count( edit.begin(), edit.end(), MATCH );
+    double homology = edit.empty() ? 0 : double(num_of_matches * 100) / double(edit.size());
+
+    return MyAlignment( start_a, start_b, a.size(), b.size(), score, homology,
+                        std::list< AlignmentAlphabet >( edit.begin(), edit.end() ) );
+}
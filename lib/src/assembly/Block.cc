@@ -28,11 +28,19 @@
  *
  */
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <list>
+#include <map>
+#include <set>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <boost/detail/container_fwd.hpp>
 
 #include "assembly/Block.hpp"
@@ -61,6 +69,15 @@ Block::Block(const Block &block):
         _numReads(block._numReads), _masterFrame(block._masterFrame), _slaveFrame(block._slaveFrame)
 {}
 
+Block& Block::operator=(const Block &block)
+{
+    _numReads = block._numReads;
+    _masterFrame = block._masterFrame;
+    _slaveFrame = block._slaveFrame;
+
+    return *this;
+}
+
 void Block::setReadsNumber( IntType nr )
 {
     _numReads = nr;
@@ -191,94 +208,67 @@ bool Block::addReads( Read &mRead, Read &sRead, int minOverlap )
     return false;
 }
 
-std::vector< Block > Block::filterBlocksByOverlaps(std::list<Block>& blocks)
+std::vector< Block > Block::filterBlocksByOverlaps( const BlockSpan &blocks )
 {
-    std::list< Block > sortedBlocks;
-    std::list< Block >::iterator block, cur, next;
-
-	for( std::list< Block >::iterator b = blocks.begin(); b != blocks.end(); b++ ) sortedBlocks.push_back(*b);
+    std::vector< Block > sortedBlocks( blocks.begin(), blocks.end() );
 
     MasterBlocksOrderer mbo;
-    sortedBlocks.sort( mbo );
-
-    block = sortedBlocks.begin();
+    std::stable_sort( sortedBlocks.begin(), sortedBlocks.end(), mbo );
 
-    while( block != sortedBlocks.end() )
+    for( size_t i=0; i+1 < sortedBlocks.size(); i++ )
     {
-        cur = block;
-        next = ++block;
+        const Block &cur = sortedBlocks[i];
+        const Block &next = sortedBlocks[i+1];
 
-        if( next != sortedBlocks.end() )
+        if( Frame::frameOverlap(cur.getMasterFrame(), next.getMasterFrame(), 95.0) )
         {
-            if( Frame::frameOverlap(cur->getMasterFrame(), next->getMasterFrame(), 95.0) )
-            {
-                std::cerr << "[debug] master overlap >=95%: (" << cur->getMasterId() << "," << cur->getSlaveId() << ") - ("
-					<< next->getMasterId() << "," << next->getSlaveId() << ")" << std::endl;
-				std::cerr << *cur << std::endl;
-				std::cerr << *next << std::endl;
-				//sortedBlocks.erase( next );
-                //block = cur;
-            }
+            std::cerr << "[debug] master overlap >=95%: (" << cur.getMasterId() << "," << cur.getSlaveId() << ") - ("
+                << next.getMasterId() << "," << next.getSlaveId() << ")" << std::endl;
+            std::cerr << cur << std::endl;
+            std::cerr << next << std::endl;
         }
-
-        block = next;
     }
 
     SlaveBlocksOrderer sbo;
-    sortedBlocks.sort( sbo );
+    std::stable_sort( sortedBlocks.begin(), sortedBlocks.end(), sbo );
 
-    block = sortedBlocks.begin();
-    while( block != sortedBlocks.end() )
+    for( size_t i=0; i+1 < sortedBlocks.size(); i++ )
     {
-        cur = block;
-        next = ++block;
+        const Block &cur = sortedBlocks[i];
+        const Block &next = sortedBlocks[i+1];
 
-        if( next != sortedBlocks.end() )
+        if ( Frame::frameOverlap(cur.getSlaveFrame(), next.getSlaveFrame(), 95.0) )
         {
-            if ( Frame::frameOverlap(cur->getSlaveFrame(), next->getSlaveFrame(), 95.0) )
-            {
-				std::cerr << "[debug] slave overlap >=95%: (" << cur->getMasterId() << "," << cur->getSlaveId() << ") - ("
-					<< next->getMasterId() << "," << next->getSlaveId() << ")" << std::endl;
-				std::cerr << *cur << std::endl;
-				std::cerr << *next << std::endl;
-                //sortedBlocks.erase( next );
-                //block = cur;
-            }
+            std::cerr << "[debug] slave overlap >=95%: (" << cur.getMasterId() << "," << cur.getSlaveId() << ") - ("
+                << next.getMasterId() << "," << next.getSlaveId() << ")" << std::endl;
+            std::cerr << cur << std::endl;
+            std::cerr << next << std::endl;
         }
-
-        block = next;
-    }
-
-    std::vector< Block > outBlocks( sortedBlocks.size() );
-
-    UIntType idx = 0;
-    for( block = sortedBlocks.begin(); block != sortedBlocks.end(); block++ )
-    {
-        outBlocks[idx] = *block;
-        idx++;
     }
 
-    return outBlocks;
+    return sortedBlocks;
 }
 
 
 void Block::filterBlocksByCoverage(
-	std::list<Block>& blocks,
+	std::vector<Block>& blocks,
 	const std::set< std::pair<int32_t,int32_t> > &slb,
 	double min_cov,
 	double t )
 {
 	//std::cerr << "low coverage block threshold = " << min_cov << "X" << std::endl;
-	std::list<Block>::iterator b = blocks.begin();
+	size_t kept = 0;
 
-	while( b != blocks.end() )
+	for( size_t i=0; i < blocks.size(); i++ )
 	{
+		const Block *b = &blocks[i];
+
 		double mcRatio = ((double) (b->getMasterFrame()).getBlockReadsLen()) / ((double) (b->getMasterFrame()).getReadsLen());
 		double scRatio = ((double) (b->getSlaveFrame()).getBlockReadsLen()) / ((double) (b->getSlaveFrame()).getReadsLen());
 
 		if( std::max(mcRatio,scRatio) < t )
 		{
-			b = blocks.erase(b); continue;
+			continue;
 		}
 		else // FILTRAGGIO BASATO SULLA COPERTURA DEL BLOCCO RISPETTO ALLA COPERTURA MEDIA //TODO:verificare di non togliere blocchi importanti
 		{
@@ -294,140 +284,94 @@ void Block::filterBlocksByCoverage(
 				if( cov < min_cov )
 				{
 					//std::cerr << "low coverage block removed: (" << b->getMasterId() << "," << b->getSlaveId() << ")" << std::endl;
-					b = blocks.erase(b); continue;
+					continue;
 				}
 			}
 		}
 
-		++b;
+		if( kept != i ) blocks[kept] = blocks[i];
+		++kept;
 	}
+
+	blocks.resize( kept );
 }
 
 
 void Block::filterBlocksByLength(
-	std::list<Block> &blocks,
+	std::vector<Block> &blocks,
 	const RefSequence &masterRef,
 	const RefSequence &slaveRef,
 	const std::set< std::pair<int32_t,int32_t> > &slb,
 	int32_t min_length )
 {
 	std::ofstream output( "filtered_blocks" );
-	std::list<Block>::iterator b, cur, prev, next;
-
-	MasterBlocksOrderer mbo;
-	blocks.sort( mbo );
 
-	b = blocks.begin();
-	while( b != blocks.end() )
+	for( int pass = 0; pass < 2; pass++ )
 	{
-		cur = b;
-		next = ++b;
-
-		const Frame& mf = cur->getMasterFrame();
-		const Frame& sf = cur->getSlaveFrame();
-
-		int32_t mid = mf.getContigId();
-		int32_t sid = sf.getContigId();
+		bool onMaster = (pass == 0);
 
-		if( slb.find( std::make_pair(mid,sid) ) != slb.end() ){ prev = cur; continue; }
-
-		double m_len = 0.3 * masterRef[mid].RefLength;
-		double s_len = 0.3 * slaveRef[sid].RefLength;
-
-		double m_threshold = std::min( double(min_length), m_len );
-		double s_threshold = std::min( double(min_length), s_len );
-
-		if( mf.getLength() < m_threshold && sf.getLength() < s_threshold )
+		// blocks are sorted by master (resp. slave) position, then compacted in place:
+		// blocks[0,kept) are the ones retained so far, blocks[kept-1] is the previous one.
+		if( onMaster )
 		{
-			if( cur == blocks.begin() )
-			{
-				if( next != blocks.end() && Frame::frameOverlap(next->getMasterFrame(), cur->getMasterFrame(), 0.5) )
-				{
-					output << mf.getLength() << " < " << m_threshold << " and " << sf.getLength() << " < " << s_threshold << "\n" << *cur << "\n" << std::endl;
-
-					b = blocks.erase(cur);
-					continue;
-				}
-			}
-			else
-			{
-				if( Frame::frameOverlap(prev->getMasterFrame(), cur->getMasterFrame(), 0.5) )
-				{
-					output << mf.getLength() << " < " << m_threshold << " and " << sf.getLength() << " < " << s_threshold << "\n" << *cur << "\n" << std::endl;
-
-					b = blocks.erase(cur);
-					continue;
-				}
-
-				if( next != blocks.end() && Frame::frameOverlap(next->getMasterFrame(), cur->getMasterFrame(), 0.5) )
-				{
-					output << mf.getLength() << " < " << m_threshold << " and " << sf.getLength() << " < " << s_threshold << "\n" << *cur << "\n" << std::endl;
-
-					b = blocks.erase(cur);
-					continue;
-				}
-			}
+			MasterBlocksOrderer mbo;
+			std::stable_sort( blocks.begin(), blocks.end(), mbo );
+		}
+		else
+		{
+			SlaveBlocksOrderer sbo;
+			std::stable_sort( blocks.begin(), blocks.end(), sbo );
 		}
 
-		prev = cur;
-	}
-
-	SlaveBlocksOrderer sbo;
-	blocks.sort( sbo );
-
-	b = blocks.begin();
-	while( b != blocks.end() )
-	{
-		cur = b;
-		next = ++b;
+		size_t kept = 0;
 
-		const Frame& mf = cur->getMasterFrame();
-		const Frame& sf = cur->getSlaveFrame();
+		for( size_t i=0; i < blocks.size(); i++ )
+		{
+			const Block &cur = blocks[i];
+			const Frame& mf = cur.getMasterFrame();
+			const Frame& sf = cur.getSlaveFrame();
 
-		int32_t mid = mf.getContigId();
-		int32_t sid = sf.getContigId();
+			int32_t mid = mf.getContigId();
+			int32_t sid = sf.getContigId();
 
-		if( slb.find( std::make_pair(mid,sid) ) != slb.end() ){ prev = cur; continue; }
+			bool remove = false;
 
-		double m_len = 0.3 * masterRef[mid].RefLength;
-		double s_len = 0.3 * slaveRef[sid].RefLength;
+			if( slb.find( std::make_pair(mid,sid) ) == slb.end() )
+			{
+				double m_len = 0.3 * masterRef[mid].RefLength;
+				double s_len = 0.3 * slaveRef[sid].RefLength;
 
-		double m_threshold = std::min( double(min_length), m_len );
-		double s_threshold = std::min( double(min_length), s_len );
+				double m_threshold = std::min( double(min_length), m_len );
+				double s_threshold = std::min( double(min_length), s_len );
 
-		if( mf.getLength() < m_threshold && sf.getLength() < s_threshold )
-		{
-			if( cur == blocks.begin() )
-			{
-				if( next != blocks.end() && Frame::frameOverlap(next->getSlaveFrame(), cur->getSlaveFrame(), 0.5) )
+				if( mf.getLength() < m_threshold && sf.getLength() < s_threshold )
 				{
-					output << mf.getLength() << " < " << m_threshold << " and " << sf.getLength() << " < " << s_threshold << "\n" << *cur << "\n" << std::endl;
-
-					b = blocks.erase(cur);
-					continue;
+					const Frame& curFrame = onMaster ? mf : sf;
+
+					if( kept > 0 )
+					{
+						const Block &prev = blocks[kept-1];
+						remove = Frame::frameOverlap( onMaster ? prev.getMasterFrame() : prev.getSlaveFrame(), curFrame, 0.5 );
+					}
+
+					if( !remove && i+1 < blocks.size() )
+					{
+						const Block &next = blocks[i+1];
+						remove = Frame::frameOverlap( onMaster ? next.getMasterFrame() : next.getSlaveFrame(), curFrame, 0.5 );
+					}
+
+					if( remove )
+						output << mf.getLength() << " < " << m_threshold << " and " << sf.getLength() << " < " << s_threshold << "\n" << cur << "\n" << std::endl;
 				}
 			}
-			else
-			{
-				if( Frame::frameOverlap(prev->getSlaveFrame(), cur->getSlaveFrame(), 0.5) )
-				{
-					output << mf.getLength() << " < " << m_threshold << " and " << sf.getLength() << " < " << s_threshold << "\n" << *cur << "\n" << std::endl;
 
-					b = blocks.erase(cur);
-					continue;
-				}
+			if( remove ) continue;
 
-				if( next != blocks.end() && Frame::frameOverlap(next->getSlaveFrame(), cur->getSlaveFrame(), 0.5) )
-				{
-					output << mf.getLength() << " < " << m_threshold << " and " << sf.getLength() << " < " << s_threshold << "\n" << *cur << "\n" << std::endl;
-
-					b = blocks.erase(cur);
-					continue;
-				}
-			}
+			if( kept != i ) blocks[kept] = blocks[i];
+			++kept;
 		}
 
-		prev = cur;
+		blocks.resize( kept );
 	}
 
 	output.close();
@@ -467,31 +411,16 @@ void Block::filterBlocksByLength(
 */
 
 
-void Block::findBlocks(
-        std::vector< Block > &outblocks,
+void Block::loadSlaveReads(
         MultiBamReader &bamReader,
-        const int minBlockSize,
-        sparse_hash_map< std::string, Read > &readsMap_1,
-        sparse_hash_map< std::string, Read > &readsMap_2,
-        std::vector< std::vector< uint32_t > > &coverage,
+        std::vector< KeyedRead > &slaveReads,
+        CoverageMap &coverage,
         bool noMultFilter )
 {
-    typedef sparse_hash_map< std::string, Read > ReadMap;
-    typedef std::list< std::string > ReadNameList;
-    typedef std::vector< Block > BlockVector;
-
     BamAlignment align;
-	std::list< Block > cur_blocks;
-	std::list< std::pair<uint64_t,uint64_t> > cur_evid;
-
-    // initialize slave coverage vector
-    const RefVector& refVect = bamReader.GetReferenceData();
-    coverage.resize( refVect.size() );
-    for( uint32_t i=0; i < refVect.size(); i++ ) coverage[i].resize( refVect[i].RefLength, 0 );
-
     int32_t nh, xt; // molteplicità delle read (nh->standard, xt->bwa)
 
-    // process reads to build blocks (updating inserts statistics) by coordinate order
+    // process reads by coordinate order (updating inserts statistics)
     while( bamReader.GetNextAlignment(align,true) )
     {
 		// skip unmapped or bad-quality reads
@@ -506,134 +435,193 @@ void Block::findBlocks(
 
         Read slaveRead(align.RefID, align.Position, align.GetEndPosition(), align.IsReverseStrand());
 
-        // update slave vector coverage
-        uint32_t read_len = align.GetEndPosition() - align.Position;
-        for( int i=0; i < read_len; i++ ) coverage[align.RefID][align.Position+i] += 1;
+        // update slave coverage
+        coverage.addRead( align.RefID, align.Position, align.GetEndPosition() );
+
+		// keep the read, identified by its first or second mate
+		int mate = (!align.IsPaired() || align.IsFirstMate()) ? 0 : 1;
+		slaveReads.push_back( KeyedRead( align.Name, mate, slaveRead ) );
+    }
+}
 
-		ReadMap::iterator ref;
 
-		if( !align.IsPaired() || align.IsFirstMate() ) // find the read in the first map
+//! A block still open while slave's reads are processed, with the evidences of its frames' strands.
+struct ActiveBlock
+{
+	Block block;
+	uint64_t sameStrand;   //!< reads oriented in the same strand on both assemblies.
+	uint64_t diffStrand;   //!< reads oriented in opposite strands.
+
+	ActiveBlock( const Block &b ) : block(b), sameStrand(0), diffStrand(0) {}
+};
+
+//! Key indexing an active block by contig and end position of one of its frames.
+struct FrameEndKey
+{
+	int32_t ctgId;
+	int32_t end;
+	uint64_t blockId;
+
+	FrameEndKey( int32_t c, int32_t e, uint64_t id ) : ctgId(c), end(e), blockId(id) {}
+
+	bool operator<( const FrameEndKey &k ) const
+	{
+		if( ctgId != k.ctgId ) return ctgId < k.ctgId;
+		if( end != k.end ) return end < k.end;
+		return blockId < k.blockId;
+	}
+};
+
+// set frames' strand according to the number of concordant/discordant reads and save the block if it is big enough
+static void closeActiveBlock( ActiveBlock &ab, std::vector< Block > &outblocks, const int minBlockSize )
+{
+	ab.block.getMasterFrame().setStrand('+');
+	ab.block.getSlaveFrame().setStrand( ab.sameStrand >= ab.diffStrand ? '+' : '-' );
+
+	if( ab.block.getReadsNumber() >= minBlockSize ) outblocks.push_back( ab.block );
+}
+
+void Block::findBlocks(
+        std::vector< Block > &outblocks,
+        std::vector< KeyedRead > &slaveReads,
+        const int minBlockSize,
+        const ReadMap &readsMap )
+{
+    Read masterRead;
+
+	// Active blocks are identified by their creation order: a read extends the oldest block it overlaps, and
+	// blocks that went out of scope are saved only once a read is not added to any older block. Hence the
+	// output is the same as scanning the list of active blocks for each read, but only blocks overlapping
+	// the read on the master are checked.
+	std::map< uint64_t, ActiveBlock > activeBlocks;
+	std::set< FrameEndKey > masterIndex;    // non-empty blocks in scope, by master frame's end
+	std::set< FrameEndKey > slaveIndex;     // non-empty blocks in scope, by slave frame's end
+	std::set< uint64_t > emptyBlocks;       // blocks without reads (they accept any read)
+	std::set< uint64_t > outOfScope;        // blocks that cannot be extended anymore, not saved yet
+	uint64_t nextBlockId = 0;
+	int32_t slaveCtgId = -1;
+
+    // process slave's reads to build blocks by coordinate order
+    for( size_t r=0; r < slaveReads.size(); r++ )
+    {
+        const KeyedRead &keyedRead = slaveReads[r];
+
+		// skip the read if it has not been mapped on the other assembly
+		if( !readsMap.find( keyedRead.key, keyedRead.check, keyedRead.getMate(), masterRead ) ) continue;
+
+        Read slaveRead = keyedRead.getRead();
+
+		// save every block when moving to the next slave's contig
+		if( slaveRead.getContigId() != slaveCtgId )
 		{
-			ref = readsMap_1.find(align.Name);
-			if( ref == readsMap_1.end() ) continue; // skip the read if it has not been mapped on the other assembly
+			for( std::map< uint64_t, ActiveBlock >::iterator ab = activeBlocks.begin(); ab != activeBlocks.end(); ++ab )
+				closeActiveBlock( ab->second, outblocks, minBlockSize );
+
+			activeBlocks.clear();
+			masterIndex.clear();
+			slaveIndex.clear();
+			emptyBlocks.clear();
+			outOfScope.clear();
+
+			slaveCtgId = slaveRead.getContigId();
 		}
-		else // if second mate, find the read in the second map
+
+		// blocks ending before the read on the slave (or on a previous slave contig) go out of scope
+		FrameEndKey scopeBound( slaveRead.getContigId(), slaveRead.getStartPos() - 1, 0 );
+		while( !slaveIndex.empty() && *(slaveIndex.begin()) < scopeBound )
 		{
-			ref = readsMap_2.find(align.Name);
-			if( ref == readsMap_2.end() ) continue; // skip the read if it has not been mapped on the other assembly
-		}
+			uint64_t id = slaveIndex.begin()->blockId;
+			const Frame &mf = activeBlocks.find(id)->second.block.getMasterFrame();
 
-        // try to extend one of the memorized blocks
-        bool readsAdded = false;
-		std::list< Block >::iterator block = cur_blocks.begin();
-		std::list< std::pair<uint64_t,uint64_t> >::iterator evid = cur_evid.begin();
+			masterIndex.erase( FrameEndKey( mf.getContigId(), mf.getEnd(), id ) );
+			slaveIndex.erase( slaveIndex.begin() );
+			outOfScope.insert( id );
+		}
 
-        while( block != cur_blocks.end() ) // for each memorized block
-        {
-			if( block->addReads( ref->second, slaveRead ) ) // if read has been succesfully added to the current block
-            {
-                readsAdded = true;
+		// find the oldest block the read can be added to
+		std::map< uint64_t, ActiveBlock >::iterator target = activeBlocks.end();
+		if( !emptyBlocks.empty() ) target = activeBlocks.find( *(emptyBlocks.begin()) );
 
-				// update evidences of frames to be oriented in the same strand
-				if( (ref->second).isReverse() == slaveRead.isReverse() ) (evid->first)++;
-				else (evid->second)++;
+		std::set< FrameEndKey >::iterator key = masterIndex.lower_bound( FrameEndKey( masterRead.getContigId(), masterRead.getStartPos() - 1, 0 ) );
+		for( ; key != masterIndex.end() && key->ctgId == masterRead.getContigId(); ++key )
+		{
+			if( target != activeBlocks.end() && key->blockId > target->first ) continue;
 
-				// readlist->push_back(ref->first); // aggiungo un riferimento alla read in posizione corrispondente al blocco
-                break;
-            }
+			std::map< uint64_t, ActiveBlock >::iterator ab = activeBlocks.find( key->blockId );
+			if( ab->second.block.overlaps( masterRead, slaveRead ) ) target = ab;
+		}
 
-            bool blockOutOfScope = block->getSlaveFrame().getEnd() + 1 < slaveRead.getStartPos() ||
-				block->getSlaveFrame().getContigId() < slaveRead.getContigId();
+		// save out of scope blocks older than the one extended (all of them, if the read starts a new block)
+		while( !outOfScope.empty() && (target == activeBlocks.end() || *(outOfScope.begin()) < target->first) )
+		{
+			std::map< uint64_t, ActiveBlock >::iterator ab = activeBlocks.find( *(outOfScope.begin()) );
 
-			if( !readsAdded && blockOutOfScope ) // block out of scope
-            {
-                Frame& mf = block->getMasterFrame();
-				Frame& sf = block->getSlaveFrame();
+			closeActiveBlock( ab->second, outblocks, minBlockSize );
 
-				// set frames' strand according to the numbero of concordant/discordant reads in the block
-				mf.setStrand('+');
-				sf.setStrand( evid->first >= evid->second ? '+' : '-' );
+			activeBlocks.erase( ab );
+			outOfScope.erase( outOfScope.begin() );
+		}
 
-				if( block->getReadsNumber() >= minBlockSize ) outblocks.push_back( *block );
+		if( target != activeBlocks.end() ) // extend the block
+		{
+			uint64_t id = target->first;
+			Block &block = target->second.block;
 
-                // remove block and its strand evidences
-				block = cur_blocks.erase(block);
-				evid = cur_evid.erase(evid);
+			if( block.isEmpty() ) emptyBlocks.erase( id );
+			else
+			{
+				masterIndex.erase( FrameEndKey( block.getMasterFrame().getContigId(), block.getMasterFrame().getEnd(), id ) );
+				slaveIndex.erase( FrameEndKey( block.getSlaveFrame().getContigId(), block.getSlaveFrame().getEnd(), id ) );
+			}
 
-                continue;
-            }
+			block.addReads( masterRead, slaveRead );
 
-            ++block;
-			++evid;
-        }
+			masterIndex.insert( FrameEndKey( block.getMasterFrame().getContigId(), block.getMasterFrame().getEnd(), id ) );
+			slaveIndex.insert( FrameEndKey( block.getSlaveFrame().getContigId(), block.getSlaveFrame().getEnd(), id ) );
 
-        // if the read has not been added to any existing block, create a new block.
-        if( !readsAdded )
-        {
-			Block new_block( ref->second, slaveRead, minBlockSize );
-			std::pair<uint64_t,uint64_t> strand_evid(0,0);
+			// update evidences of frames to be oriented in the same strand
+			if( masterRead.isReverse() == slaveRead.isReverse() ) target->second.sameStrand++;
+			else target->second.diffStrand++;
+		}
+		else // create a new block
+		{
+			uint64_t id = nextBlockId++;
+			Block &block = activeBlocks.insert( std::make_pair( id, ActiveBlock( Block( masterRead, slaveRead, minBlockSize ) ) ) ).first->second.block;
 
-			cur_blocks.push_back(new_block);
-			cur_evid.push_back(strand_evid);
+			if( block.isEmpty() ) emptyBlocks.insert( id );
+			else
+			{
+				masterIndex.insert( FrameEndKey( block.getMasterFrame().getContigId(), block.getMasterFrame().getEnd(), id ) );
+				slaveIndex.insert( FrameEndKey( block.getSlaveFrame().getContigId(), block.getSlaveFrame().getEnd(), id ) );
+			}
 		}
     }
 
     // after all reads have been processed, save or delete remaining blocks
-    std::list< Block >::iterator block = cur_blocks.begin();
-	std::list< std::pair<uint64_t,uint64_t> >::iterator evid = cur_evid.begin();
-
-	while( block != cur_blocks.end() )
-	{
-		Frame& mf = block->getMasterFrame();
-		Frame& sf = block->getSlaveFrame();
-
-		// set frames' strand according to the numbero of concordant/discordant reads in the block
-		mf.setStrand('+');
-		sf.setStrand( evid->first >= evid->second ? '+' : '-' );
+	for( std::map< uint64_t, ActiveBlock >::iterator ab = activeBlocks.begin(); ab != activeBlocks.end(); ++ab )
+		closeActiveBlock( ab->second, outblocks, minBlockSize );
 
-		if( block->getReadsNumber() >= minBlockSize ) outblocks.push_back( *block );
-
-		// remove block and its strand evidences
-		block = cur_blocks.erase(block);
-		evid = cur_evid.erase(evid);
-	}
-
-    readsMap_1.clear();
-    readsMap_2.clear();
+    std::vector< KeyedRead >().swap( slaveReads );
 }
 
 
 void Block::updateCoverages(
         std::vector<Block> &blocks,
-        const std::vector< std::vector<uint32_t> > &masterCoverage,
-        std::vector< std::vector<uint32_t> > &slaveCoverage )
+        const CoverageMap &masterCoverage,
+        const CoverageMap &slaveCoverage )
 {
-    int32_t ctgId, begin, end;
     uint64_t masterReadsLen, slaveReadsLen;
     Frame newFrame;
 
     for( size_t i=0; i < blocks.size(); i++ )
     {
-        masterReadsLen = 0;
-        slaveReadsLen = 0;
-
         // update master coverage
-
         const Frame& masterFrame = blocks[i].getMasterFrame();
-        ctgId = masterFrame.getContigId();
-        begin = masterFrame.getBegin();
-        end = masterFrame.getEnd();
-
-        for( size_t pos = begin; pos <= end; pos++ ) masterReadsLen += masterCoverage.at(ctgId).at(pos);
+        masterReadsLen = masterCoverage.getReadsLen( masterFrame.getContigId(), masterFrame.getBegin(), masterFrame.getEnd() );
 
         // update slave coverage
-
         const Frame& slaveFrame = blocks[i].getSlaveFrame();
-        ctgId = slaveFrame.getContigId();
-        begin = slaveFrame.getBegin();
-        end = slaveFrame.getEnd();
-
-        for( size_t pos = begin; pos <= end; pos++ ) slaveReadsLen += slaveCoverage[ctgId][pos];
+        slaveReadsLen = slaveCoverage.getReadsLen( slaveFrame.getContigId(), slaveFrame.getBegin(), slaveFrame.getEnd() );
 
         // update current block
 
@@ -666,9 +654,93 @@ bool Block::shareContig(const Block& a, const Block& b)
 }
 
 
-void Block::loadBlocks( const std::string& blockFile, std::list<Block> &blocks, int minBlockSize )
+static FrameRecord toFrameRecord( const Frame &frame )
+{
+	FrameRecord rec;
+	memset( &rec, 0, sizeof(FrameRecord) );
+
+	rec.ctgId = frame.getContigId();
+	rec.begin = frame.getBegin();
+	rec.end = frame.getEnd();
+	rec.strand = frame.getStrand();
+	rec.blockReadsLen = frame.getBlockReadsLen();
+	rec.readsLen = frame.getReadsLen();
+
+	return rec;
+}
+
+static Frame toFrame( const FrameRecord &rec )
+{
+	Frame frame( rec.ctgId, rec.strand, rec.begin, rec.end );
+	frame.setBlockReadsLen( rec.blockReadsLen );
+	frame.setReadsLen( rec.readsLen );
+
+	return frame;
+}
+
+void Block::loadBlocks( const std::string& blockFile, std::vector<Block> &blocks, int minBlockSize, BlocksFileHeader *header )
 {
-    std::ifstream ifs( blockFile.c_str() );
+	if( header != NULL ) memset( header, 0, sizeof(BlocksFileHeader) );
+
+	int fd = open( blockFile.c_str(), O_RDONLY );
+	if( fd < 0 )
+	{
+		std::cerr << "[error] unable to open blocks' file \"" << blockFile << "\"" << std::endl;
+		exit(1);
+	}
+
+	struct stat st;
+	fstat( fd, &st );
+	uint64_t fileSize = st.st_size;
+
+	BlocksFileHeader head;
+	bool binary = fileSize >= sizeof(BlocksFileHeader) && pread( fd, &head, sizeof(BlocksFileHeader), 0 ) == ssize_t(sizeof(BlocksFileHeader)) &&
+		memcmp( head.magic, BLOCKS_FILE_MAGIC, sizeof(head.magic) ) == 0;
+
+	if( binary )
+	{
+		if( head.version != BLOCKS_FILE_VERSION || fileSize != sizeof(BlocksFileHeader) + head.blocksNum * sizeof(BlockRecord) )
+		{
+			std::cerr << "[error] blocks' file \"" << blockFile << "\" is corrupted or has an unsupported version (" << head.version << ")" << std::endl;
+			exit(1);
+		}
+
+		void *addr = mmap( NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+		close(fd);
+
+		if( addr == MAP_FAILED )
+		{
+			std::cerr << "[error] unable to map blocks' file \"" << blockFile << "\"" << std::endl;
+			exit(1);
+		}
+
+		madvise( addr, fileSize, MADV_SEQUENTIAL );
+
+		const BlockRecord *records = (const BlockRecord*)( (const char*)addr + sizeof(BlocksFileHeader) );
+		blocks.reserve( blocks.size() + head.blocksNum );
+
+		for( uint64_t i=0; i < head.blocksNum; i++ )
+		{
+			if( records[i].numReads < minBlockSize ) continue;
+
+			Block block;
+			block._numReads = records[i].numReads;
+			block._masterFrame = toFrame( records[i].masterFrame );
+			block._slaveFrame = toFrame( records[i].slaveFrame );
+
+			blocks.push_back( block );
+		}
+
+		munmap( addr, fileSize );
+
+		if( header != NULL ) *header = head;
+		return;
+	}
+
+	close(fd);
+
+	// text format
+	std::ifstream ifs( blockFile.c_str() );
 
 	Block block;
 	std::string line;
@@ -746,6 +818,42 @@ void Block::writeBlocks( const std::string &blockFile, std::vector< Block > &blo
 }
 
 
+void Block::writeBlocksBinary( const std::string &blockFile, const std::vector< Block > &blocks,
+                               uint32_t masterContigs, uint32_t slaveContigs, int32_t minBlockSize )
+{
+	std::ofstream output( blockFile.c_str(), std::ios::out | std::ios::binary );
+
+	BlocksFileHeader head;
+	memset( &head, 0, sizeof(BlocksFileHeader) );
+	memcpy( head.magic, BLOCKS_FILE_MAGIC, sizeof(head.magic) );
+	head.version = BLOCKS_FILE_VERSION;
+	head.minBlockSize = minBlockSize;
+	head.masterContigs = masterContigs;
+	head.slaveContigs = slaveContigs;
+	head.blocksNum = blocks.size();
+
+	output.write( (const char*)&head, sizeof(BlocksFileHeader) );
+
+	for( std::vector<Block>::const_iterator it = blocks.begin(); it != blocks.end(); ++it )
+	{
+		BlockRecord rec;
+		rec.numReads = it->getReadsNumber();
+		rec.masterFrame = toFrameRecord( it->getMasterFrame() );
+		rec.slaveFrame = toFrameRecord( it->getSlaveFrame() );
+
+		output.write( (const char*)&rec, sizeof(BlockRecord) );
+	}
+
+	output.close();
+
+	if( output.fail() )
+	{
+		std::cerr << "[error] unable to write blocks' file \"" << blockFile << "\"" << std::endl;
+		exit(1);
+	}
+}
+
+
 void Block::writeBlocksVerbose( const std::string &blockFile, std::vector< Block > &blocks, const MultiBamReader &masterBam, const MultiBamReader &slaveBam )
 {
 	std::ofstream output( blockFile.c_str() );
@@ -810,7 +918,7 @@ std::istream& operator >>( std::istream &input, Block &block )
 void getNoBlocksContigs(
 	const RefSequence &masterRef,
 	const RefSequence &slaveRef,
-	const std::list<Block> &blocks,
+	const BlockSpan &blocks,
 	boost_bitset_t &masterNBC,
 	boost_bitset_t &slaveNBC )
 {
@@ -820,7 +928,7 @@ void getNoBlocksContigs(
 	masterNBC.reset();
 	slaveNBC.reset();
 
-	for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); ++b )
+	for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); ++b )
 	{
 		int32_t master_id = b->getMasterId();
 		int32_t slave_id = b->getSlaveId();
@@ -865,7 +973,7 @@ void getNoBlocksContigs(
 void getNoBlocksAfterFilterContigs(
 	const RefSequence &masterRef,
 	const RefSequence &slaveRef,
-	const std::list<Block> &blocks,
+	const BlockSpan &blocks,
 	const boost_bitset_t &masterNBC,
 	const boost_bitset_t &slaveNBC,
 	boost_bitset_t &masterNBC_AF,
@@ -877,7 +985,7 @@ void getNoBlocksAfterFilterContigs(
 	masterNBC_AF.reset();
 	slaveNBC_AF.reset();
 
-	for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); ++b )
+	for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); ++b )
 	{
 		int32_t master_id = b->getMasterId();
 		int32_t slave_id = b->getSlaveId();
@@ -0,0 +1,311 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "assembly/CoverageMap.hpp"
+
+CoverageMap::CoverageMap( int width, const std::string &spillDir ):
+        _width( width == 16 ? 16 : 32 ), _windowBits( width == 16 ? 6 : 10 ), _spillDir(spillDir),
+        _ctgOffset(), _ctgLength(), _data(NULL), _dataBytes(0), _mapped(false),
+        _starts(), _ends(), _checkpoints(), _overflow(), _sideTable(), _finalized(false)
+{}
+
+CoverageMap::~CoverageMap()
+{
+    this->release();
+}
+
+uint64_t CoverageMap::getValue( uint64_t pos ) const
+{
+    if( _width == 16 ) return reinterpret_cast< const uint16_t* >(_data)[pos];
+    return reinterpret_cast< const uint32_t* >(_data)[pos];
+}
+
+void CoverageMap::setValue( uint64_t pos, uint64_t value )
+{
+    if( _width == 16 ) reinterpret_cast< uint16_t* >(_data)[pos] = uint16_t(value);
+    else reinterpret_cast< uint32_t* >(_data)[pos] = uint32_t(value);
+}
+
+int64_t CoverageMap::getDiff( uint64_t pos ) const
+{
+    if( _width == 16 ) return int16_t( reinterpret_cast< const uint16_t* >(_data)[pos] );
+    return int32_t( reinterpret_cast< const uint32_t* >(_data)[pos] );
+}
+
+void CoverageMap::allocate( uint64_t bytes )
+{
+    _dataBytes = bytes;
+    _mapped = !_spillDir.empty();
+
+    if( bytes == 0 ) return;
+
+    if( !_mapped )
+    {
+        _data = (char*) calloc( bytes, 1 );
+        if( _data == NULL )
+        {
+            std::cerr << "[error] unable to allocate " << (bytes >> 20) << " MB for coverage" << std::endl;
+            exit(1);
+        }
+        return;
+    }
+
+    // the file is removed as soon as it is mapped, so that it does not outlive the process
+    std::string pattern = _spillDir + "/gam-coverage-XXXXXX";
+    std::vector< char > filename( pattern.begin(), pattern.end() );
+    filename.push_back('\0');
+
+    int fd = mkstemp( &filename[0] );
+    if( fd < 0 )
+    {
+        std::cerr << "[error] unable to create coverage file in directory \"" << _spillDir << "\"" << std::endl;
+        exit(1);
+    }
+    unlink( &filename[0] );
+
+    if( ftruncate( fd, off_t(bytes) ) != 0 )
+    {
+        std::cerr << "[error] unable to extend coverage file to " << (bytes >> 20) << " MB in directory \"" << _spillDir << "\"" << std::endl;
+        exit(1);
+    }
+
+    void *addr = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close(fd);
+
+    if( addr == MAP_FAILED )
+    {
+        std::cerr << "[error] unable to map coverage file in directory \"" << _spillDir << "\"" << std::endl;
+        exit(1);
+    }
+
+    _data = (char*) addr;
+}
+
+void CoverageMap::release()
+{
+    if( _data != NULL )
+    {
+        if( _mapped ) munmap( _data, _dataBytes ); else free( _data );
+    }
+
+    _data = NULL;
+    _dataBytes = 0;
+}
+
+void CoverageMap::init( const BamTools::RefVector &refs )
+{
+    this->clear();
+
+    uint64_t windowSize = uint64_t(1) << _windowBits;
+    _ctgOffset.resize( refs.size() + 1 );
+    _ctgLength.resize( refs.size() );
+
+    // one more position per contig, where reads ending at the contig's end are removed
+    _ctgOffset[0] = 0;
+    for( size_t i=0; i < refs.size(); i++ )
+    {
+        _ctgLength[i] = refs[i].RefLength;
+        uint64_t size = uint64_t(refs[i].RefLength) + 1;
+        _ctgOffset[i+1] = _ctgOffset[i] + ((size + windowSize - 1) >> _windowBits << _windowBits);
+    }
+
+    uint64_t windows = _ctgOffset.back() >> _windowBits;
+
+    this->allocate( _ctgOffset.back() * (_width / 8) );
+
+    _starts.resize( windows, 0 );
+    _ends.resize( windows, 0 );
+    _checkpoints.resize( windows, 0 );
+    _overflow.resize( windows, 0 );
+    _sideTable.resize( refs.size() );
+}
+
+void CoverageMap::addDiff( int32_t ctgId, int32_t pos, int64_t diff, std::vector< uint32_t > &counts )
+{
+    uint64_t g = _ctgOffset[ctgId] + pos;
+    uint64_t w = g >> _windowBits;
+    uint64_t mask = (uint64_t(1) << _windowBits) - 1;
+
+    if( _overflow[w] )
+    {
+        _sideTable[ctgId][w][g & mask] += diff;
+        return;
+    }
+
+    // per-base differences are exact (as signed values) while less than 2^(width-1) reads start and end in the window
+    if( ++counts[w] < (uint32_t(1) << (_width-1)) )
+    {
+        this->setValue( g, this->getValue(g) + uint64_t(diff) );
+        return;
+    }
+
+    std::vector< int64_t > &values = _sideTable[ctgId][w];
+    values.resize( mask+1 );
+    for( uint64_t j=0; j <= mask; j++ ) values[j] = this->getDiff( (w << _windowBits) + j );
+
+    values[g & mask] += diff;
+    _overflow[w] = 1;
+}
+
+void CoverageMap::addRead( int32_t ctgId, int32_t startPos, int32_t endPos )
+{
+    int32_t len = _ctgLength[ctgId];
+
+    if( startPos < 0 ) startPos = 0;
+    if( endPos > len ) endPos = len;
+    if( startPos >= endPos ) return;
+
+    this->addDiff( ctgId, startPos, +1, _starts );
+    this->addDiff( ctgId, endPos, -1, _ends );
+}
+
+void CoverageMap::finalize()
+{
+    if( _finalized ) return;
+
+    uint64_t windowSize = uint64_t(1) << _windowBits;
+    std::vector< uint64_t > offsets( windowSize );
+
+    for( size_t c=0; c < _ctgLength.size(); c++ )
+    {
+        uint64_t first = _ctgOffset[c], last = _ctgOffset[c] + _ctgLength[c]; // positions of the contig
+
+        int64_t cov = 0;    // coverage of the current base
+        uint64_t cum = 0;   // sum of the coverage of the previous bases
+
+        for( uint64_t w = first >> _windowBits; (w << _windowBits) <= last; w++ )
+        {
+            uint64_t base = w << _windowBits;
+            uint64_t size = std::min( windowSize, last + 1 - base );
+
+            _checkpoints[w] = cum;
+
+            if( _overflow[w] )
+            {
+                std::vector< int64_t > &values = _sideTable[c][w];
+
+                for( uint64_t j=0; j < size; j++ )
+                {
+                    int64_t diff = values[j];
+                    values[j] = int64_t(cum - _checkpoints[w]);
+                    cov += diff;
+                    cum += cov;
+                }
+
+                continue;
+            }
+
+            for( uint64_t j=0; j < size; j++ )
+            {
+                int64_t diff = this->getDiff( base + j );
+                offsets[j] = cum - _checkpoints[w];
+                cov += diff;
+                cum += cov;
+            }
+
+            // offsets are non-decreasing: if the last one fits, all of them do
+            if( offsets[size-1] < (uint64_t(1) << _width) )
+            {
+                for( uint64_t j=0; j < size; j++ ) this->setValue( base + j, offsets[j] );
+            }
+            else
+            {
+                _sideTable[c][w].assign( offsets.begin(), offsets.begin() + size );
+                _overflow[w] = 1;
+            }
+        }
+    }
+
+    std::vector< uint32_t >().swap( _starts );
+    std::vector< uint32_t >().swap( _ends );
+
+    _finalized = true;
+}
+
+uint64_t CoverageMap::cumulative( int32_t ctgId, int32_t pos ) const
+{
+    uint64_t g = _ctgOffset[ctgId] + pos;
+    uint64_t w = g >> _windowBits;
+
+    if( _overflow[w] )
+    {
+        const std::vector< int64_t > &values = _sideTable[ctgId].find(w)->second;
+        return _checkpoints[w] + uint64_t( values[ g & ((uint64_t(1) << _windowBits) - 1) ] );
+    }
+
+    return _checkpoints[w] + this->getValue(g);
+}
+
+uint64_t CoverageMap::getReadsLen( int32_t ctgId, int32_t begin, int32_t end ) const
+{
+    int32_t len = _ctgLength[ctgId];
+
+    if( begin < 0 ) begin = 0;
+    if( end >= len ) end = len-1;
+    if( begin > end ) return 0;
+
+    return this->cumulative( ctgId, end+1 ) - this->cumulative( ctgId, begin );
+}
+
+uint64_t CoverageMap::getDataSize() const
+{
+    return _dataBytes;
+}
+
+uint64_t CoverageMap::getOverflowWindows() const
+{
+    uint64_t windows = 0;
+    for( size_t c=0; c < _sideTable.size(); c++ ) windows += _sideTable[c].size();
+
+    return windows;
+}
+
+void CoverageMap::clear()
+{
+    this->release();
+
+    std::vector< uint64_t >().swap( _ctgOffset );
+    std::vector< int32_t >().swap( _ctgLength );
+    std::vector< uint32_t >().swap( _starts );
+    std::vector< uint32_t >().swap( _ends );
+    std::vector< uint64_t >().swap( _checkpoints );
+    std::vector< uint8_t >().swap( _overflow );
+    std::vector< std::map< uint64_t, std::vector< int64_t > > >().swap( _sideTable );
+
+    _finalized = false;
+}
+
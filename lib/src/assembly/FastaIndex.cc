@@ -0,0 +1,352 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "assembly/FastaIndex.hpp"
+
+FastaIndex::FastaIndex():
+        _fastaFile(), _entries(), _ids(), _data(NULL), _dataBytes(0)
+{
+    pthread_mutex_init( &_mutex, NULL );
+}
+
+FastaIndex::~FastaIndex()
+{
+    this->unmap();
+    pthread_mutex_destroy( &_mutex );
+}
+
+void FastaIndex::unmap()
+{
+    for( size_t i = 0; i < _entries.size(); i++ ) delete _entries[i].ctg;
+
+    if( _data != NULL ) munmap( (void*) _data, _dataBytes );
+
+    _entries.clear();
+    _ids.clear();
+    _data = NULL;
+    _dataBytes = 0;
+}
+
+size_t FastaIndex::open( const std::string &fastaFile )
+{
+    this->unmap();
+    _fastaFile = fastaFile;
+
+    int fd = ::open( fastaFile.c_str(), O_RDONLY );
+    struct stat st;
+
+    if( fd < 0 || fstat( fd, &st ) != 0 )
+    {
+        std::cerr << "[error] unable to open FASTA file \"" << fastaFile << "\"" << std::endl;
+        exit(1);
+    }
+
+    _dataBytes = st.st_size;
+
+    if( _dataBytes > 0 )
+    {
+        void *addr = mmap( NULL, _dataBytes, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+        if( addr == MAP_FAILED )
+        {
+            std::cerr << "[error] unable to map FASTA file \"" << fastaFile << "\"" << std::endl;
+            exit(1);
+        }
+
+        _data = (const char*) addr;
+    }
+    ::close(fd);
+
+    // an index older than the FASTA file is rebuilt
+    std::string faiFile = fastaFile + ".fai";
+    struct stat fai_st;
+    bool indexed = stat( faiFile.c_str(), &fai_st ) == 0 && fai_st.st_mtime >= st.st_mtime && this->readIndex( faiFile );
+
+    if( !indexed )
+    {
+        this->buildIndex();
+
+        // an index of lines with different lengths would not pass the check on next run: it is built every time instead
+        if( this->checkIndex() ) this->writeIndex( faiFile );
+        else unlink( faiFile.c_str() );
+    }
+
+    for( size_t i = 0; i < _entries.size(); i++ ) _ids[ _entries[i].name ] = i;
+
+    return _entries.size();
+}
+
+bool FastaIndex::readIndex( const std::string &faiFile )
+{
+    std::ifstream ifs( faiFile.c_str() );
+    std::string line;
+
+    _entries.clear();
+
+    while( std::getline( ifs, line ) )
+    {
+        if( line.empty() ) continue;
+
+        std::istringstream iss( line );
+        Entry e;
+
+        if( !std::getline( iss, e.name, '\t' ) || !(iss >> e.length >> e.offset >> e.lineBases >> e.lineWidth) || e.offset > _dataBytes )
+        {
+            _entries.clear();
+            return false;
+        }
+
+        e.ctg = NULL;
+        e.refs = 0;
+        _entries.push_back(e);
+    }
+
+    // a stale or foreign index would make load() parse the wrong bytes
+    if( !this->checkIndex() )
+    {
+        std::cerr << "[warning] FASTA index \"" << faiFile << "\" does not match the FASTA file: it will be rebuilt" << std::endl;
+        _entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool FastaIndex::checkIndex() const
+{
+    for( size_t i = 0; i < _entries.size(); i++ )
+    {
+        const Entry &e = _entries[i];
+
+        // sequences start right after their header line
+        if( e.offset == 0 || e.offset > _dataBytes || _data[e.offset-1] != '\n' ) return false;
+
+        // the sequence has to end before the header of the next one (or the end of the file)
+        uint64_t limit = _dataBytes;
+
+        if( i+1 < _entries.size() )
+        {
+            uint64_t next = _entries[i+1].offset;
+            if( next <= e.offset || next > _dataBytes ) return false;
+
+            limit = next - 1;
+            while( limit > e.offset && _data[limit-1] != '\n' ) limit--;
+            if( _data[limit] != '>' ) return false;
+        }
+
+        uint64_t end = e.offset;
+
+        if( e.length > 0 )
+        {
+            if( e.lineBases == 0 || e.lineWidth < e.lineBases || (e.length > e.lineBases && e.lineWidth == e.lineBases) ) return false;
+
+            // bytes from the first base to the last one, given the length of the lines
+            uint64_t last = e.offset + ((e.length-1) / e.lineBases) * e.lineWidth + (e.length-1) % e.lineBases;
+            if( last >= limit || isspace( _data[last] ) ) return false;
+
+            if( e.length > e.lineBases && _data[ e.offset + e.lineWidth - 1 ] != '\n' ) return false;
+
+            end = last + 1;
+        }
+
+        // nothing but blanks may follow the last base
+        for( uint64_t pos = end; pos < limit; pos++ ) if( !isspace( _data[pos] ) ) return false;
+    }
+
+    return true;
+}
+
+void FastaIndex::buildIndex()
+{
+    _entries.clear();
+
+    uint64_t pos = 0;
+
+    while( pos < _dataBytes )
+    {
+        if( _data[pos] != '>' )
+        {
+            if( isspace( _data[pos] ) ){ pos++; continue; }
+
+            std::cerr << "[error] found invalid character '" << _data[pos] << "' in FASTA file \"" << _fastaFile << "\"" << std::endl;
+            exit(1);
+        }
+
+        // header: the name ends at the first blank
+        const char *eol = (const char*) memchr( _data + pos, '\n', _dataBytes - pos );
+        uint64_t next = (eol == NULL) ? _dataBytes : uint64_t(eol - _data) + 1;
+
+        uint64_t name_end = pos + 1;
+        while( name_end < next && !isspace( _data[name_end] ) ) name_end++;
+
+        Entry e;
+        e.name.assign( _data + pos + 1, name_end - pos - 1 );
+        e.length = e.lineBases = e.lineWidth = 0;
+        e.offset = next;
+        e.ctg = NULL;
+        e.refs = 0;
+
+        // sequence lines, until the next header
+        pos = next;
+        while( pos < _dataBytes && _data[pos] != '>' )
+        {
+            eol = (const char*) memchr( _data + pos, '\n', _dataBytes - pos );
+            next = (eol == NULL) ? _dataBytes : uint64_t(eol - _data) + 1;
+
+            uint64_t bases = 0;
+            for( uint64_t i = pos; i < next; i++ ) if( !isspace( _data[i] ) ) bases++;
+
+            if( e.lineWidth == 0 && bases > 0 ){ e.lineBases = bases; e.lineWidth = next - pos; }
+
+            e.length += bases;
+            pos = next;
+        }
+
+        _entries.push_back(e);
+    }
+}
+
+void FastaIndex::writeIndex( const std::string &faiFile ) const
+{
+    std::ofstream ofs( faiFile.c_str() );
+
+    if( !ofs )
+    {
+        std::cerr << "[warning] unable to write FASTA index \"" << faiFile << "\": it will be rebuilt on next run" << std::endl;
+        return;
+    }
+
+    for( size_t i = 0; i < _entries.size(); i++ )
+    {
+        const Entry &e = _entries[i];
+        ofs << e.name << "\t" << e.length << "\t" << e.offset << "\t" << e.lineBases << "\t" << e.lineWidth << "\n";
+    }
+}
+
+size_t FastaIndex::size() const
+{
+    return _entries.size();
+}
+
+int64_t FastaIndex::find( const std::string &name ) const
+{
+    std::map< std::string, int64_t >::const_iterator it = _ids.find(name);
+    return (it == _ids.end()) ? -1 : it->second;
+}
+
+const std::string& FastaIndex::name( int64_t id ) const
+{
+    return _entries.at(id).name;
+}
+
+uint64_t FastaIndex::length( int64_t id ) const
+{
+    return _entries.at(id).length;
+}
+
+Contig* FastaIndex::load( int64_t id ) const
+{
+    const Entry &e = _entries.at(id);
+    Contig *ctg = new Contig( e.name, e.length );
+
+    const char *begin = _data + e.offset;
+    const char *p = begin;
+    const char *end = _data + _dataBytes;
+
+    for( uint64_t i = 0; i < e.length && p < end; p++ )
+    {
+        if( !isspace(*p) ) ctg->set_base( i++, Nucleotide(*p).base() );
+    }
+
+    // parsed pages are no longer needed (they are read again from the file if necessary)
+    if( p > begin )
+    {
+        uint64_t page = sysconf(_SC_PAGESIZE);
+        uint64_t first = (uint64_t(begin - _data) / page) * page;
+        madvise( (void*)(_data + first), uint64_t(p - _data) - first, MADV_DONTNEED );
+    }
+
+    return ctg;
+}
+
+const Contig& FastaIndex::acquire( int64_t id )
+{
+    pthread_mutex_lock( &_mutex );
+
+    Entry &e = _entries.at(id);
+
+    if( e.ctg != NULL )
+    {
+        e.refs++;
+        pthread_mutex_unlock( &_mutex );
+        return *(e.ctg);
+    }
+
+    pthread_mutex_unlock( &_mutex );
+
+    // the sequence is parsed outside the lock: if another thread loaded it meanwhile, its copy is kept
+    Contig *ctg = this->load(id);
+
+    pthread_mutex_lock( &_mutex );
+
+    if( e.ctg == NULL ) e.ctg = ctg; else delete ctg;
+    e.refs++;
+
+    const Contig &loaded = *(e.ctg);
+    pthread_mutex_unlock( &_mutex );
+
+    return loaded;
+}
+
+void FastaIndex::release( int64_t id )
+{
+    pthread_mutex_lock( &_mutex );
+
+    Entry &e = _entries.at(id);
+
+    if( e.refs > 0 && --(e.refs) == 0 )
+    {
+        delete e.ctg;
+        e.ctg = NULL;
+    }
+
+    pthread_mutex_unlock( &_mutex );
+}
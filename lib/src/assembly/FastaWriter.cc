@@ -0,0 +1,215 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "assembly/FastaWriter.hpp"
+#include "assembly/io_contig.hpp"
+
+// characters of the base codes (A, T, C, G, N)
+static const char BASE_CHARS[LAST_BASE+1] = { 'A', 'T', 'C', 'G', 'N', 'N' };
+
+// bases converted at once
+#define FASTA_WRITER_CHUNK (1024*SEQ_LINE_LENGTH)
+
+FastaWriter::FastaWriter( const std::string &file, bool async ):
+        _file(file), _fd(-1), _active(0), _used(0), _codes(FASTA_WRITER_CHUNK),
+        _async(async), _pending(false), _pendingBytes(0), _done(false)
+{
+    _fd = ::open( file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+    if( _fd < 0 )
+    {
+        std::cerr << "[error] unable to create file \"" << file << "\"" << std::endl;
+        exit(1);
+    }
+
+    _buffers[0].resize( FASTA_WRITER_BUFFER );
+    if( _async ) _buffers[1].resize( FASTA_WRITER_BUFFER );
+
+    pthread_mutex_init( &_mutex, NULL );
+    pthread_cond_init( &_cond, NULL );
+
+    if( _async && pthread_create( &_thread, NULL, FastaWriter::writerThread, this ) != 0 ) _async = false;
+}
+
+FastaWriter::~FastaWriter()
+{
+    this->close();
+
+    pthread_cond_destroy( &_cond );
+    pthread_mutex_destroy( &_mutex );
+}
+
+void FastaWriter::writeBytes( const char *data, size_t bytes ) const
+{
+    while( bytes > 0 )
+    {
+        ssize_t written = ::write( _fd, data, bytes );
+
+        if( written < 0 && errno == EINTR ) continue;
+        if( written <= 0 )
+        {
+            std::cerr << "[error] unable to write file \"" << _file << "\"" << std::endl;
+            exit(1);
+        }
+
+        data += written;
+        bytes -= written;
+    }
+}
+
+void* FastaWriter::writerThread( void *arg )
+{
+    FastaWriter *w = static_cast< FastaWriter* >(arg);
+
+    pthread_mutex_lock( &(w->_mutex) );
+
+    while( true )
+    {
+        while( !w->_pending && !w->_done ) pthread_cond_wait( &(w->_cond), &(w->_mutex) );
+        if( !w->_pending ) break;
+
+        // the inactive buffer is not touched by the main thread until it is released
+        const char *data = &(w->_buffers[1 - w->_active][0]);
+        size_t bytes = w->_pendingBytes;
+
+        pthread_mutex_unlock( &(w->_mutex) );
+        w->writeBytes( data, bytes );
+        pthread_mutex_lock( &(w->_mutex) );
+
+        w->_pending = false;
+        pthread_cond_broadcast( &(w->_cond) );
+    }
+
+    pthread_mutex_unlock( &(w->_mutex) );
+
+    return NULL;
+}
+
+void FastaWriter::flushBuffer()
+{
+    if( _used == 0 ) return;
+
+    if( !_async )
+    {
+        this->writeBytes( &_buffers[0][0], _used );
+        _used = 0;
+        return;
+    }
+
+    pthread_mutex_lock( &_mutex );
+
+    while( _pending ) pthread_cond_wait( &_cond, &_mutex );
+
+    _active = 1 - _active;
+    _pendingBytes = _used;
+    _pending = true;
+    pthread_cond_broadcast( &_cond );
+
+    pthread_mutex_unlock( &_mutex );
+
+    _used = 0;
+}
+
+void FastaWriter::append( const char *data, size_t bytes )
+{
+    while( bytes > 0 )
+    {
+        if( _used == FASTA_WRITER_BUFFER ) this->flushBuffer();
+
+        size_t n = std::min( bytes, size_t(FASTA_WRITER_BUFFER) - _used );
+        memcpy( &_buffers[_active][_used], data, n );
+
+        _used += n;
+        data += n;
+        bytes -= n;
+    }
+}
+
+void FastaWriter::write( const Contig &ctg )
+{
+    char line[SEQ_LINE_LENGTH+1];
+
+    line[0] = '>';
+    this->append( line, 1 );
+    this->append( ctg.name().data(), ctg.name().size() );
+
+    for( size_t chunk = 0; chunk < ctg.size(); chunk += FASTA_WRITER_CHUNK )
+    {
+        size_t chunk_len = std::min( size_t(FASTA_WRITER_CHUNK), ctg.size() - chunk );
+        ctg.codes( chunk, chunk_len, &_codes[0] );
+
+        for( size_t i = 0; i < chunk_len; i += SEQ_LINE_LENGTH )
+        {
+            size_t len = std::min( size_t(SEQ_LINE_LENGTH), chunk_len - i );
+
+            line[0] = '\n';
+            for( size_t j = 0; j < len; j++ ) line[j+1] = BASE_CHARS[ _codes[i+j] ];
+
+            this->append( line, len+1 );
+        }
+    }
+
+    line[0] = '\n';
+    this->append( line, 1 );
+}
+
+void FastaWriter::close()
+{
+    if( _fd < 0 ) return;
+
+    this->flushBuffer();
+
+    if( _async )
+    {
+        pthread_mutex_lock( &_mutex );
+        _done = true;
+        pthread_cond_broadcast( &_cond );
+        pthread_mutex_unlock( &_mutex );
+
+        pthread_join( _thread, NULL );
+        _async = false;
+    }
+
+    if( ::close(_fd) != 0 )
+    {
+        std::cerr << "[error] unable to write file \"" << _file << "\"" << std::endl;
+        exit(1);
+    }
+
+    _fd = -1;
+}
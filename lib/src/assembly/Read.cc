@@ -31,6 +31,8 @@
 #include "OrderingFunctions.hpp"
 
 #include "assembly/Read.hpp"
+#include "assembly/ReadMap.hpp"
+#include "assembly/CoverageMap.hpp"
 
 Read::Read():
         _contigId(0), _startPos(0), _endPos(0), _isRev(false)
@@ -41,6 +43,16 @@ Read::Read(const Read &orig):
         _endPos(orig._endPos), _isRev(orig._isRev)
 { }
 
+Read& Read::operator=(const Read &orig)
+{
+    _contigId = orig._contigId;
+    _startPos = orig._startPos;
+    _endPos = orig._endPos;
+    _isRev = orig._isRev;
+
+    return *this;
+}
+
 Read::Read(const int32_t ctg, const int32_t sPos, const int32_t ePos, const bool rev):
         _contigId(ctg), _startPos(sPos), _endPos(ePos), _isRev(rev)
 { }
@@ -65,7 +77,7 @@ int32_t Read::getLength() const
     return _endPos - _startPos;
 }
 
-bool Read::isReverse()
+bool Read::isReverse() const
 {
     return _isRev;
 }
@@ -82,15 +94,12 @@ bool Read::overlaps(Read& read, int minOverlap) const
 
 void Read::loadReadsMap(
 		MultiBamReader &bamReader,
-		sparse_hash_map< std::string, Read > &readMap_1,
-		sparse_hash_map< std::string, Read > &readMap_2,
-		std::vector< std::vector<uint32_t> > &coverage,
+		ReadMap &readMap,
+		CoverageMap &coverage,
         bool noMultFilter )
 {
-    // initialize coverage vector
-    const RefVector& refVect = bamReader.GetReferenceData();
-    coverage.resize( refVect.size() );
-    for( uint32_t i=0; i < refVect.size(); i++ ) coverage.at(i).resize( refVect.at(i).RefLength, 0 );
+    // initialize coverage
+    coverage.init( bamReader.GetReferenceData() );
 
     int32_t nh, xt;
     BamAlignment align;
@@ -111,12 +120,13 @@ void Read::loadReadsMap(
 
 		Read curRead( align.RefID, align.Position, align.GetEndPosition(), align.IsReverseStrand() );
 
-		// insert reads one of the reads hash-tables depending on whether it is the first or second pair
-		if( !align.IsPaired() || align.IsFirstMate() ) readMap_1[align.Name] = curRead; else readMap_2[align.Name] = curRead;
+		// insert read in the slot of its first or second mate, depending on whether it is the first or second pair
+		readMap.insert( align.Name, (!align.IsPaired() || align.IsFirstMate()) ? 0 : 1, curRead );
 
-		// update vector coverage
-		uint32_t read_len = align.GetEndPosition() - align.Position;
-		for( int i=0; i < read_len; i++ ) coverage.at(align.RefID).at(align.Position+i) += 1;
+		// update coverage
+		coverage.addRead( align.RefID, align.Position, align.GetEndPosition() );
     }
+
+    coverage.finalize();
 }
 
@@ -0,0 +1,191 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "assembly/ReadMap.hpp"
+
+#define READMAP_MIN_SLOTS 1024
+
+ReadMap::ReadMap( uint64_t expected ):
+        _slots(), _mask(0), _keys(0), _reads(0), _collisions(0)
+{
+    uint64_t slots = READMAP_MIN_SLOTS;
+    while( slots * 7 < expected * 10 ) slots <<= 1; // keep load factor below 0.7
+
+    _slots.resize( slots, emptySlot() );
+    _mask = slots - 1;
+}
+
+ReadMap::Slot ReadMap::emptySlot()
+{
+    Slot empty;
+
+    empty.key = 0;
+    empty.check = 0;
+    empty.collided = 0;
+    empty.mate[0].contigId = empty.mate[1].contigId = -1;
+    empty.mate[0].startPos = empty.mate[1].startPos = 0;
+    empty.mate[0].lenRev = empty.mate[1].lenRev = 0;
+
+    return empty;
+}
+
+void ReadMap::fingerprint( const std::string &name, uint64_t &key, uint32_t &check )
+{
+    uint64_t h = 14695981039346656037ULL; // FNV-1a (64 bit)
+    uint32_t c = 2166136261U;             // FNV-1a (32 bit)
+
+    for( size_t i=0; i < name.size(); i++ )
+    {
+        h = (h ^ (unsigned char)name[i]) * 1099511628211ULL;
+        c = (c ^ (unsigned char)name[i]) * 16777619U;
+    }
+
+    // final mixing, so that the low bits used for probing depend on the whole name
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    key = (h == 0) ? 1 : h; // 0 marks empty slots
+    check = c;
+}
+
+uint64_t ReadMap::findSlot( uint64_t key ) const
+{
+    uint64_t idx = key & _mask;
+    while( _slots[idx].key != 0 && _slots[idx].key != key ) idx = (idx+1) & _mask; // linear probing
+
+    return idx;
+}
+
+void ReadMap::grow()
+{
+    std::vector< Slot > old;
+    old.swap( _slots );
+
+    _slots.resize( old.empty() ? READMAP_MIN_SLOTS : 2 * old.size(), emptySlot() );
+    _mask = _slots.size() - 1;
+
+    for( size_t i=0; i < old.size(); i++ )
+    {
+        if( old[i].key == 0 ) continue;
+        _slots[ findSlot(old[i].key) ] = old[i];
+    }
+}
+
+void ReadMap::insert( const std::string &name, int mate, const Read &read )
+{
+    uint64_t key;
+    uint32_t check;
+    fingerprint( name, key, check );
+
+    if( (_keys+1) * 10 > _slots.size() * 7 ) this->grow();
+
+    Slot &slot = _slots[ findSlot(key) ];
+
+    if( slot.key == 0 ) // new read name
+    {
+        slot.key = key;
+        slot.check = check;
+        slot.collided = 0;
+        slot.mate[0].contigId = slot.mate[1].contigId = -1;
+        _keys++;
+    }
+    else if( slot.collided )
+    {
+        return;
+    }
+    else if( slot.check != check ) // two different names share the fingerprint: discard both
+    {
+        if( slot.mate[0].contigId >= 0 ) _reads--;
+        if( slot.mate[1].contigId >= 0 ) _reads--;
+
+        slot.collided = 1;
+        slot.mate[0].contigId = slot.mate[1].contigId = -1;
+        _collisions++;
+
+        return;
+    }
+
+    PackedRead &pr = slot.mate[mate];
+    if( pr.contigId < 0 ) _reads++;
+
+    pr.contigId = read.getContigId();
+    pr.startPos = read.getStartPos();
+    pr.lenRev = (uint32_t(read.getLength()) << 1) | (read.isReverse() ? 1 : 0);
+}
+
+bool ReadMap::find( const std::string &name, int mate, Read &read ) const
+{
+    uint64_t key;
+    uint32_t check;
+    fingerprint( name, key, check );
+
+    return this->find( key, check, mate, read );
+}
+
+bool ReadMap::find( uint64_t key, uint32_t check, int mate, Read &read ) const
+{
+    if( _keys == 0 ) return false;
+
+    const Slot &slot = _slots[ findSlot(key) ];
+    if( slot.key == 0 || slot.collided || slot.check != check ) return false;
+
+    const PackedRead &pr = slot.mate[mate];
+    if( pr.contigId < 0 ) return false;
+
+    read = Read( pr.contigId, pr.startPos, pr.startPos + int32_t(pr.lenRev >> 1), (pr.lenRev & 1) != 0 );
+
+    return true;
+}
+
+void ReadMap::clear()
+{
+    std::vector< Slot >().swap( _slots );
+    _mask = 0;
+    _keys = 0;
+    _reads = 0;
+}
+
+uint64_t ReadMap::size() const
+{
+    return _reads;
+}
+
+uint64_t ReadMap::getCollisions() const
+{
+    return _collisions;
+}
+
+uint64_t ReadMap::getMemoryUsage() const
+{
+    return _slots.capacity() * sizeof(Slot);
+}
@@ -103,5 +103,5 @@ void
 readNextSequence( std::istream &is, Contig &ctg );
 
 size_t
-loadSequences( const std::string &file, RefSequence &refSequence, const std::map< std::string, int32_t > &ctg2Id );
+indexSequences( const std::string &file, FastaIndex &fasta, RefSequence &refSequence );
 
@@ -66,8 +66,6 @@ bool MultiBamReader::Open( const std::vector< std::string > &filenames )
 	_bam_aligns.resize( bams );
 	_valid_aligns.resize( bams );
 
-	_bam_mutex.resize( bams );
-
 	_minInsert.resize( bams );
 	_maxInsert.resize( bams );
 
@@ -102,8 +100,6 @@ bool MultiBamReader::Open( const std::vector< std::string > &filenames )
 				std::cerr << "[bam] ERROR: unable to open BAM index file:\n" << index_filename << std::endl;
 			}
 		}
-
-		pthread_mutex_init( &(this->_bam_mutex[i]), NULL );
 	}
 
 	if(!opened) exit(EXIT_FAILURE); else _is_open = true;
@@ -131,6 +127,48 @@ bool MultiBamReader::Open( const std::string &filename )
 }
 
 
+// opens the files of another reader for region queries, sharing (read-only) headers,
+// indexes and statistics, so that a thread may query them without locking the original one.
+bool MultiBamReader::OpenCopy( const MultiBamReader &other )
+{
+	if(_is_open) this->Close();
+	if( not other._is_open ) return false;
+
+	size_t bams = other._bam_readers.size();
+
+	_bam_readers.resize( bams );
+	_bam_aligns.resize( bams );
+	_valid_aligns.assign( bams, false );
+
+	bool opened = true;
+
+	for( size_t i=0; i < bams; i++ )
+	{
+		_bam_readers[i] = new BamReader();
+
+		if( not _bam_readers[i]->OpenShared( *(other._bam_readers[i]) ) )
+		{
+			opened = false;
+			std::cerr << "[bam] ERROR: " << _bam_readers[i]->GetErrorString() << std::endl;
+			delete _bam_readers[i];
+		}
+	}
+
+	if(!opened) exit(EXIT_FAILURE); else _is_open = true;
+
+	_minInsert = other._minInsert;
+	_maxInsert = other._maxInsert;
+	_isize_mean = other._isize_mean;
+	_isize_std = other._isize_std;
+	_isize_count = other._isize_count;
+	_asm_size = other._asm_size;
+	_reads_len = other._reads_len;
+	_coverage = other._coverage;
+
+	return true;
+}
+
+
 void MultiBamReader::Close()
 {
 	if( _is_open )
@@ -170,6 +208,20 @@ void MultiBamReader::setMinMaxInsertSizes( const std::vector<int32_t> &minInsert
 }
 
 
+void MultiBamReader::setDecompressThreads( int threads )
+{
+	// each library gets its own pool of threads, which read ahead and decompress BGZF blocks
+	for( size_t i=0; i < _bam_readers.size(); i++ )
+	{
+		if( not _bam_readers[i]->SetDecompressThreads(threads) )
+		{
+			std::cerr << "[bam] ERROR: " << _bam_readers[i]->GetErrorString() << std::endl;
+			exit(1);
+		}
+	}
+}
+
+
 BamReader* MultiBamReader::getBamReader( uint32_t idx )
 {
 	if( idx >= _bam_readers.size() ) throw MultiBamReaderException( "MultiBamReader::getBamReader index out of bound." );
@@ -223,19 +275,6 @@ double MultiBamReader::getGlobCoverage()
 }
 
 
-void MultiBamReader::lockBamReader( uint32_t idx )
-{
-	if( idx >= (this->_bam_mutex).size() ) throw MultiBamReaderException( "MultiBamReader::lockBamReader index out of bound." );
-	pthread_mutex_lock(&(this->_bam_mutex[idx]));
-}
-
-void MultiBamReader::unlockBamReader( uint32_t idx )
-{
-	if( idx >= (this->_bam_mutex).size() ) throw MultiBamReaderException( "MultiBamReader::unlockBamReader index out of bound." );
-	pthread_mutex_unlock(&(this->_bam_mutex[idx]));
-}
-
-
 bool MultiBamReader::Rewind()
 {
 	bool ret = true;
@@ -529,6 +568,33 @@ bool MultiBamReader::computeStatistics()
 }
 
 
+// merges the statistics computed by another reader of the same BAM files (on a different region)
+void MultiBamReader::mergeStats( const MultiBamReader &other )
+{
+	for( size_t i=0; i < _bam_readers.size() && i < other._bam_readers.size(); i++ )
+	{
+		// counts are stored incremented by one, and standard deviations are already finalized
+		double n_a = double(_isize_count[i] - 1), n_b = double(other._isize_count[i] - 1);
+		if( n_b == 0 ) continue;
+
+		double m2_a = _isize_std[i] * _isize_std[i] * double(_isize_count[i]);
+		double m2_b = other._isize_std[i] * other._isize_std[i] * double(other._isize_count[i]);
+		double delta = other._isize_mean[i] - _isize_mean[i];
+		double n = n_a + n_b;
+
+		_isize_mean[i] = _isize_mean[i] + delta * n_b / n;
+		_isize_count[i] += other._isize_count[i] - 1;
+		_isize_std[i] = sqrt( (m2_a + m2_b + delta * delta * n_a * n_b / n) / double(_isize_count[i]) );
+	}
+
+	for( size_t i=0; i < _reads_len.size() && i < other._reads_len.size(); i++ )
+	{
+		_reads_len[i] += other._reads_len[i];
+		_coverage[i] = (_asm_size != 0) ? _reads_len[i] / ((double)_asm_size) : 0.0;
+	}
+}
+
+
 void MultiBamReader::writeStatsToFile( const std::string &filename ) const
 {
 	std::ofstream ofs( filename.c_str() );
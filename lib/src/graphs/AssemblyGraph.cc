@@ -28,16 +28,17 @@
  *
  */
 
+#include <algorithm>
+
 #include "graphs/AssemblyGraph.hpp"
 
 AssemblyGraph::AssemblyGraph( uint64_t id ) : _agId(id)
 {
-    std::list< Block > blocks;
-    this->initGraph( blocks );
+    this->initGraph( BlockSpan() );
 }
 
 
-AssemblyGraph::AssemblyGraph( const std::list< Block > &blocks, uint64_t id ) : _agId(id)
+AssemblyGraph::AssemblyGraph( const BlockSpan &blocks, uint64_t id ) : _agId(id)
 {
     this->initGraph( blocks );
 }
@@ -46,15 +47,19 @@ AssemblyGraph::AssemblyGraph( const std::list< Block > &blocks, uint64_t id ) :
 const AssemblyGraph&
 AssemblyGraph::operator =(const AssemblyGraph& orig)
 {
-    *((AssemblyGraph *)this) = *((AssemblyGraph *)&orig);
+    CsrGraph::operator=( orig );
+    this->_ownedBlocks = orig._ownedBlocks;
     this->_blockVector = orig._blockVector;
 	this->_agId = orig._agId;
 
+    // re-point the view if it refers to blocks owned by orig
+    if( !orig._ownedBlocks.empty() && orig._blockVector.begin() == &orig._ownedBlocks[0] ) this->_blockVector = BlockSpan( this->_ownedBlocks );
+
     return *this;
 }
 
 
-const std::vector<Block>&
+const BlockSpan&
 AssemblyGraph::getBlocksVector() const
 {
     return this->_blockVector;
@@ -63,7 +68,7 @@ AssemblyGraph::getBlocksVector() const
 const Block&
 AssemblyGraph::getBlock(const UIntType& pos) const
 {
-    return this->_blockVector.at(pos);
+    return this->_blockVector[pos];
 }
 
 
@@ -95,8 +100,8 @@ AssemblyGraph::removeForks()
 
     for( size_t i=0; i < fork_blocks.size(); i++ )
 	{
-		Frame &mf = (this->_blockVector[ fork_blocks[i] ]).getMasterFrame();
-		Frame &sf = (this->_blockVector[ fork_blocks[i] ]).getSlaveFrame();
+		const Frame &mf = (this->_blockVector[ fork_blocks[i] ]).getMasterFrame();
+		const Frame &sf = (this->_blockVector[ fork_blocks[i] ]).getSlaveFrame();
 
 		if( i==0 )
 		{
@@ -114,14 +119,17 @@ AssemblyGraph::removeForks()
 		}
 	}
 
-	std::list<Block> newBlocks;
+	std::vector<Block> newBlocks;
+	newBlocks.reserve( this->_blockVector.size() );
 
 	for( VertexIterator v = vbegin; v != vend; v++ )
 	{
 		if( *v != del_vtx ) newBlocks.push_back( this->_blockVector[*v] );
 	}
 
-	this->initGraph( newBlocks );
+	// the graph now owns its blocks (the current view may refer to _ownedBlocks itself)
+	this->_ownedBlocks.swap( newBlocks );
+	this->initGraph( BlockSpan(this->_ownedBlocks) );
 	if(has_forks) this->removeForks();
 
 	return;
@@ -142,13 +150,12 @@ AssemblyGraph::removeForks()
 
 
 void
-AssemblyGraph::initGraph( const std::list<Block> &blocks )
+AssemblyGraph::initGraph( const BlockSpan &blocks )
 {
     this->clear();
 
-	// fill local blocks vector
-	this->_blockVector.reserve( blocks.size() );
-	for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); ++b ) this->_blockVector.push_back(*b);
+	// blocks are not copied: the graph refers to the caller's storage
+	this->_blockVector = blocks;
 
     StrandProbMap masterStrandMap, slaveStrandMap;
 
@@ -163,26 +170,34 @@ AssemblyGraph::initGraph( const std::list<Block> &blocks )
     boost::tie( indexMaster, backIndexMaster ) = getOrderedMasterIndices( blocks );
     boost::tie( indexSlave, backIndexSlave ) = getOrderedSlaveIndices( blocks );
 
-    // add a vertex for each block.
-    this->addVertices();
+    // for each block (vertex), connect his vertex to the successive blocks' vertices
+    std::vector<EdgeEntry> edges;
+    edges.reserve( 4*blocks.size() );
 
-    // for each block, connect his vertex to the successive blocks' vertices
-    for( UIntType i=0; i < blocks.size(); i++ ) this->addMasterEdges( i, masterStrandMap, indexMaster, backIndexMaster );
-    for( UIntType i=0; i < blocks.size(); i++ ) this->addSlaveEdges( i, slaveStrandMap, indexSlave, backIndexSlave );
+    for( UIntType i=0; i < blocks.size(); i++ ) this->addMasterEdges( i, masterStrandMap, indexMaster, backIndexMaster, edges );
+    for( UIntType i=0; i < blocks.size(); i++ ) this->addSlaveEdges( i, slaveStrandMap, indexSlave, backIndexSlave, edges );
+
+    this->buildEdges( edges );
 }
 
 
-UIntType
-AssemblyGraph::addVertices()
+void
+AssemblyGraph::buildEdges( std::vector<EdgeEntry> &edges )
 {
-    std::vector<Block>::const_iterator block;
-    for( block = this->_blockVector.begin(); block != this->_blockVector.end(); block++ )
+    // master edges come first: a slave edge joining the same blocks turns them into a BOTH_EDGE one
+    std::stable_sort( edges.begin(), edges.end(), CsrGraph::edgeEntryLess );
+
+    for( size_t i=1; i < edges.size(); i++ )
     {
-        boost::add_vertex(*this); //Vertex v = boost::add_vertex(*this);
-        // boost::put( boost::vertex_kind_t(), *this, v, both_vertex );
+        EdgeEntry &prev = edges[i-1];
+        if( prev.source != edges[i].source || prev.target != edges[i].target ) continue;
+
+        // build() keeps the last entry of each edge
+        if( prev.prop.kind != edges[i].prop.kind ) prev.prop.kind = BOTH_EDGE;
+        edges[i].prop = prev.prop;
     }
 
-    return this->_blockVector.size();
+    this->build( this->_blockVector.size(), edges );
 }
 
 
@@ -191,7 +206,8 @@ AssemblyGraph::addMasterEdges(
         const UIntType& vertex,
         const StrandProbMap& strandMap,
         const std::vector<UIntType>& index,
-        const std::vector<UIntType>& backIndex)
+        const std::vector<UIntType>& backIndex,
+    std::vector<EdgeEntry>& edges)
 {
     int32_t ctgId = (this->_blockVector[vertex]).getMasterId();
     UIntType idx = backIndex.at(vertex);
@@ -209,8 +225,8 @@ AssemblyGraph::addMasterEdges(
         case '-':
             std::swap(next,prev);
         case '+':
-            if( next != vertex ) this->addMasterSingleEdge(vertex,next);
-            if( prev != vertex ) this->addMasterSingleEdge(prev,vertex);
+            if( next != vertex ) this->addMasterSingleEdge(vertex,next,edges);
+            if( prev != vertex ) this->addMasterSingleEdge(prev,vertex,edges);
     }
 }
 
@@ -219,7 +235,8 @@ AssemblyGraph::addSlaveEdges(
         const UIntType& vertex,
         const StrandProbMap& strandMap,
         const std::vector<UIntType>& index,
-        const std::vector<UIntType>& backIndex)
+        const std::vector<UIntType>& backIndex,
+    std::vector<EdgeEntry>& edges)
 {
     int32_t ctgId = (this->_blockVector[vertex]).getSlaveId();
     UIntType idx = backIndex.at(vertex);
@@ -237,27 +254,19 @@ AssemblyGraph::addSlaveEdges(
         case '-':
             std::swap(next,prev);
         case '+':
-            if( next != vertex ) this->addSlaveSingleEdge(vertex,next);
-            if( prev != vertex ) this->addSlaveSingleEdge(prev,vertex);
+            if( next != vertex ) this->addSlaveSingleEdge(vertex,next,edges);
+            if( prev != vertex ) this->addSlaveSingleEdge(prev,vertex,edges);
     }
 }
 
 
 bool
-AssemblyGraph::addMasterSingleEdge(const UIntType& s, const UIntType& t)
+AssemblyGraph::addMasterSingleEdge(const UIntType& s, const UIntType& t, std::vector<EdgeEntry>& edges)
 {
     if( Block::shareMasterContig(this->_blockVector[s],this->_blockVector[t]) )
     {
-        Edge e;
-        bool exists;
-
-        boost::tie(e,exists) = boost::edge(s,t,*this);
-        if( !exists )
-        {
-			EdgeProperty edge_prop = { MASTER_EDGE, 0.0 };
-			e = boost::add_edge(s,t,*this).first;
-			boost::put( boost::edge_kind_t(), *this, e, edge_prop );
-        }
+		EdgeProperty edge_prop = { MASTER_EDGE, 0.0, 0, false };
+		edges.push_back( EdgeEntry(s,t,edge_prop) );
 
         return true;
     }
@@ -266,32 +275,13 @@ AssemblyGraph::addMasterSingleEdge(const UIntType& s, const UIntType& t)
 }
 
 bool
-AssemblyGraph::addSlaveSingleEdge(const UIntType& s, const UIntType& t)
+AssemblyGraph::addSlaveSingleEdge(const UIntType& s, const UIntType& t, std::vector<EdgeEntry>& edges)
 {
     if( Block::shareSlaveContig(this->_blockVector[s],this->_blockVector[t]) )
     {
-        Edge e;
-        bool exists;
-
-        boost::tie(e,exists) = boost::edge(s,t,*this);
-        if( !exists )
-        {
-			EdgeProperty edge_prop = { SLAVE_EDGE, 0.0 };
-            e = boost::add_edge(s,t,*this).first;
-			boost::put( boost::edge_kind_t(), *this, e, edge_prop );
-        }
-        else
-        {
-            //EdgeKindType edge_type = boost::get( boost::edge_kind_t(), *this, e );
-            EdgeProperty edge_prop = boost::get( boost::edge_kind_t(), *this, e );
-			EdgeKindType edge_type = edge_prop.kind;
-
-            if( edge_type == MASTER_EDGE )
-			{
-				edge_prop.kind = BOTH_EDGE;
-                boost::put( boost::edge_kind_t(), *this, e, edge_prop );
-			}
-        }
+		// joined to a master edge with the same endpoints by buildEdges()
+		EdgeProperty edge_prop = { SLAVE_EDGE, 0.0, 0, false };
+		edges.push_back( EdgeEntry(s,t,edge_prop) );
 
         return true;
     }
@@ -368,66 +358,28 @@ AssemblyGraph::writeGraphviz(std::ostream& os)
 
 void AssemblyGraph::reverseEdges()
 {
-    std::vector< std::pair<Vertex,Vertex> > new_edges;
-    std::vector< EdgeProperty > edge_properties; //std::vector< EdgeKindType > types;
+    std::vector< EdgeEntry > new_edges;
+    new_edges.reserve( boost::num_edges(*this) );
 
     EdgeIterator begin,end;
     boost::tie(begin,end) = boost::edges(*this);
     for( EdgeIterator e = begin; e != end; e++ )
     {
-		EdgeProperty edge_prop = boost::get(boost::edge_kind_t(), *this, *e); //EdgeKindType kind = boost::get(boost::edge_kind_t(), *this, *e);
-        new_edges.push_back( std::make_pair( boost::target(*e,*this), boost::source(*e,*this) ) );
-        edge_properties.push_back(edge_prop); //types.push_back( kind );
-    }
-
-    size_t vertices = boost::num_vertices(*this);
-
-    this->clear();
-    for( size_t i=0; i < vertices; i++ ) boost::add_vertex(*this);
-
-    for( size_t i=0; i < new_edges.size(); i++ )
-    {
-        Edge e = boost::add_edge( new_edges[i].first, new_edges[i].second, *this ).first;
-		boost::put( boost::edge_kind_t(), *this, e, edge_properties[i] );
-    }
-}
-
-
-void AssemblyGraph::agTopologicalSort( const AssemblyGraph &g, Vertex v, std::vector<char> &colors, std::list<Vertex> &tsList )
-{
-    colors[v] = 1;
-
-    AdjacencyIterator begin, end;
-    boost::tie(begin,end) = boost::adjacent_vertices(v,g);
-
-    for( AdjacencyIterator u = begin; u != end; u++ )
-    {
-        if( colors[*u] == 0 ) AssemblyGraph::agTopologicalSort( g, *u, colors, tsList );
-        if( colors[*u] == 1 ) throw boost::not_a_dag();
+        EdgeProperty edge_prop = boost::get(boost::edge_kind_t(), *this, *e);
+        new_edges.push_back( EdgeEntry( boost::target(*e,*this), boost::source(*e,*this), edge_prop ) );
     }
 
-    colors[v] = 2;
-    tsList.push_back(v);
+    this->build( boost::num_vertices(*this), new_edges );
 }
 
 
 void AssemblyGraph::agTopologicalSort( const AssemblyGraph &g, std::list<Vertex> &tsList )
 {
-    std::list<Vertex> roots;
-    std::vector<char> colors( boost::num_vertices(g), 0 );
-
-    VertexIterator vbegin,vend;
-    boost::tie(vbegin,vend) = boost::vertices(g);
+    std::vector<Vertex> order;
+    g.topologicalSort( order );
 
-    for( VertexIterator v = vbegin; v != vend; v++ )
-    {
-        if( boost::in_degree(*v,g) == 0 ) roots.push_back(*v);
-    }
-
-    for( std::list<Vertex>::const_iterator v = roots.begin(); v != roots.end(); v++ )
-    {
-        AssemblyGraph::agTopologicalSort(g, *v, colors, tsList);
-    }
+    // vertices are listed after their successors
+    tsList.assign( order.rbegin(), order.rend() );
 }
 
 
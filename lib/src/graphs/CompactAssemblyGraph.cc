@@ -47,8 +47,9 @@ CompactAssemblyGraph::CompactAssemblyGraph( const AssemblyGraph &ag )
 const CompactAssemblyGraph&
 CompactAssemblyGraph::operator =(const CompactAssemblyGraph& orig)
 {
-    *((CompactAssemblyGraph *)this) = *((CompactAssemblyGraph *)&orig);
-    this->_blockVector = orig._blockVector;
+    CsrGraph::operator=( orig );
+    this->_blocks = orig._blocks;
+    this->_blockOffsets = orig._blockOffsets;
 	this->_cgId = orig._cgId;
     this->_num_vertices = orig._num_vertices;
 
@@ -56,17 +57,27 @@ CompactAssemblyGraph::operator =(const CompactAssemblyGraph& orig)
 }
 
 
-const std::vector< std::list<Block> >&
-CompactAssemblyGraph::getBlocksVector() const
+BlockSpan
+CompactAssemblyGraph::getBlocks( const Vertex &pos ) const
 {
-    return this->_blockVector;
+    const Block *base = this->_blocks.empty() ? NULL : &this->_blocks[0];
+    return BlockSpan( base + this->_blockOffsets.at(pos), base + this->_blockOffsets.at(pos+1) );
 }
 
 
-const std::list<Block>&
-CompactAssemblyGraph::getBlocks( const Vertex &pos ) const
+void
+CompactAssemblyGraph::initBlocks( const AssemblyGraph &ag, const std::vector<AssemblyGraph::Vertex> &visitOrder,
+                                  const std::vector<Vertex> &ag2cg )
 {
-    return this->_blockVector.at(pos);
+	// counting sort of the visited blocks by compact vertex, keeping the visit order within each vertex
+	this->_blockOffsets.assign( boost::num_vertices(*this) + 1, 0 );
+	for( size_t i=0; i < visitOrder.size(); i++ ) this->_blockOffsets[ ag2cg[visitOrder[i]] + 1 ]++;
+	for( size_t v=1; v < this->_blockOffsets.size(); v++ ) this->_blockOffsets[v] += this->_blockOffsets[v-1];
+
+	std::vector<size_t> next( this->_blockOffsets.begin(), this->_blockOffsets.end()-1 );
+
+	this->_blocks.resize( visitOrder.size() );
+	for( size_t i=0; i < visitOrder.size(); i++ ) this->_blocks[ next[ag2cg[visitOrder[i]]]++ ] = ag.getBlock( visitOrder[i] );
 }
 
 
@@ -75,22 +86,22 @@ CompactAssemblyGraph::initGraphDFS_NR(
 	const AssemblyGraph &ag,
 	const AssemblyGraph::Vertex &root,
 	boost::dynamic_bitset<> *visited,
-	std::vector<Vertex> *ag2cg )
+	std::vector<Vertex> *ag2cg,
+	std::vector<AssemblyGraph::Vertex> *visitOrder,
+	std::vector<EdgeEntry> *edges )
 {
 	AssemblyGraph::Edge e_ag;
 	AssemblyGraph::AdjacencyIterator begin, end;
-	Edge e; bool exists; Vertex new_v;
+	bool exists; Vertex new_v;
 
 	std::stack<AssemblyGraph::Vertex> *cur_stack = new std::stack<AssemblyGraph::Vertex>();
 	std::stack<AssemblyGraph::Vertex> *pre_stack = new std::stack<AssemblyGraph::Vertex>();
 
-	new_v = boost::add_vertex(*this);
-	std::list<Block> new_list = std::list<Block>(1,ag.getBlock(root));
-	_blockVector.push_back( new_list );
+	new_v = this->_num_vertices++;
+	visitOrder->push_back( root );
 
 	visited->set(root);
 	ag2cg->at(root) = new_v;
-	this->_num_vertices++;
 
 	boost::tie(begin,end) = boost::adjacent_vertices(root,ag);
 	for( AssemblyGraph::AdjacencyIterator z = begin; z != end; z++ )
@@ -109,8 +120,7 @@ CompactAssemblyGraph::initGraphDFS_NR(
 			boost::tie(e_ag,exists) = boost::edge(prev,curr,ag);
 			EdgeProperty edge_prop = boost::get( boost::edge_kind_t(), ag, e_ag );
 
-			boost::tie(e,exists) = boost::add_edge( ag2cg->at(prev), ag2cg->at(curr), *this );
-			boost::put( boost::edge_kind_t(), *this, e, edge_prop );
+			edges->push_back( EdgeEntry( ag2cg->at(prev), ag2cg->at(curr), edge_prop ) );
 
 			continue;
 		}
@@ -121,25 +131,22 @@ CompactAssemblyGraph::initGraphDFS_NR(
 		boost::tie(e_ag,exists) = boost::edge( prev, curr, ag );
 		EdgeProperty edge_prop = boost::get( boost::edge_kind_t(), ag, e_ag );
 
+		visitOrder->push_back( curr );
+
 		if( edge_prop.kind == BOTH_EDGE ) // if previous vertex is connected to the current one with a BOTH_EDGE (master+slave edge)
 		{
-			_blockVector.at( ag2cg->at(prev) ).push_back( ag.getBlock(curr) );
 			ag2cg->at(curr) = ag2cg->at(prev);
 		}
 		else // else add a new vertex to the compact graph
 		{
-			Vertex new_v = boost::add_vertex(*this);
+			Vertex new_v = this->_num_vertices++;
 			ag2cg->at(curr) = new_v;
-			_blockVector.push_back( std::list<Block>(1,ag.getBlock(curr)) );
-
-			this->_num_vertices++;
 
 			//std::cerr << "debug: vertices=" << this->_num_vertices << "\n";
 			//std::cerr << "debug: curr=" << curr << " ag2cg(curr)=" << ag2cg->at(curr) << "\n";
 			//std::cerr << "debug: prev=" << prev << " ag2cg(prev)=" << ag2cg->at(prev) << std::endl;
 
-			boost::tie(e,exists) = boost::add_edge( ag2cg->at(prev), ag2cg->at(curr), *this );
-			boost::put( boost::edge_kind_t(), *this, e, edge_prop );
+			edges->push_back( EdgeEntry( ag2cg->at(prev), ag2cg->at(curr), edge_prop ) );
 		}
 
 		boost::tie(begin,end) = boost::adjacent_vertices(curr,ag);
@@ -164,6 +171,12 @@ CompactAssemblyGraph::initGraph2( const AssemblyGraph &ag )
 
 	boost::dynamic_bitset<> *visited = new boost::dynamic_bitset<>(ag_vertices);
 	std::vector<Vertex> *ag2cg = new std::vector<Vertex>(ag_vertices,0);
+	std::vector<AssemblyGraph::Vertex> visitOrder;
+	visitOrder.reserve( ag_vertices );
+
+	// edges of the compact graph (duplicates keep the last property)
+	std::vector<EdgeEntry> edges;
+	edges.reserve( boost::num_edges(ag) );
 
 	AssemblyGraph::VertexIterator vbegin,vend;
 	boost::tie(vbegin,vend) = boost::vertices(ag);
@@ -172,10 +185,13 @@ CompactAssemblyGraph::initGraph2( const AssemblyGraph &ag )
 	{
         if( boost::in_degree(*r,ag) == 0 && !visited->test(*r) ) // for each unvisited root
         {
-            this->initGraphDFS_NR( ag, *r, visited, ag2cg );
+            this->initGraphDFS_NR( ag, *r, visited, ag2cg, &visitOrder, &edges );
         }
 	}
 
+	this->build( this->_num_vertices, edges );
+	this->initBlocks( ag, visitOrder, *ag2cg );
+
 	delete visited;
 	delete ag2cg;
 }
@@ -187,17 +203,18 @@ CompactAssemblyGraph::initGraphDFS(
 	const AssemblyGraph::Vertex &v,
 	const AssemblyGraph::Vertex &u,
 	boost::dynamic_bitset<> *colors,
-	std::vector<Vertex> *ag2cg )
+	std::vector<Vertex> *ag2cg,
+	std::vector<AssemblyGraph::Vertex> *visitOrder,
+	std::vector<EdgeEntry> *edges )
 {
-	Edge e; bool exists;
+	AssemblyGraph::Edge e; bool exists;
 
     if( colors->test(v) ) // if node already visited, add edge and return
     {
         boost::tie(e,exists) = boost::edge(u,v,ag);
 		EdgeProperty edge_prop = boost::get( boost::edge_kind_t(), ag, e ); //EdgeKindType edge_type = boost::get( boost::edge_kind_t(), ag, e );
 
-        e = boost::add_edge( ag2cg->at(u), ag2cg->at(v), *this ).first;
-		boost::put( boost::edge_kind_t(), *this, e, edge_prop );
+		edges->push_back( EdgeEntry( ag2cg->at(u), ag2cg->at(v), edge_prop ) );
 
         return;
     }
@@ -207,31 +224,28 @@ CompactAssemblyGraph::initGraphDFS(
 	boost::tie(e,exists) = boost::edge(u,v,ag);
 	EdgeProperty edge_prop = boost::get( boost::edge_kind_t(), ag, e ); //EdgeKindType edge_type = boost::get( boost::edge_kind_t(), ag, e );
 
+	visitOrder->push_back( v );
+
 	if( edge_prop.kind == BOTH_EDGE ) // if previous vertex is connected to the current one with a BOTH_EDGE (master+slave edge)
 	{
-		_blockVector.at( ag2cg->at(u) ).push_back( ag.getBlock(v) );
 		ag2cg->at(v) = ag2cg->at(u);
 	}
 	else // else add a new vertex to the compact graph
 	{
-		Vertex new_v = boost::add_vertex(*this);
+		Vertex new_v = _num_vertices++;
 		ag2cg->at(v) = new_v;
-		_blockVector.push_back( std::list<Block>(1,ag.getBlock(v)) );
-
-		_num_vertices++;
 
 		std::cerr << "warning: u vertex-desc=" << ag2cg->at(u) << " num-vertices=" << _num_vertices << std::endl;
 		std::cerr << "warning: v vertex-desc=" << ag2cg->at(v) << " num-vertices=" << _num_vertices << std::endl;
 
-		boost::tie(e,exists) = boost::add_edge( ag2cg->at(u), ag2cg->at(v), *this );
-		boost::put( boost::edge_kind_t(), *this, e, edge_prop );
+		edges->push_back( EdgeEntry( ag2cg->at(u), ag2cg->at(v), edge_prop ) );
 	}
 
 	AssemblyGraph::AdjacencyIterator begin, end;
 	boost::tie(begin,end) = boost::adjacent_vertices(v,ag);
 	for( AssemblyGraph::AdjacencyIterator z = begin; z != end; z++ )
 	{
-		this->initGraphDFS(ag, *z, v, colors, ag2cg);
+		this->initGraphDFS(ag, *z, v, colors, ag2cg, visitOrder, edges);
 	}
 }
 
@@ -249,6 +263,10 @@ CompactAssemblyGraph::initGraph( const AssemblyGraph &ag )
 
 	boost::dynamic_bitset<> *colors = new boost::dynamic_bitset<>(ag_vertices);
 	std::vector<Vertex> *ag2cg = new std::vector<Vertex>(ag_vertices,0);
+	std::vector<AssemblyGraph::Vertex> visitOrder;
+	visitOrder.reserve( ag_vertices );
+
+	std::vector<EdgeEntry> edges;
 
 	AssemblyGraph::VertexIterator vbegin,vend;
 	boost::tie(vbegin,vend) = boost::vertices(ag);
@@ -257,24 +275,24 @@ CompactAssemblyGraph::initGraph( const AssemblyGraph &ag )
 	{
         if( boost::in_degree(*v,ag) == 0 && !colors->test(*v) )
         {
-            Vertex new_v = boost::add_vertex(*this);
-            std::list<Block> new_list = std::list<Block>(1,ag.getBlock(*v));
-            _blockVector.push_back( new_list );
+            Vertex new_v = _num_vertices++;
+            visitOrder.push_back( *v );
 
 			colors->set(*v);
             ag2cg->at(*v) = new_v;
 
-			_num_vertices++;
-
             AssemblyGraph::AdjacencyIterator begin, end;
             boost::tie(begin,end) = boost::adjacent_vertices(*v,ag);
             for( AssemblyGraph::AdjacencyIterator z = begin; z != end; z++ )
 			{
-				this->initGraphDFS( ag, *z, *v, colors, ag2cg );
+				this->initGraphDFS( ag, *z, *v, colors, ag2cg, &visitOrder, &edges );
 			}
         }
 	}
 
+	this->build( _num_vertices, edges );
+	this->initBlocks( ag, visitOrder, *ag2cg );
+
 	delete colors;
 	delete ag2cg;
 }
@@ -292,8 +310,8 @@ CompactAssemblyGraph::computeEdgeWeights( MultiBamReader &masterBamReader, Multi
 		EdgeProperty edge_prop = boost::get(boost::edge_kind_t(), *this, *e);
 		EdgeKindType kind = edge_prop.kind;
 
-		std::list<Block>& b1 = _blockVector.at( boost::source(*e,*this) );
-		std::list<Block>& b2 = _blockVector.at( boost::target(*e,*this) );
+		BlockSpan b1 = this->getBlocks( boost::source(*e,*this) );
+		BlockSpan b2 = this->getBlocks( boost::target(*e,*this) );
 
 		switch(kind)
 		{
@@ -325,14 +343,14 @@ CompactAssemblyGraph::computeEdgeWeights( MultiBamReader &masterBamReader, Multi
 
 
 void CompactAssemblyGraph::getRegionScore( MultiBamReader &peBamReader, MultiBamReader &mpBamReader, EdgeKindType kind,
-										   std::list<Block>& b1, std::list<Block>& b2,
+										   const BlockSpan& b1, const BlockSpan& b2,
 										   double &weight, int32_t &rnum, bool &min_cov )
 {
 	std::vector< std::pair<double,int32_t> > mpStats, peStats;
 
-	double mp_weight, pe_weight;
-	int32_t mp_rnum, pe_rnum;
-	bool mp_min_cov, pe_min_cov;
+	double mp_weight = 0.0, pe_weight = 0.0;
+	int32_t mp_rnum = 0, pe_rnum = 0;
+	bool mp_min_cov = false, pe_min_cov = false;
 
 	if(peBamReader.size() > 0) getLibRegionScore( peBamReader, kind, b1, b2, pe_weight, pe_rnum, pe_min_cov );
 	if(mpBamReader.size() > 0) getLibRegionScore( mpBamReader, kind, b1, b2, mp_weight, mp_rnum, mp_min_cov );
@@ -359,7 +377,7 @@ void CompactAssemblyGraph::getRegionScore( MultiBamReader &peBamReader, MultiBam
 }
 
 
-void CompactAssemblyGraph::getLibRegionScore( MultiBamReader &bamReader, EdgeKindType kind, std::list<Block>& b1, std::list<Block>& b2,
+void CompactAssemblyGraph::getLibRegionScore( MultiBamReader &bamReader, EdgeKindType kind, const BlockSpan& b1, const BlockSpan& b2,
 											  double &weight, int32_t &rnum, bool &min_cov )
 {
 	weight = -4;
@@ -378,10 +396,10 @@ void CompactAssemblyGraph::getLibRegionScore( MultiBamReader &bamReader, EdgeKin
 	if( kind != MASTER_EDGE && kind != SLAVE_EDGE ) return;
 	if( b1.size() == 0 || b2.size() == 0 ) return;
 
-	Frame& f1 = (kind == MASTER_EDGE) ? b1.front().getMasterFrame() : b1.front().getSlaveFrame();
-	Frame& f2 = (kind == MASTER_EDGE) ? b2.front().getMasterFrame() : b2.front().getSlaveFrame();
-	Frame& l1 = (kind == MASTER_EDGE) ? b1.back().getMasterFrame() : b1.back().getSlaveFrame();
-	Frame& l2 = (kind == MASTER_EDGE) ? b2.back().getMasterFrame() : b2.back().getSlaveFrame();
+	const Frame& f1 = (kind == MASTER_EDGE) ? b1.front().getMasterFrame() : b1.front().getSlaveFrame();
+	const Frame& f2 = (kind == MASTER_EDGE) ? b2.front().getMasterFrame() : b2.front().getSlaveFrame();
+	const Frame& l1 = (kind == MASTER_EDGE) ? b1.back().getMasterFrame() : b1.back().getSlaveFrame();
+	const Frame& l2 = (kind == MASTER_EDGE) ? b2.back().getMasterFrame() : b2.back().getSlaveFrame();
 
 	int32_t r1_beg = std::min( f1.getBegin(), l1.getBegin() );
 	int32_t r1_end = std::max( f1.getEnd(), l1.getEnd() );
@@ -435,9 +453,7 @@ void CompactAssemblyGraph::getLibRegionScore( MultiBamReader &bamReader, EdgeKin
 		int32_t region = s2 - s1 + 1;
 		std::vector<uint32_t> coverage( region, 0 );
 
-		// retrieve BAM readers for current library
-		bamReader.lockBamReader(lib);
-
+		// retrieve BAM readers for current library (private to the calling thread)
 		BamReader *reader = bamReader.getBamReader(lib);
 		reader->SetRegion( id, s1, id, s2+1 );
 
@@ -493,8 +509,6 @@ void CompactAssemblyGraph::getLibRegionScore( MultiBamReader &bamReader, EdgeKin
 			}
 		} // end while
 
-		bamReader.unlockBamReader(lib);
-
 		// check coverage in the region
 		for( size_t i=0; i < coverage.size(); i++ )
 		{
@@ -583,7 +597,7 @@ CompactAssemblyGraph::writeGraphviz(std::ostream& os)
 
     for (VertexIterator v=vbegin; v!=vend; v++)
     {
-        const std::list<Block>& listRef = this->_blockVector[*v];
+        BlockSpan listRef = this->getBlocks(*v);
         const Block& firstBlock = listRef.front();
         const Block& lastBlock = listRef.back();
 
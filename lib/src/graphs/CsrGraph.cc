@@ -0,0 +1,236 @@
+/*
+ *  This file is part of GAM-NGS.
+ *  Copyright (c) 2011 by Riccardo Vicedomini <rvicedomini@appliedgenomics.org>,
+ *  Francesco Vezzi <vezzi@appliedgenomics.org>,
+ *  Simone Scalabrin <scalabrin@appliedgenomics.org>,
+ *  Lars Arverstad <lars.arvestad@scilifelab.se>,
+ *  Alberto Policriti <policriti@appliedgenomics.org>,
+ *  Alberto Casagrande <casagrande@appliedgenomics.org>
+ *
+ *  GAM-NGS is an evolution of a previous work (GAM) done by Alberto Casagrande,
+ *  Cristian Del Fabbro, Simone Scalabrin, and Alberto Policriti.
+ *  In particular, GAM-NGS has been adapted to work on NGS data sets and it has
+ *  been written using GAM's software as starting point. Thus, it shares part of
+ *  GAM's source code.
+ *
+ *  GAM-NGS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  GAM-NGS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GAM-NGS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+
+#include "graphs/CsrGraph.hpp"
+
+CsrGraph::CsrGraph() : _vertices(0), _storedEdges(0), _removedNum(0)
+{
+    this->clear();
+}
+
+
+void
+CsrGraph::clear()
+{
+    std::vector<EdgeEntry> edges;
+    this->build( 0, edges );
+}
+
+
+void
+CsrGraph::build( size_t vertices, std::vector<EdgeEntry> &edges )
+{
+    std::stable_sort( edges.begin(), edges.end(), CsrGraph::edgeEntryLess );
+
+    // keep the last property of duplicated edges
+    size_t n = 0;
+    for( size_t i=0; i < edges.size(); i++ )
+    {
+        if( n > 0 && edges[n-1].source == edges[i].source && edges[n-1].target == edges[i].target ) edges[n-1] = edges[i];
+        else edges[n++] = edges[i];
+    }
+    edges.resize(n);
+
+    this->_vertices = vertices;
+    this->_storedEdges = n;
+
+    std::vector<uint32_t>( vertices+1, 0 ).swap( this->_outOffsets );
+    std::vector<uint32_t>( vertices+1, 0 ).swap( this->_inOffsets );
+    std::vector<uint32_t>( n ).swap( this->_inEdges );
+    std::vector<uint32_t>( n ).swap( this->_sources );
+    std::vector<uint32_t>( n ).swap( this->_targets );
+    std::vector<EdgeProperty>( n ).swap( this->_props );
+
+    for( size_t i=0; i < n; i++ )
+    {
+        this->_sources[i] = edges[i].source;
+        this->_targets[i] = edges[i].target;
+        this->_props[i] = edges[i].prop;
+
+        this->_outOffsets[ edges[i].source + 1 ]++;
+        this->_inOffsets[ edges[i].target + 1 ]++;
+    }
+
+    for( size_t v=1; v <= vertices; v++ )
+    {
+        this->_outOffsets[v] += this->_outOffsets[v-1];
+        this->_inOffsets[v] += this->_inOffsets[v-1];
+    }
+
+    // edges are sorted by source, hence the in-edges of each vertex are too
+    std::vector<uint32_t> next( this->_inOffsets.begin(), this->_inOffsets.end()-1 );
+    for( size_t i=0; i < n; i++ ) this->_inEdges[ next[ edges[i].target ]++ ] = i;
+
+    this->_removed.assign( n, false );
+    this->_removedNum = 0;
+    this->_addedOut.clear();
+    this->_addedIn.clear();
+}
+
+
+size_t
+CsrGraph::numEdges() const
+{
+    return this->_removed.size() - this->_removedNum;
+}
+
+
+std::pair<CsrGraph::AllEdgeIterator,CsrGraph::AllEdgeIterator>
+CsrGraph::allEdges() const
+{
+    return std::make_pair( AllEdgeIterator( this, 0 ), AllEdgeIterator( this, this->_removed.size() ) );
+}
+
+
+uint32_t
+CsrGraph::findEdge( const Vertex &u, const Vertex &v ) const
+{
+    // stored out-edges are sorted by target
+    std::vector<uint32_t>::const_iterator begin = this->_targets.begin() + this->_outOffsets[u];
+    std::vector<uint32_t>::const_iterator end = this->_targets.begin() + this->_outOffsets[u+1];
+    std::vector<uint32_t>::const_iterator t = std::lower_bound( begin, end, uint32_t(v) );
+
+    if( t != end && *t == v ) return t - this->_targets.begin();
+
+    AddedEdgesMap::const_iterator a = this->_addedOut.find(u);
+    if( a == this->_addedOut.end() ) return NO_EDGE;
+
+    for( size_t i=0; i < a->second.size(); i++ )
+    {
+        if( this->_targets[ a->second[i] ] == v ) return a->second[i];
+    }
+
+    return NO_EDGE;
+}
+
+
+std::pair<CsrGraph::Edge,bool>
+CsrGraph::edge( const Vertex &u, const Vertex &v ) const
+{
+    uint32_t id = this->findEdge(u,v);
+
+    if( id == NO_EDGE || this->_removed[id] ) return std::make_pair( Edge(), false );
+
+    return std::make_pair( Edge(id), true );
+}
+
+
+void
+CsrGraph::insertAdded( std::vector<uint32_t> &edges, uint32_t id, const std::vector<uint32_t> &keys )
+{
+    std::vector<uint32_t>::iterator pos = edges.begin();
+    while( pos != edges.end() && keys[*pos] < keys[id] ) pos++;
+
+    edges.insert( pos, id );
+}
+
+
+std::pair<CsrGraph::Edge,bool>
+CsrGraph::addEdge( const Vertex &u, const Vertex &v )
+{
+    uint32_t id = this->findEdge(u,v);
+
+    if( id != NO_EDGE )
+    {
+        // a removed edge is restored in its place
+        bool added = this->_removed[id];
+
+        if( added )
+        {
+            this->_removed[id] = false;
+            this->_removedNum--;
+        }
+
+        return std::make_pair( Edge(id), added );
+    }
+
+    id = this->_sources.size();
+    this->_sources.push_back(u);
+    this->_targets.push_back(v);
+    this->_props.push_back( EdgeProperty() );
+    this->_removed.push_back(false);
+
+    CsrGraph::insertAdded( this->_addedOut[u], id, this->_targets );
+    CsrGraph::insertAdded( this->_addedIn[v], id, this->_sources );
+
+    return std::make_pair( Edge(id), true );
+}
+
+
+void
+CsrGraph::removeEdge( const Edge &e )
+{
+    // the edge keeps its place, so that iterators on other edges stay valid
+    if( !this->_removed[e.id] )
+    {
+        this->_removed[e.id] = true;
+        this->_removedNum++;
+    }
+}
+
+
+void
+CsrGraph::removeEdge( const Vertex &u, const Vertex &v )
+{
+    uint32_t id = this->findEdge(u,v);
+    if( id != NO_EDGE ) this->removeEdge( Edge(id) );
+}
+
+
+void
+CsrGraph::topologicalSort( std::vector<Vertex> &order ) const
+{
+    std::vector<size_t> inDegree( this->_vertices, 0 );
+
+    order.clear();
+    order.reserve( this->_vertices );
+
+    for( Vertex v=0; v < this->_vertices; v++ )
+    {
+        inDegree[v] = this->inDegree(v);
+        if( inDegree[v] == 0 ) order.push_back(v);
+    }
+
+    // order is also the queue of the vertices whose predecessors have been sorted
+    for( size_t i=0; i < order.size(); i++ )
+    {
+        std::pair<IncidentEdgeIterator,IncidentEdgeIterator> e = this->outEdges( order[i] );
+
+        for( ; e.first != e.second; ++e.first )
+        {
+            Vertex t = this->target(*(e.first));
+            if( --inDegree[t] == 0 ) order.push_back(t);
+        }
+    }
+
+    if( order.size() < this->_vertices ) throw boost::not_a_dag();
+}
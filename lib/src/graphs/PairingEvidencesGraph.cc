@@ -30,19 +30,19 @@
 
 #include "graphs/PairingEvidencesGraph.hpp"
 
-PairingEvidencesGraph::PairingEvidencesGraph(const std::list<Block> &blocks)
+PairingEvidencesGraph::PairingEvidencesGraph(const BlockSpan &blocks)
         : PairedContigGraph< >(blocks)
 {
     this->addEdgeWeights(blocks);
 }
 
 void
-PairingEvidencesGraph::addEdgeWeights( const std::list<Block> &blocks )
+PairingEvidencesGraph::addEdgeWeights( const BlockSpan &blocks )
 {
     int32_t masterCtgId, slaveCtgId;
     uint64_t weight=0;
 
-	for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
+	for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
     {
         masterCtgId = b->getMasterId();
         slaveCtgId = b->getSlaveId();
@@ -52,7 +52,7 @@ PairingEvidencesGraph::addEdgeWeights( const std::list<Block> &blocks )
         put( boost::edge_weight_t(), *this, e, weight );
     }
 
-    for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
+    for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
     {
 		masterCtgId = b->getMasterId();
 		slaveCtgId = b->getSlaveId();
@@ -97,7 +97,7 @@ PairingEvidencesGraph::addEdgeWeights( const std::list<Block> &blocks )
 
 
 void getSingleLinkBlocks(
-	const std::list<Block> &blocks,
+	const BlockSpan &blocks,
 	std::set< std::pair<int32_t,int32_t> > &slb )
 {
 	PairingEvidencesGraph peg(blocks);
@@ -105,7 +105,7 @@ void getSingleLinkBlocks(
 	int32_t mid, sid;
 	PairingEvidencesGraph::Vertex mv, sv;
 
-	for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
+	for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
 	{
 		mv = peg.getMasterVertex(*b);
 		sv = peg.getSlaveVertex(*b);
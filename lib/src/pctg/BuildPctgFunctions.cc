@@ -41,7 +41,9 @@ extern MultiBamReader slaveMpBam;
 std::list< PairedContig >& buildPctg(
 		CompactAssemblyGraph& graph,
 		PctgBuilder& builder,
-		std::list< PairedContig > &pctgList )
+		std::list< PairedContig > &pctgList,
+		ThreadedBuildPctg *tbp,
+		uint64_t tid )
 {
 	typedef CompactAssemblyGraph::Vertex Vertex;
 	typedef CompactAssemblyGraph::VertexIterator VertexIterator;
@@ -79,9 +81,17 @@ std::list< PairedContig >& buildPctg(
 		std::cerr << std::endl;
 	}*/
 
-	for( MergeBlockLists::iterator it = mergeLists.begin(); it != mergeLists.end(); it++ )
-		for( std::list<MergeBlock>::iterator mb = it->begin(); mb != it->end(); mb++ )
-			builder.alignMergeBlock(graph,*mb);
+	// merge blocks are aligned independently: worker threads share their alignments
+	if( tbp != NULL )
+	{
+		tbp->alignMergeBlocks( tid, graph, builder, mergeLists );
+	}
+	else
+	{
+		for( MergeBlockLists::iterator it = mergeLists.begin(); it != mergeLists.end(); it++ )
+			for( std::list<MergeBlock>::iterator mb = it->begin(); mb != it->end(); mb++ )
+				builder.alignMergeBlock(graph,*mb);
+	}
 
 	builder.splitMergeBlocksByAlign(mergeLists);
 	builder.splitMergeBlocksByDirection(mergeLists);
@@ -96,13 +106,16 @@ std::list< PairedContig >& buildPctg(
 
 std::list< PairedContig >& buildPctg(
 		ThreadedBuildPctg *tbp,
+		uint64_t tid,
         CompactAssemblyGraph &ag,
         const RefSequence &masterRef,
         const RefSequence &slaveRef,
+        MultiBamReader *masterBamReader,
+        MultiBamReader *slaveBamReader,
         std::list< PairedContig > &pctgList )
 {
-	PctgBuilder builder( tbp, &masterRef, &slaveRef );
-	pctgList = buildPctg( ag, builder, pctgList );
+	PctgBuilder builder( tbp, &masterRef, &slaveRef, masterBamReader, slaveBamReader );
+	pctgList = buildPctg( ag, builder, pctgList, tbp, tid );
 
 	return pctgList;
 }
@@ -37,7 +37,7 @@
 #include "pctg/PctgBuilder.hpp"
 #include "pctg/MergeInCutTailFailed.hpp"
 #include "assembly/io_contig.hpp"
-#include "alignment/ablast.hpp"
+#include "alignment/chained_aligner.hpp"
 #include "alignment/banded_smith_waterman.hpp"
 
 extern OptionsMerge g_options;
@@ -58,16 +58,42 @@ std::vector<uint64_t> ext_fpi_2;
 PctgBuilder::PctgBuilder(
 	ThreadedBuildPctg *tbp,
 	const RefSequence *masterRef,
-	const RefSequence *slaveRef) :
+	const RefSequence *slaveRef,
+	MultiBamReader *masterBamReader,
+	MultiBamReader *slaveBamReader) :
 		_tbp(tbp),
 		_masterRef(masterRef),
 		_slaveRef(slaveRef),
+		_masterBam( masterBamReader != NULL ? masterBamReader : &masterBam ),
+		_slaveBam( slaveBamReader != NULL ? slaveBamReader : &slaveBam ),
 		_maxAlignment(DEFAULT_MAX_SEARCHED_ALIGNMENT),
 		_maxPctgGap(DEFAULT_MAX_GAPS),
 		_maxCtgGap(DEFAULT_MAX_GAPS)
 {}
 
 
+PctgBuilder::~PctgBuilder()
+{
+	std::map< int32_t, const Contig* >::const_iterator it;
+
+	for( it = _masterCtgs.begin(); it != _masterCtgs.end(); ++it ) _masterRef->at(it->first).Fasta->release( _masterRef->at(it->first).FastaId );
+	for( it = _slaveCtgs.begin(); it != _slaveCtgs.end(); ++it ) _slaveRef->at(it->first).Fasta->release( _slaveRef->at(it->first).FastaId );
+}
+
+
+const Contig& PctgBuilder::loadContig( const RefSequence &ref, std::map< int32_t, const Contig* > &loaded, const int32_t ctgId ) const
+{
+	std::map< int32_t, const Contig* >::const_iterator it = loaded.find(ctgId);
+	if( it != loaded.end() ) return *(it->second);
+
+	const reference_t &r = ref.at(ctgId);
+	const Contig &ctg = r.Fasta->acquire( r.FastaId );
+	loaded[ctgId] = &ctg;
+
+	return ctg;
+}
+
+
 PairedContig& PctgBuilder::addFirstContigTo(PairedContig& pctg, const int32_t ctgId) const
 {
 	const Contig& ctg = this->loadMasterContig(ctgId);
@@ -99,7 +125,7 @@ PairedContig PctgBuilder::initByContig(const IdType& pctgId, const int32_t ctgId
 }
 
 
-void PctgBuilder::appendMasterToPctg( PairedContig &pctg, int32_t id, Contig &ctg, int32_t start, int32_t end, bool rev )
+void PctgBuilder::appendMasterToPctg( PairedContig &pctg, int32_t id, const ContigView &ctg, int32_t start, int32_t end, bool rev )
 {
 	if( end < start || start < 0 || end >= ctg.size() ) return;
 
@@ -115,7 +141,7 @@ void PctgBuilder::appendMasterToPctg( PairedContig &pctg, int32_t id, Contig &ct
 	mergeList.push_back( CtgInPctgInfo( id, start, end, rev, true ) );
 }
 
-void PctgBuilder::appendSlaveToPctg( PairedContig &pctg, int32_t id, Contig &ctg, int32_t start, int32_t end, bool rev )
+void PctgBuilder::appendSlaveToPctg( PairedContig &pctg, int32_t id, const ContigView &ctg, int32_t start, int32_t end, bool rev )
 {
 	if( end < start || start < 0 || end >= ctg.size() ) return;
 
@@ -131,8 +157,8 @@ void PctgBuilder::appendSlaveToPctg( PairedContig &pctg, int32_t id, Contig &ctg
 	mergeList.push_back( CtgInPctgInfo( id, start, end, rev, false ) );
 }
 
-void PctgBuilder::appendBlocksRegionToPctg( PairedContig &pctg, int32_t m_id, Contig &m_ctg, int32_t m_start, int32_t m_end, bool m_rev,
-											int32_t s_id, Contig &s_ctg, int32_t s_start, int32_t s_end, bool s_rev )
+void PctgBuilder::appendBlocksRegionToPctg( PairedContig &pctg, int32_t m_id, const ContigView &m_ctg, int32_t m_start, int32_t m_end, bool m_rev,
+											int32_t s_id, const ContigView &s_ctg, int32_t s_start, int32_t s_end, bool s_rev )
 {
 	pctg.addMasterCtgId(m_id);
 	pctg.addSlaveCtgId(s_id);
@@ -148,8 +174,8 @@ void PctgBuilder::appendBlocksRegionToPctg( PairedContig &pctg, int32_t m_id, Co
 
 	std::vector<double> masterScore, slaveScore;
 
-	masterScore = computeZScore( masterBam, m_id, m_start, m_end );
-	slaveScore = computeZScore( slaveBam, s_id, s_start, s_end );
+	masterScore = computeZScore( *_masterBam, m_id, m_start, m_end );
+	slaveScore = computeZScore( *_slaveBam, s_id, s_start, s_end );
 
 	size_t masterEvid = 0;
 	size_t slaveEvid = 0;
@@ -194,7 +220,9 @@ void PctgBuilder::buildPctgs( std::list<PairedContig> &pctgList, std::list<Merge
 	int32_t m_pos = 0;
 	int32_t s_pos = 0;
 
-	Contig *master_ctg, *slave_ctg;
+	// views of the (possibly reverse complemented) contigs of the current merge block
+	ContigView master_ctg( this->loadMasterContig( ml.front().m_id ), ml.front().m_rev );
+	ContigView slave_ctg( this->loadSlaveContig( ml.front().s_id ), ml.front().s_rev );
 	int32_t prev_mid, prev_sid;
 
 	it = ml.begin();
@@ -205,58 +233,48 @@ void PctgBuilder::buildPctgs( std::list<PairedContig> &pctgList, std::list<Merge
 
 		if( mb == ml.begin() ) // first merge
 		{
-			master_ctg = new Contig( this->loadMasterContig( mb->m_id ) );
-			slave_ctg = new Contig( this->loadSlaveContig( mb->s_id ) );
-
-			if( mb->m_rev ) reverse_complement(*master_ctg);
-			if( mb->s_rev ) reverse_complement(*slave_ctg);
-
 			// add first tail
 			int32_t m_tail = ( mb->m_ltail ) ? mb->m_start : 0;
 			int32_t s_tail = 0; //( mb->ext_slave_prev && mb->s_ltail ) ? mb->s_start : 0;
 
-			if( m_tail >= s_tail && m_tail > 0 ) this->appendMasterToPctg( pctg, mb->m_id, *master_ctg, 0, mb->m_start - 1, mb->m_rev );
-			if( s_tail > m_tail && s_tail > 0 ) this->appendSlaveToPctg( pctg, mb->s_id, *slave_ctg, 0, mb->s_start - 1, mb->s_rev );
+			if( m_tail >= s_tail && m_tail > 0 ) this->appendMasterToPctg( pctg, mb->m_id, master_ctg, 0, mb->m_start - 1, mb->m_rev );
+			if( s_tail > m_tail && s_tail > 0 ) this->appendSlaveToPctg( pctg, mb->s_id, slave_ctg, 0, mb->s_start - 1, mb->s_rev );
 
 			// add block region
-			this->appendBlocksRegionToPctg( pctg, mb->m_id, *master_ctg, mb->m_start, mb->m_end, mb->m_rev, mb->s_id, *slave_ctg, mb->s_start, mb->s_end, mb->s_rev );
+			this->appendBlocksRegionToPctg( pctg, mb->m_id, master_ctg, mb->m_start, mb->m_end, mb->m_rev, mb->s_id, slave_ctg, mb->s_start, mb->s_end, mb->s_rev );
 		}
 		else // not first block
 		{
 			if( mb->m_id == prev_mid )
 			{
-				delete slave_ctg;
-				slave_ctg = new Contig( this->loadSlaveContig( mb->s_id ) );
-				if( mb->s_rev ) reverse_complement(*slave_ctg);
+				slave_ctg = ContigView( this->loadSlaveContig( mb->s_id ), mb->s_rev );
 
 				if( m_pos <= mb->m_start )
 				{
 					// fill the gap
-					this->appendMasterToPctg( pctg, mb->m_id, *master_ctg, m_pos, mb->m_start - 1, mb->m_rev);
+					this->appendMasterToPctg( pctg, mb->m_id, master_ctg, m_pos, mb->m_start - 1, mb->m_rev);
 					// add block region
-					this->appendBlocksRegionToPctg( pctg, mb->m_id, *master_ctg, mb->m_start, mb->m_end, mb->m_rev, mb->s_id, *slave_ctg, mb->s_start, mb->s_end, mb->s_rev );
+					this->appendBlocksRegionToPctg( pctg, mb->m_id, master_ctg, mb->m_start, mb->m_end, mb->m_rev, mb->s_id, slave_ctg, mb->s_start, mb->s_end, mb->s_rev );
 				}
 				else // current merge block overlaps previous one
 				{
-					this->appendMasterToPctg( pctg, mb->m_id, *master_ctg, m_pos, mb->m_end, mb->m_rev);
+					this->appendMasterToPctg( pctg, mb->m_id, master_ctg, m_pos, mb->m_end, mb->m_rev);
 				}
 			}
 			else // mb->s_id == prev_sid
 			{
-				delete master_ctg;
-				master_ctg = new Contig( this->loadMasterContig( mb->m_id ) );
-				if( mb->m_rev ) reverse_complement(*master_ctg);
+				master_ctg = ContigView( this->loadMasterContig( mb->m_id ), mb->m_rev );
 
 				if( s_pos <= mb->s_start )
 				{
 					// fill the gap
-					this->appendSlaveToPctg( pctg, mb->s_id, *slave_ctg, s_pos, mb->s_start - 1, mb->s_rev);
+					this->appendSlaveToPctg( pctg, mb->s_id, slave_ctg, s_pos, mb->s_start - 1, mb->s_rev);
 					// add block region
-					this->appendBlocksRegionToPctg( pctg, mb->m_id, *master_ctg, mb->m_start, mb->m_end, mb->m_rev, mb->s_id, *slave_ctg, mb->s_start, mb->s_end, mb->s_rev );
+					this->appendBlocksRegionToPctg( pctg, mb->m_id, master_ctg, mb->m_start, mb->m_end, mb->m_rev, mb->s_id, slave_ctg, mb->s_start, mb->s_end, mb->s_rev );
 				}
 				else
 				{
-					this->appendSlaveToPctg( pctg, mb->s_id, *slave_ctg, s_pos, mb->s_end, mb->s_rev );
+					this->appendSlaveToPctg( pctg, mb->s_id, slave_ctg, s_pos, mb->s_end, mb->s_rev );
 					pctg.addMasterCtgId( mb->m_id );
 				}
 			}
@@ -264,17 +282,15 @@ void PctgBuilder::buildPctgs( std::list<PairedContig> &pctgList, std::list<Merge
 
 		if( mb_next == ml.end() ) // for last block, add tail if possible
 		{
-			int32_t m_size = master_ctg->size();
-			int32_t s_size = slave_ctg->size();
+			int32_t m_size = master_ctg.size();
+			int32_t s_size = slave_ctg.size();
 
 			int32_t m_tail = ( mb->m_rtail ) ? m_size - mb->m_end - 1 : 0;
 			int32_t s_tail = 0; //( mb->ext_slave_next && mb->s_rtail ) ? s_size - mb->s_end - 1 : 0;
 
-			if( m_tail >= s_tail && m_tail > 0 ) this->appendMasterToPctg( pctg, mb->m_id, *master_ctg, mb->m_end+1, m_size-1, mb->m_rev );
-			if( s_tail > m_tail && s_tail > 0 ) this->appendSlaveToPctg( pctg, mb->s_id, *slave_ctg, mb->s_end+1, s_size-1, mb->s_rev );
+			if( m_tail >= s_tail && m_tail > 0 ) this->appendMasterToPctg( pctg, mb->m_id, master_ctg, mb->m_end+1, m_size-1, mb->m_rev );
+			if( s_tail > m_tail && s_tail > 0 ) this->appendSlaveToPctg( pctg, mb->s_id, slave_ctg, mb->s_end+1, s_size-1, mb->s_rev );
 
-			delete master_ctg;
-			delete slave_ctg;
 		}
 
 		prev_mid = mb->m_id;
@@ -290,8 +306,8 @@ void PctgBuilder::buildPctgs( std::list<PairedContig> &pctgList, std::list<Merge
 
 void PctgBuilder::splitMergeBlocksByInclusions( MergeBlockLists &ml_in )
 {
-	const RefVector& master_ref = masterBam.GetReferenceData();
-	const RefVector& slave_ref = slaveBam.GetReferenceData();
+	const RefVector& master_ref = _masterBam->GetReferenceData();
+	const RefVector& slave_ref = _slaveBam->GetReferenceData();
 
 	MergeBlockLists tmp;
 	MergeBlock mb_cur, mb_next, mb_prev;
@@ -728,7 +744,7 @@ void PctgBuilder::alignMergeBlock( const CompactAssemblyGraph &graph, MergeBlock
 	typedef CompactAssemblyGraph::Vertex Vertex;
 
 	Vertex v = mb.vertex;
-	const std::list<Block> &blocks_list = graph.getBlocks(v);
+	BlockSpan blocks_list = graph.getBlocks(v);
 
 	const Block &firstBlock = blocks_list.front();
 	const Block &lastBlock = blocks_list.back();
@@ -743,9 +759,9 @@ void PctgBuilder::alignMergeBlock( const CompactAssemblyGraph &graph, MergeBlock
 	int32_t slaveStart = std::min( firstSlaveFrame.getBegin(), lastSlaveFrame.getBegin() );
 	int32_t slaveEnd = std::max( firstSlaveFrame.getEnd(), lastSlaveFrame.getEnd() );
 
-	// load contig that should be merged with pctg.
-	Contig masterCtg = this->loadMasterContig(mb.m_id);
-	Contig slaveCtg = this->loadSlaveContig(mb.s_id);
+	// views of the contigs that should be merged with pctg (no bases are copied).
+	ContigView masterCtg( this->loadMasterContig(mb.m_id) );
+	ContigView slaveCtg( this->loadSlaveContig(mb.s_id) );
 
 	// find best alignment between the contigs
 	BestCtgAlignment *bestAlign = new BestCtgAlignment();
@@ -904,7 +920,7 @@ bool PctgBuilder::solveForks( CompactAssemblyGraph &graph, std::vector<MergeBloc
 	boost::tie(vbegin,vend) = boost::vertices(graph);
 	for( VertexIterator v = vbegin; v != vend; v++ )
 	{
-		const std::list<Block> &blocks_list = graph.getBlocks(*v);
+		BlockSpan blocks_list = graph.getBlocks(*v);
 
 		mbv[*v].valid = true;
 
@@ -997,7 +1013,7 @@ bool PctgBuilder::solveForks( CompactAssemblyGraph &graph, std::vector<MergeBloc
 	boost::tie(vbegin,vend) = boost::vertices(graph);
 	for( VertexIterator v = vbegin; v != vend; v++ )
 	{
-		const std::list<Block> &blocks_list = graph.getBlocks(*v);
+		BlockSpan blocks_list = graph.getBlocks(*v);
 		int32_t masterStart = std::min( blocks_list.front().getMasterFrame().getBegin(), blocks_list.back().getMasterFrame().getBegin() );
 		int32_t slaveStart = std::min( blocks_list.front().getSlaveFrame().getBegin(), blocks_list.back().getSlaveFrame().getBegin() );
 
@@ -1040,8 +1056,8 @@ bool PctgBuilder::solveForks( CompactAssemblyGraph &graph, std::vector<MergeBloc
 
 			if( fork_type == UNKNOWN ) continue;
 
-			const std::list<Block> &masterNextBlocks = graph.getBlocks(mv);
-			const std::list<Block> &slaveNextBlocks = graph.getBlocks(sv);
+			BlockSpan masterNextBlocks = graph.getBlocks(mv);
+			BlockSpan slaveNextBlocks = graph.getBlocks(sv);
 
 			int32_t nextMasterStart = std::min( masterNextBlocks.front().getMasterFrame().getBegin(), masterNextBlocks.back().getMasterFrame().getBegin() );
 			int32_t nextSlaveStart = std::min( slaveNextBlocks.front().getSlaveFrame().getBegin(), slaveNextBlocks.back().getSlaveFrame().getBegin() );
@@ -1103,8 +1119,8 @@ bool PctgBuilder::solveForks( CompactAssemblyGraph &graph, std::vector<MergeBloc
 
 			if( fork_type == UNKNOWN ) continue;
 
-			const std::list<Block> &masterNextBlocks = graph.getBlocks(mv);
-			const std::list<Block> &slaveNextBlocks = graph.getBlocks(sv);
+			BlockSpan masterNextBlocks = graph.getBlocks(mv);
+			BlockSpan slaveNextBlocks = graph.getBlocks(sv);
 
 			int32_t nextMasterStart = std::min( masterNextBlocks.front().getMasterFrame().getBegin(), masterNextBlocks.back().getMasterFrame().getBegin() );
 			int32_t nextSlaveStart = std::min( slaveNextBlocks.front().getSlaveFrame().getBegin(), slaveNextBlocks.back().getSlaveFrame().getBegin() );
@@ -1148,7 +1164,7 @@ bool PctgBuilder::solveForks( CompactAssemblyGraph &graph, std::vector<MergeBloc
 	boost::tie(vbegin,vend) = boost::vertices(graph);
 	for( VertexIterator v = vbegin; v != vend; v++ )
 	{
-		const std::list<Block> &blocks_list = graph.getBlocks(*v);
+		BlockSpan blocks_list = graph.getBlocks(*v);
 		const Block &firstBlock = blocks_list.front();
 
 		int32_t masterStart = std::min( blocks_list.front().getMasterFrame().getBegin(), blocks_list.back().getMasterFrame().getBegin() );
@@ -1186,8 +1202,8 @@ bool PctgBuilder::solveForks( CompactAssemblyGraph &graph, std::vector<MergeBloc
 				}
 			}
 
-			const std::list<Block> &masterNextBlocks = graph.getBlocks(mv);
-			const std::list<Block> &slaveNextBlocks = graph.getBlocks(sv);
+			BlockSpan masterNextBlocks = graph.getBlocks(mv);
+			BlockSpan slaveNextBlocks = graph.getBlocks(sv);
 
 			int32_t nextMasterStart = std::min( masterNextBlocks.front().getMasterFrame().getBegin(), masterNextBlocks.back().getMasterFrame().getBegin() );
 			int32_t nextSlaveStart = std::min( slaveNextBlocks.front().getSlaveFrame().getBegin(), slaveNextBlocks.back().getSlaveFrame().getBegin() );
@@ -1249,8 +1265,8 @@ bool PctgBuilder::solveForks( CompactAssemblyGraph &graph, std::vector<MergeBloc
 				}
 			}
 
-			const std::list<Block> &masterNextBlocks = graph.getBlocks(mv);
-			const std::list<Block> &slaveNextBlocks = graph.getBlocks(sv);
+			BlockSpan masterNextBlocks = graph.getBlocks(mv);
+			BlockSpan slaveNextBlocks = graph.getBlocks(sv);
 
 			int32_t nextMasterStart = std::min( masterNextBlocks.front().getMasterFrame().getBegin(), masterNextBlocks.back().getMasterFrame().getBegin() );
 			int32_t nextSlaveStart = std::min( slaveNextBlocks.front().getSlaveFrame().getBegin(), slaveNextBlocks.back().getSlaveFrame().getBegin() );
@@ -1329,8 +1345,8 @@ bool PctgBuilder::getMergePaths(const CompactAssemblyGraph &graph, CompactAssemb
 
         //TODO: take care also of master edges, and edges with negative weight (i.e. not enough evidences)
         if (mbv[v_nxt].valid && edge_prop.kind == SLAVE_EDGE && safe_edge) {
-            const std::list<Block> &cur_blocks = graph.getBlocks(v_cur);
-            const std::list<Block> &nxt_blocks = graph.getBlocks(v_nxt);
+            BlockSpan cur_blocks = graph.getBlocks(v_cur);
+            BlockSpan nxt_blocks = graph.getBlocks(v_nxt);
 
             int32_t curSlaveStart = std::min(cur_blocks.front().getSlaveFrame().getBegin(), cur_blocks.back().getSlaveFrame().getBegin());
             int32_t nxtSlaveStart = std::min(nxt_blocks.front().getSlaveFrame().getBegin(), nxt_blocks.back().getSlaveFrame().getBegin());
@@ -1360,13 +1376,13 @@ bool PctgBuilder::getMergePaths(const CompactAssemblyGraph &graph, CompactAssemb
 
 void PctgBuilder::findBestAlignment(
         BestCtgAlignment &bestAlign,
-        Contig &masterCtg,
+        const ContigView &masterCtg,
 		uint64_t masterStart,
 		uint64_t masterEnd,
-		Contig &slaveCtg,
+		ContigView &slaveCtg,
         uint64_t slaveStart,
         uint64_t slaveEnd,
-        const std::list<Block> &blocks_list ) const
+        const BlockSpan &blocks_list ) const
 {
     uint64_t con_evid = 0, dis_evid = 0;
 	uint64_t mf_len = 0, sf_len = 0; // sum of master/slave frames lengths
@@ -1377,7 +1393,7 @@ void PctgBuilder::findBestAlignment(
 	int32_t masterId = -1, slaveId = -1;
 
 	// compute the probability of slaveCtg to be reverse complemented respect to masterCtg
-	for( std::list<Block>::const_iterator b = blocks_list.begin(); b != blocks_list.end(); b++ )
+	for( BlockSpan::const_iterator b = blocks_list.begin(); b != blocks_list.end(); b++ )
 	{
 		const Frame& mf = b->getMasterFrame();
 		const Frame& sf = b->getSlaveFrame();
@@ -1407,9 +1423,10 @@ void PctgBuilder::findBestAlignment(
 	int32_t align_threshold = 0.7 * min_frame_len;
 	int32_t threshold = std::min( size_t(200), std::min(mt,st) );
 
-	BandedSmithWaterman aligner; //BandedSmithWaterman aligner( bsw_band );
 	MyAlignment align, bad_align(0), good_align(100);
 
+	if( this->_tbp != NULL ) this->_tbp->incAlignments( CTG_PAIR_ALIGNMENT );
+
 	bool good_align_found = false;
 	bool isSlaveRev = false;
 
@@ -1440,7 +1457,8 @@ void PctgBuilder::findBestAlignment(
 		else
 		{
 			// else, try reversing the contig
-			reverse_complement(slaveCtg);
+			slaveCtg.reverse_complement();
+			if( this->_tbp != NULL ) this->_tbp->incAlignments( STRAND_RETRY );
 
 			// update slave start/end positions
             tempPos = slaveStart;
@@ -1462,7 +1480,7 @@ void PctgBuilder::findBestAlignment(
 	// contigs more likely have opposite orientations
 	if( con_prob < 0.5 )
 	{
-		reverse_complement(slaveCtg);
+		slaveCtg.reverse_complement();
 
 		// update start and end positions of the blocks
 		tempPos = slaveStart;
@@ -1490,7 +1508,8 @@ void PctgBuilder::findBestAlignment(
 		else
 		{
             // restore original (unreversed) contig
-			reverse_complement(slaveCtg);
+			slaveCtg.reverse_complement();
+			if( this->_tbp != NULL ) this->_tbp->incAlignments( STRAND_RETRY );
 
 			// update start and end positions of the blocks
 			tempPos = slaveStart;
@@ -1528,43 +1547,25 @@ void PctgBuilder::findBestAlignment(
 	MyAlignment leftAlign(100),rightAlign(100);
 	bool leftRev, rightRev;
 
-    ABlast ablast;
+    // tails are aligned by chaining the minimizers they share: the dynamic
+    // programming only runs between anchors, not along the whole tails
+    ChainedAligner &tailAligner = this->_tailAligner;
 
     /* LEFT TAIL ALIGNMENT */
 
     if( std::min(i1,j1) >= threshold )
 	{
+		if( this->_tbp != NULL ) this->_tbp->incAlignments( TAIL_ALIGNMENT );
+
 		if( i1 < j1 ) // masterCtg left tail < slaveCtg left tail
 		{
-            std::list<uint32_t> hits = ablast.findHits( slaveCtg, 0, alignStart.second-1, masterCtg, 0, alignStart.first-1 );
-            size_t hits_num = hits.size();
-
-            if( hits_num > 0 )
-            {
-                leftAlign = aligner.find_alignment( slaveCtg, hits.back(), alignStart.second-1, masterCtg, 0, alignStart.first-1, false, true );
-                leftRev = true;
-            }
-            else
-            {
-                leftAlign = aligner.find_alignment( slaveCtg, alignStart.second-alignStart.first, alignStart.second-1, masterCtg, 0, alignStart.first-1, false, true );
-                leftRev = true;
-            }
+            leftAlign = tailAligner.find_alignment( slaveCtg, 0, alignStart.second-1, masterCtg, 0, alignStart.first-1, false, true );
+            leftRev = true;
 		}
 		else	// masterCtg left tail >= slaveCtg left tail
 		{
-            std::list<uint32_t> hits = ablast.findHits( masterCtg, 0, alignStart.first-1, slaveCtg, 0, alignStart.second-1 );
-            size_t hits_num = hits.size();
-
-            if( hits_num > 0 )
-            {
-                leftAlign = aligner.find_alignment( masterCtg, hits.back(), alignStart.first-1, slaveCtg, 0, alignStart.second-1, false, true );
-                leftRev = false;
-            }
-            else
-            {
-                leftAlign = aligner.find_alignment( masterCtg, alignStart.first-alignStart.second, alignStart.first-1, slaveCtg, 0, alignStart.second-1, false, true );
-                leftRev = false;
-            }
+            leftAlign = tailAligner.find_alignment( masterCtg, 0, alignStart.first-1, slaveCtg, 0, alignStart.second-1, false, true );
+            leftRev = false;
 		}
 	}
 
@@ -1572,41 +1573,21 @@ void PctgBuilder::findBestAlignment(
 
 	if( std::min(i2,j2) >= threshold )
 	{
+		if( this->_tbp != NULL ) this->_tbp->incAlignments( TAIL_ALIGNMENT );
+
 		if( i2 < j2 ) // pctg right tail < ctg right tail
 		{
-			Contig rightTail = chop_begin( slaveCtg, alignEnd.second+1 );
+			ContigView rightTail = slaveCtg.sub_view( alignEnd.second+1, slaveCtg.size()-alignEnd.second-1 );
 
-            std::list<uint32_t> hits = ablast.findHits( rightTail, 0, rightTail.size()-1, masterCtg, alignEnd.first+1, masterCtg.size()-1 );
-            size_t hits_num = hits.size();
-
-            if( hits_num > 0 )
-            {
-                rightAlign = aligner.find_alignment( rightTail, hits.front(), rightTail.size()-1, masterCtg, alignEnd.first+1, masterCtg.size()-1, true, false );
-                rightRev = true;
-            }
-            else
-            {
-                rightAlign = aligner.find_alignment( rightTail, 0, rightTail.size()-1, masterCtg, alignEnd.first+1, masterCtg.size()-1, true, false );
-                rightRev = true;
-            }
+            rightAlign = tailAligner.find_alignment( rightTail, 0, rightTail.size()-1, masterCtg, alignEnd.first+1, masterCtg.size()-1, true, false );
+            rightRev = true;
 		}
 		else	// pctg right tail >= ctg right tail
 		{
-			Contig rightTail = chop_begin( masterCtg, alignEnd.first+1 );
+			ContigView rightTail = masterCtg.sub_view( alignEnd.first+1, masterCtg.size()-alignEnd.first-1 );
 
-            std::list<uint32_t> hits = ablast.findHits( rightTail, 0, rightTail.size()-1, slaveCtg, alignEnd.second+1, slaveCtg.size()-1 );
-            size_t hits_num = hits.size();
-
-            if( hits_num > 0 )
-            {
-                rightAlign = aligner.find_alignment( rightTail, hits.front(), rightTail.size()-1, slaveCtg, alignEnd.second+1, slaveCtg.size()-1, true, false );
-                rightRev = false;
-            }
-            else
-            {
-                rightAlign = aligner.find_alignment( rightTail, 0, rightTail.size()-1, slaveCtg, alignEnd.second+1, slaveCtg.size()-1, true, false );
-                rightRev = false;
-            }
+            rightAlign = tailAligner.find_alignment( rightTail, 0, rightTail.size()-1, slaveCtg, alignEnd.second+1, slaveCtg.size()-1, true, false );
+            rightRev = false;
 		}
 	}
 
@@ -1615,17 +1596,18 @@ void PctgBuilder::findBestAlignment(
 
 
 void PctgBuilder::alignBlocks(
-	const Contig &masterCtg,
+	const ContigView &masterCtg,
 	const uint64_t &masterStart,
-	const Contig &slaveCtg,
+	const ContigView &slaveCtg,
 	const uint64_t &slaveStart,
-	const std::list<Block> &blocks_list,
+	const BlockSpan &blocks_list,
 	std::vector< MyAlignment > &alignments ) const
 {
 	// initialize output
 	alignments.clear();
 
-	BandedSmithWaterman aligner; //ABlast aligner; //(this->_maxAlignment, this->_maxPctgGap, this->_maxCtgGap);
+	BandedSmithWaterman aligner;
+	aligner.set_gap_model( g_options.affineGaps ? BSW_GAPS_AFFINE : BSW_GAPS_LINEAR );
 
 	// first & last blocks references
 	const Block &firstBlock = blocks_list.front();
@@ -1649,7 +1631,7 @@ void PctgBuilder::alignBlocks(
 
 	if( masterFirstFrame.getBegin() <= masterLastFrame.getBegin() ) // lista da processare in ordine
 	{
-		for( std::list<Block>::const_iterator b = blocks_list.begin(); b != blocks_list.end(); b++ )
+		for( BlockSpan::const_iterator b = blocks_list.begin(); b != blocks_list.end(); b++ )
 		{
 			mf = b->getMasterFrame();
 			sf = b->getSlaveFrame();
@@ -1678,7 +1660,7 @@ void PctgBuilder::alignBlocks(
 	}
 	else // lista da processare in ordine inverso
 	{
-		for( std::list<Block>::const_reverse_iterator b = blocks_list.rbegin(); b != blocks_list.rend(); b++ )
+		for( BlockSpan::const_reverse_iterator b = blocks_list.rbegin(); b != blocks_list.rend(); b++ )
 		{
 			mf = b->getMasterFrame();
 			sf = b->getSlaveFrame();
@@ -1705,6 +1687,8 @@ void PctgBuilder::alignBlocks(
 			idx++;
 		}
 	}
+
+	if( this->_tbp != NULL ) this->_tbp->incAlignments( BLOCK_ALIGNMENT, alignments.size() );
 }
 
 
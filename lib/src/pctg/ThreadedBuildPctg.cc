@@ -28,7 +28,12 @@
  *
  */
 
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
 #include <unistd.h>
+#include <sys/time.h>
 
 #include "OptionsMerge.hpp"
 
@@ -36,6 +41,7 @@
 #include "graphs/AssemblyGraph.hpp"
 #include "pctg/ThreadedBuildPctg.hpp"
 #include "pctg/BuildPctgFunctions.hpp"
+#include "pctg/PctgBuilder.hpp"
 
 using namespace options;
 
@@ -46,33 +52,185 @@ extern MultiBamReader masterMpBam;
 extern MultiBamReader slaveBam;
 extern MultiBamReader slaveMpBam;
 
+// weights of the cost model, in aligned bases
+#define GRAPH_VERTEX_COST 2000  // building a vertex of the assemblies' graph (a block)
+#define GRAPH_EDGE_COST 5000    // weighting an edge of the assemblies' graph (region queries on the BAM files)
 
-CompactAssemblyGraph*
-ThreadedBuildPctg::extractNextPctg()
+// partitions listed in the scheduling stats
+#define SCHEDULING_STATS_PARTITIONS 20
+
+
+// microseconds elapsed since start
+static uint64_t elapsedMicroseconds( const struct timeval &start )
+{
+	struct timeval now;
+	gettimeofday( &now, NULL );
+
+	return uint64_t(now.tv_sec - start.tv_sec) * 1000000 + (now.tv_usec - start.tv_usec);
+}
+
+
+// orders partitions' indexes by decreasing predicted cost (ties in partitions' order)
+class PartitionCostGreater
 {
-	CompactAssemblyGraph *output = NULL;
+	const std::vector< uint64_t > &_cost;
 
-    pthread_mutex_lock(&(this->_mutex));
+public:
+	PartitionCostGreater( const std::vector< uint64_t > &cost ) : _cost(cost) {}
 
-	while( _nextPctg < _graphs.size() )
+	bool operator()( uint64_t a, uint64_t b ) const
 	{
-		if( boost::num_vertices(*(_graphs[_nextPctg])) == 0 )
-		{
-			_nextPctg++;
-			continue;
-		}
-		else
-		{
-			output = _graphs[_nextPctg];
-			_nextPctg++;
-			break;
-		}
+		return _cost[a] > _cost[b] || (_cost[a] == _cost[b] && a < b);
+	}
+};
+
+
+uint64_t
+ThreadedBuildPctg::estimateCost( const BlockSpan &blocks ) const
+{
+	std::vector< int32_t > masterIds, slaveIds;
+	uint64_t frameLen = 0, ctgLen = 0;
+
+	masterIds.reserve( blocks.size() );
+	slaveIds.reserve( blocks.size() );
+
+	for( size_t i=0; i < blocks.size(); i++ )
+	{
+		masterIds.push_back( blocks[i].getMasterId() );
+		slaveIds.push_back( blocks[i].getSlaveId() );
+
+		frameLen += blocks[i].getMasterFrame().getLength() + blocks[i].getSlaveFrame().getLength();
+	}
+
+	std::sort( masterIds.begin(), masterIds.end() );
+	masterIds.erase( std::unique( masterIds.begin(), masterIds.end() ), masterIds.end() );
+	std::sort( slaveIds.begin(), slaveIds.end() );
+	slaveIds.erase( std::unique( slaveIds.begin(), slaveIds.end() ), slaveIds.end() );
+
+	// contigs involved are aligned (at most) once per pair
+	for( size_t i=0; i < masterIds.size(); i++ ) ctgLen += _masterRef[ masterIds[i] ].RefLength;
+	for( size_t i=0; i < slaveIds.size(); i++ ) ctgLen += _slaveRef[ slaveIds[i] ].RefLength;
+
+	// consecutive blocks of a contig are linked by an edge of the graph
+	uint64_t vertices = blocks.size();
+	uint64_t edges = (vertices - masterIds.size()) + (vertices - slaveIds.size());
+
+	return GRAPH_VERTEX_COST * vertices + GRAPH_EDGE_COST * edges + frameLen + ctgLen;
+}
+
+
+void
+ThreadedBuildPctg::schedulePartitions()
+{
+	this->_predictedCost.resize( _partitions.size() );
+	this->_schedule.resize( _partitions.size() );
+
+	for( size_t i=0; i < _partitions.size(); i++ )
+	{
+		this->_predictedCost[i] = this->estimateCost( _partitions[i] );
+		this->_schedule[i] = i;
+	}
+
+	// longest-processing-time-first: large partitions do not end up alone on a core
+	std::sort( this->_schedule.begin(), this->_schedule.end(), PartitionCostGreater(this->_predictedCost) );
+
+	this->_actualCost.assign( _partitions.size(), 0 );
+}
+
+
+int64_t
+ThreadedBuildPctg::extractNextPartition()
+{
+	uint64_t next = __sync_fetch_and_add( &(this->_nextPctg), 1 );
+	return (next < _schedule.size()) ? int64_t(_schedule[next]) : -1;
+}
+
+
+void
+ThreadedBuildPctg::incGraphKind( AssemblyGraphKind kind )
+{
+	pthread_mutex_lock(&(this->_mutexGraphKinds));
+	this->_graphKinds[kind]++;
+	pthread_mutex_unlock(&(this->_mutexGraphKinds));
+}
+
+
+void
+ThreadedBuildPctg::writeGraphsStats( std::ostream &os ) const
+{
+    os << "[graphs stats]\n"
+		<< "Linears = " << _graphKinds[LINEAR_GRAPH] << "\n"
+		<< "Forks = " << _graphKinds[FORKS_GRAPH] << "\n"
+		<< "Bubbles = " << _graphKinds[BUBBLES_GRAPH] << "\n"
+		<< "Cyclics = " << _graphKinds[CYCLIC_GRAPH] << "\n"
+		<< std::endl;
+}
+
+
+void
+ThreadedBuildPctg::incAlignments( AlignmentKind kind, uint64_t num )
+{
+	pthread_mutex_lock(&(this->_mutexAlignments));
+	this->_alignments[kind] += num;
+	pthread_mutex_unlock(&(this->_mutexAlignments));
+}
+
+
+void
+ThreadedBuildPctg::writeAlignmentStats( std::ostream &os ) const
+{
+    os << "[alignment stats]\n"
+		<< "Gap model = " << (g_options.affineGaps ? "affine" : "linear") << "\n"
+		<< "Contig pairs aligned = " << _alignments[CTG_PAIR_ALIGNMENT] << "\n"
+		<< "Block alignments = " << _alignments[BLOCK_ALIGNMENT] << "\n"
+		<< "Strand retries = " << _alignments[STRAND_RETRY] << "\n"
+		<< "Tail alignments = " << _alignments[TAIL_ALIGNMENT] << "\n"
+		<< std::endl;
+}
+
+
+void
+ThreadedBuildPctg::writeSchedulingStats( std::ostream &os ) const
+{
+	uint64_t totPredicted = 0, totActual = 0;
+	double sumP = 0, sumA = 0, sumPP = 0, sumAA = 0, sumPA = 0;
+	size_t n = _schedule.size();
+
+	for( size_t i=0; i < n; i++ )
+	{
+		double p = _predictedCost[i], a = _actualCost[i];
+
+		totPredicted += _predictedCost[i];
+		totActual += _actualCost[i];
+
+		sumP += p; sumA += a; sumPP += p*p; sumAA += a*a; sumPA += p*a;
+	}
+
+	// Pearson's correlation between predicted costs and processing times
+	double varP = n*sumPP - sumP*sumP, varA = n*sumAA - sumA*sumA;
+	double corr = (varP > 0 && varA > 0) ? (n*sumPA - sumP*sumA) / sqrt(varP*varA) : 0;
+
+	os << "[scheduling stats]\n"
+		<< "Partitions = " << n << "\n"
+		<< "Total predicted cost = " << totPredicted << "\n"
+		<< "Total processing time (ms) = " << std::fixed << std::setprecision(3) << totActual / 1000.0 << "\n"
+		<< "Cost/time correlation = " << corr << "\n"
+		<< "Stolen alignments = " << _stolenTasks << "\n";
+
+	// partitions were processed in decreasing order of predicted cost
+	for( size_t i=0; i < n && i < SCHEDULING_STATS_PARTITIONS; i++ )
+	{
+		uint64_t part = _schedule[i];
+
+		os << "Partition " << part+1 << " = " << _partitions[part].size() << " blocks, predicted cost "
+			<< _predictedCost[part] << ", time (ms) " << _actualCost[part] / 1000.0 << "\n";
 	}
 
-	pthread_mutex_unlock(&(this->_mutex));
-	return output;
+	os.unsetf( std::ios_base::floatfield );
+	os << std::setprecision(6) << std::endl;
 }
 
+
 IdType
 ThreadedBuildPctg::readPctgNumAndIncrease()
 {
@@ -112,31 +270,221 @@ void ThreadedBuildPctg::incProcBlocks( uint64_t num, uint64_t tid )
 }
 
 
+void
+ThreadedBuildPctg::openReaders( thread_arg_t *thread_argv )
+{
+	// private BAM readers share headers and indexes of the global ones,
+	// so that region queries of different threads need no locking
+	if( thread_argv->readersOpen ) return;
+
+	// global readers which are not open (e.g. no mate-pair libraries) have no copy
+	bool opened =
+		( not masterBam.isOpen() || thread_argv->masterBam.OpenCopy( masterBam ) ) &&
+		( not masterMpBam.isOpen() || thread_argv->masterMpBam.OpenCopy( masterMpBam ) ) &&
+		( not slaveBam.isOpen() || thread_argv->slaveBam.OpenCopy( slaveBam ) ) &&
+		( not slaveMpBam.isOpen() || thread_argv->slaveMpBam.OpenCopy( slaveMpBam ) );
+
+	if( not opened )
+	{
+		std::cerr << "[error] unable to open BAM files for merging thread " << thread_argv->tid << std::endl;
+		exit(1);
+	}
+
+	thread_argv->readersOpen = true;
+}
+
+
+bool
+ThreadedBuildPctg::extractAlignTask( uint64_t tid, align_task_t &task )
+{
+	// _mutexTasks must be held by the caller
+
+	// own tasks are taken from the back (the most recently submitted)...
+	if( not this->_alignTasks[tid].empty() )
+	{
+		task = this->_alignTasks[tid].back();
+		this->_alignTasks[tid].pop_back();
+		return true;
+	}
+
+	// ...other threads' ones from the front
+	for( size_t i=1; i < this->_alignTasks.size(); i++ )
+	{
+		std::deque< align_task_t > &tasks = this->_alignTasks[ (tid+i) % this->_alignTasks.size() ];
+
+		if( not tasks.empty() )
+		{
+			task = tasks.front();
+			tasks.pop_front();
+			this->_stolenTasks++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void
+ThreadedBuildPctg::runAlignTask( uint64_t tid, const align_task_t &task )
+{
+	struct timeval start;
+	gettimeofday( &start, NULL );
+
+	try
+	{
+		if( task.owner == tid )
+		{
+			task.builder->alignMergeBlock( *(task.graph), *(task.mb) );
+		}
+		else
+		{
+			// the owner's builder is not shared: contigs are found in the FASTA index, since the owner keeps them loaded
+			thread_arg_t *thread_argv = this->_threadArgs[tid];
+			this->openReaders( thread_argv );
+
+			PctgBuilder builder( this, &_masterRef, &_slaveRef, &(thread_argv->masterBam), &(thread_argv->slaveBam) );
+			builder.alignMergeBlock( *(task.graph), *(task.mb) );
+		}
+	}
+	catch(...) // reported by the owner, once all the tasks of the partition are completed
+	{
+		*(task.failed) = true;
+	}
+
+	// the time of a stolen task is charged to its partition, not to the one of the thief
+	if( task.owner != tid )
+	{
+		uint64_t time = elapsedMicroseconds( start );
+
+		__sync_fetch_and_add( &(this->_actualCost[task.part]), time );
+		this->_threadArgs[tid]->excludedTime += time;
+	}
+
+	if( __sync_sub_and_fetch( task.pending, 1 ) == 0 )
+	{
+		pthread_mutex_lock(&(this->_mutexTasks));
+		pthread_cond_broadcast(&(this->_condTasks));
+		pthread_mutex_unlock(&(this->_mutexTasks));
+	}
+}
+
+
+void
+ThreadedBuildPctg::alignMergeBlocks( uint64_t tid, const CompactAssemblyGraph &graph, PctgBuilder &builder, MergeBlockLists &mergeLists )
+{
+	std::vector< MergeBlock* > mbs;
+
+	for( MergeBlockLists::iterator it = mergeLists.begin(); it != mergeLists.end(); it++ )
+		for( std::list<MergeBlock>::iterator mb = it->begin(); mb != it->end(); mb++ ) mbs.push_back( &(*mb) );
+
+	if( mbs.size() < 2 || this->_alignTasks.size() < 2 )
+	{
+		for( size_t i=0; i < mbs.size(); i++ ) builder.alignMergeBlock( graph, *mbs[i] );
+		return;
+	}
+
+	// contigs are loaded before the tasks are submitted, so that they stay in memory until the partition is done
+	for( size_t i=0; i < mbs.size(); i++ )
+	{
+		builder.loadMasterContig( mbs[i]->m_id );
+		builder.loadSlaveContig( mbs[i]->s_id );
+	}
+
+	volatile uint64_t pending = mbs.size();
+	volatile bool failed = false;
+	align_task_t task;
+
+	task.graph = &graph;
+	task.builder = &builder;
+	task.owner = tid;
+	task.part = this->_threadArgs[tid]->part;
+	task.pending = &pending;
+	task.failed = &failed;
+
+	pthread_mutex_lock(&(this->_mutexTasks));
+
+	// submitted in reverse order, so that the owner runs them in the order of the merge lists
+	for( size_t i = mbs.size(); i > 0; i-- )
+	{
+		task.mb = mbs[i-1];
+		this->_alignTasks[tid].push_back(task);
+	}
+	pthread_cond_broadcast(&(this->_condTasks));
+
+	// run tasks (own or stolen) until all the alignments of the partition are done
+	while( pending > 0 )
+	{
+		if( this->extractAlignTask( tid, task ) )
+		{
+			pthread_mutex_unlock(&(this->_mutexTasks));
+			this->runAlignTask( tid, task );
+			pthread_mutex_lock(&(this->_mutexTasks));
+		}
+		else
+		{
+			// waiting for tasks run by other threads (which charge their time to the partition)
+			struct timeval start;
+			gettimeofday( &start, NULL );
+
+			pthread_cond_wait( &(this->_condTasks), &(this->_mutexTasks) );
+			this->_threadArgs[tid]->excludedTime += elapsedMicroseconds( start );
+		}
+	}
+
+	pthread_mutex_unlock(&(this->_mutexTasks));
+
+	if( failed ) throw std::runtime_error( "alignment of a merge block failed" );
+}
+
+
+void
+ThreadedBuildPctg::helpAlignments( uint64_t tid )
+{
+	align_task_t task;
+
+	pthread_mutex_lock(&(this->_mutexTasks));
+
+	this->_activeThreads--;
+	pthread_cond_broadcast(&(this->_condTasks));
+
+	// tasks are submitted only by active threads, which wait for them to be completed
+	while( this->_activeThreads > 0 )
+	{
+		if( this->extractAlignTask( tid, task ) )
+		{
+			pthread_mutex_unlock(&(this->_mutexTasks));
+			this->runAlignTask( tid, task );
+			pthread_mutex_lock(&(this->_mutexTasks));
+		}
+		else
+		{
+			pthread_cond_wait( &(this->_condTasks), &(this->_mutexTasks) );
+		}
+	}
+
+	pthread_mutex_unlock(&(this->_mutexTasks));
+}
+
+
 ThreadedBuildPctg::ThreadedBuildPctg(
-	const std::list< CompactAssemblyGraph* > &graphsList,
+	const std::vector< BlockSpan > &partitions,
 	const RefSequence &masterRef,
 	const RefSequence &slaveRef )
 :
 	_masterRef(masterRef), _slaveRef(slaveRef),
-	_pctgNum(0), _nextPctg(0), _procBlocks(0), _totBlocks(0)
+	_pctgNum(0), _partitions(partitions), _nextPctg(0), _procBlocks(0), _totBlocks(0)
 {
-	(this->_graphs).resize( graphsList.size() );
-
-    uint64_t b = 0;
-    for( std::list< CompactAssemblyGraph* >::const_iterator it = graphsList.begin(); it != graphsList.end(); it++ )
-    {
-		this->_totBlocks += boost::num_vertices(**it);
-		this->_graphs[b] = *it;
-
-		b++;
-    }
+    for( size_t i=0; i < partitions.size(); i++ ) this->_totBlocks += partitions[i].size();
+    for( int k=0; k <= CYCLIC_GRAPH; k++ ) this->_graphKinds[k] = 0;
+    for( int k=0; k < ALIGNMENT_KINDS; k++ ) this->_alignments[k] = 0;
 
-    pthread_mutex_init( &(this->_mutex), NULL );
     pthread_mutex_init( &(this->_mutexProcBlocks), NULL );
     pthread_mutex_init( &(this->_mutexPctgNumInc), NULL );
-
-    pthread_mutex_init( &(this->_mutexMasterBam), NULL );
-    pthread_mutex_init( &(this->_mutexSlaveBam), NULL );
+    pthread_mutex_init( &(this->_mutexGraphKinds), NULL );
+    pthread_mutex_init( &(this->_mutexAlignments), NULL );
+    pthread_mutex_init( &(this->_mutexTasks), NULL );
+    pthread_cond_init( &(this->_condTasks), NULL );
 }
 
 
@@ -146,12 +494,23 @@ ThreadedBuildPctg::run()
     this->_pctgsDone = 0;
     this->_lastPerc = 0;
 	this->_procBlocks = 0;
+	this->_nextPctg = 0;
+
+	this->schedulePartitions();
+
+	this->_pctgLists.clear();
+	this->_pctgLists.resize( _partitions.size() );
 
 	int threadsNum = (g_options.threadsNum > 0) ? g_options.threadsNum : 1;
 
 	thread_arg_t* threads_argv[threadsNum];
 	pthread_t threads[threadsNum];
 
+	this->_threadArgs.assign( threadsNum, NULL );
+	this->_alignTasks.assign( threadsNum, std::deque< align_task_t >() );
+	this->_activeThreads = threadsNum;
+	this->_stolenTasks = 0;
+
     pthread_attr_t attr;
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
@@ -161,9 +520,15 @@ ThreadedBuildPctg::run()
 		threads_argv[i] = new thread_arg_t;
 		threads_argv[i]->tbp = this;
 		threads_argv[i]->tid = i;
+		threads_argv[i]->readersOpen = false;
+		threads_argv[i]->part = -1;
+		threads_argv[i]->excludedTime = 0;
+		this->_threadArgs[i] = threads_argv[i];
+	}
 
-		threads_argv[i]->output = new std::list< PairedContig >;
-
+	// threads are started once all their arguments are set, since they may steal from each other
+    for( int i=0; i < threadsNum; i++ )
+	{
 		pthread_create( &threads[i], &attr, buildPctgThread, (void*)threads_argv[i] );
 		if(g_options.debug) std::cerr << "[build pctg] Thread " << i << " created." << std::endl;
 	}
@@ -176,22 +541,12 @@ ThreadedBuildPctg::run()
 
 	std::list< PairedContig > *outPctgList = new std::list< PairedContig >;
 
-	// join PairedContig lists produced by each thread
-	for( size_t i=0; i < threadsNum; i++ )
-		outPctgList->splice( outPctgList->end(), *(threads_argv[i]->output) );
-
-	// free dynamically allocated graphs
-	for( size_t i=0; i < _graphs.size(); i++ )
-	{
-		if(_graphs[i] != NULL) delete _graphs[i];
-	}
+	// join PairedContig lists in the order of the partitions
+	for( size_t i=0; i < _pctgLists.size(); i++ )
+		outPctgList->splice( outPctgList->end(), _pctgLists[i] );
 
 	// free dynamically allocated threads' arguments
-	for( size_t i=0; i < threadsNum; i++ )
-	{
-		delete threads_argv[i]->output;
-		delete threads_argv[i];
-	}
+	for( int i=0; i < threadsNum; i++ ) delete threads_argv[i];
 
 	return outPctgList;
 }
@@ -313,27 +668,57 @@ buildPctgThread(void* argv)
     ThreadedBuildPctg *tbp = thread_argv->tbp;
 	uint64_t tid = thread_argv->tid;
 
-	std::list< PairedContig > *pctgList = thread_argv->output;
-	CompactAssemblyGraph* cg = tbp->extractNextPctg();
+	int64_t part = tbp->extractNextPartition();
 
-	// process graphs
-	while( cg != NULL )
+	// process partitions
+	while( part >= 0 )
 	{
-		try
-        {
-            buildPctg( tbp, *cg, tbp->_masterRef, tbp->_slaveRef, *pctgList );
-        }
-        catch(...) // this should not happen!
-        {
-            std::cerr << "Something unexpected happened processing graph " << cg->getId() << std::endl;
-        }
-
-		uint64_t cg_size = boost::num_vertices(*cg);
-		tbp->incProcBlocks( cg_size, tid );
-
-		cg->clear();
-		cg = tbp->extractNextPctg();
+		const BlockSpan &blocks = tbp->_partitions[part];
+
+		tbp->openReaders( thread_argv );
+
+		struct timeval start;
+		gettimeofday( &start, NULL );
+
+		thread_argv->part = part;
+		thread_argv->excludedTime = 0;
+
+		AssemblyGraphKind kind;
+		CompactAssemblyGraph *cg = buildCompactGraph( blocks, part+1,
+			thread_argv->masterBam, thread_argv->masterMpBam, thread_argv->slaveBam, thread_argv->slaveMpBam, kind );
+
+		tbp->incGraphKind( kind );
+
+		if( cg != NULL )
+		{
+			try
+			{
+				buildPctg( tbp, tid, *cg, tbp->_masterRef, tbp->_slaveRef, &(thread_argv->masterBam), &(thread_argv->slaveBam),
+						   tbp->_pctgLists[part] );
+			}
+			catch(...) // this should not happen!
+			{
+				std::cerr << "Something unexpected happened processing graph " << cg->getId() << std::endl;
+			}
+
+			delete cg;
+		}
+
+		// other threads may have already charged the tasks they stole from this partition
+		uint64_t time = elapsedMicroseconds( start );
+		__sync_fetch_and_add( &(tbp->_actualCost[part]), time > thread_argv->excludedTime ? time - thread_argv->excludedTime : 0 );
+
+		tbp->incProcBlocks( blocks.size(), tid );
+		part = tbp->extractNextPartition();
 	}
 
+	// help the threads still processing their partitions with their alignments
+	tbp->helpAlignments( tid );
+
+	thread_argv->masterBam.Close();
+	thread_argv->masterMpBam.Close();
+	thread_argv->slaveBam.Close();
+	thread_argv->slaveMpBam.Close();
+
     pthread_exit((void *)0);
 }
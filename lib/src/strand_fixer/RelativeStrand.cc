@@ -28,12 +28,24 @@
  *
  */
 
+#include <queue>
 #include <vector>
+#include <pthread.h>
 
 #include "strand_fixer/RelativeStrand.hpp"
 //#include "boost/graph/graphviz.hpp"
 
-RelativeStrandEvidencesGraph::RelativeStrandEvidencesGraph(const std::list<Block>& blocks) :
+#include "OptionsMerge.hpp"
+using namespace options;
+extern OptionsMerge g_options;
+
+// statistics of the comparison between the strand solvers
+static pthread_mutex_t g_strandStatsMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t g_strandComparedGraphs = 0;
+static uint64_t g_strandComparedCtgs = 0;
+static uint64_t g_strandDisagreements = 0;
+
+RelativeStrandEvidencesGraph::RelativeStrandEvidencesGraph(const BlockSpan& blocks) :
         PairedContigGraph<VertexPropType,RelativeStrandEvidences>( blocks )
 {
     this->addEdgeWeights(blocks);
@@ -41,17 +53,17 @@ RelativeStrandEvidencesGraph::RelativeStrandEvidencesGraph(const std::list<Block
 
 
 void
-RelativeStrandEvidencesGraph::addEdgeWeights(const std::list<Block>& blocks)
+RelativeStrandEvidencesGraph::addEdgeWeights(const BlockSpan& blocks)
 {
     RelativeStrandEvidences evidences;
 
-	for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
+	for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
     {
         Edge e = boost::add_edge(this->getMasterVertex(*b), this->getSlaveVertex(*b), *this).first;
         put( boost::edge_weight_t(), *this, e, evidences );
     }
 
-    for( std::list<Block>::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
+    for( BlockSpan::const_iterator b = blocks.begin(); b != blocks.end(); b++ )
     {
         Edge e = boost::edge(this->getMasterVertex(*b), this->getSlaveVertex(*b), *this).first;
         evidences = get( boost::edge_weight_t(), *this, e );
@@ -248,11 +260,139 @@ RelativeStrandEvidencesGraph::computeRelativeStrands()
 }
 
 
+RelativeStrandEvidencesGraph::StrandProbMapPair
+RelativeStrandEvidencesGraph::computeTreeRelativeStrandsWithRespectTo(const Vertex &node)
+{
+    // candidate edge of the tree: (evidences, (vertex in the tree, vertex to add))
+    typedef std::pair< UIntType, std::pair<Vertex,Vertex> > CandidateEdge;
+
+    StrandProbMapPair output;
+
+    size_t verticesNum = boost::num_vertices(*this);
+    std::vector< RealType > posStrandProb( verticesNum, RealType(0) );
+    std::vector< bool > inTree( verticesNum, false );
+    std::priority_queue< CandidateEdge > candidates;
+
+    posStrandProb[node] = RealType(1);
+    candidates.push( CandidateEdge( 0, std::make_pair(node,node) ) );
+
+    while( !candidates.empty() )
+    {
+        Vertex parent = candidates.top().second.first;
+        Vertex v = candidates.top().second.second;
+        candidates.pop();
+
+        if( inTree[v] ) continue;
+        inTree[v] = true;
+
+        if( v != parent )
+        {
+            Edge e = boost::edge( parent, v, *this ).first;
+            posStrandProb[v] = this->composePosStrandProb( posStrandProb[parent], boost::get( boost::edge_weight_t(), *this, e ) );
+        }
+
+        if( this->isMasterNode(v) )
+            output.first[ this->_vertexToCtg[v] ] = posStrandProb[v];
+        else
+            output.second[ this->_vertexToCtg[v] ] = posStrandProb[v];
+
+        AdjacencyIterator begin, end;
+        boost::tie(begin,end) = boost::adjacent_vertices(v,*this);
+
+        for( AdjacencyIterator u = begin; u != end; u++ )
+        {
+            if( inTree[*u] ) continue;
+
+            Edge e = boost::edge( v, *u, *this ).first;
+            UIntType evidences = boost::get( boost::edge_weight_t(), *this, e ).getEvidences();
+            candidates.push( CandidateEdge( evidences, std::make_pair(v,*u) ) );
+        }
+    }
+
+    return output;
+}
+
+
+RelativeStrandEvidencesGraph::StrandProbMapPair
+RelativeStrandEvidencesGraph::computeTreeRelativeStrands()
+{
+    VertexIterator begin, end;
+    boost::tie(begin,end) = boost::vertices(*this);
+
+    if( begin != end ) return this->computeTreeRelativeStrandsWithRespectTo(*begin);
+
+    return StrandProbMapPair();
+}
+
+
+// reports the contigs whose strand differs between the two solvers
+static void
+compareStrandMaps(
+        const std::map<int32_t,StrandProbability> &paths,
+        const std::map<int32_t,StrandProbability> &tree,
+        const char *assembly,
+        uint64_t &compared,
+        uint64_t &disagreements)
+{
+    std::map<int32_t,StrandProbability>::const_iterator p, t;
+
+    for( p = paths.begin(); p != paths.end(); p++ )
+    {
+        t = tree.find( p->first );
+        if( t == tree.end() ) continue;
+
+        compared++;
+
+        if( p->second.getStrand() != t->second.getStrand() )
+        {
+            disagreements++;
+
+            std::cout << "[strand] " << assembly << " contig " << p->first
+                << ": paths solver '" << p->second.getStrand() << "' (" << p->second << ")"
+                << ", tree solver '" << t->second.getStrand() << "' (" << t->second << ")" << std::endl;
+        }
+    }
+}
+
+
 std::pair< std::map<int32_t,StrandProbability>, std::map<int32_t,StrandProbability> >
-computeRelativeStrandMap(const std::list<Block>& blocks)
+computeRelativeStrandMap(const BlockSpan& blocks)
 {
     // build strand graph
     RelativeStrandEvidencesGraph rseg(blocks);
 
-    return rseg.computeRelativeStrands();
+    if( g_options.strandSolver == OptionsMerge::strand_solver_tree ) return rseg.computeTreeRelativeStrands();
+    if( g_options.strandSolver == OptionsMerge::strand_solver_paths ) return rseg.computeRelativeStrands();
+
+    std::pair< std::map<int32_t,StrandProbability>, std::map<int32_t,StrandProbability> > paths, tree;
+    paths = rseg.computeRelativeStrands();
+    tree = rseg.computeTreeRelativeStrands();
+
+    uint64_t compared = 0, disagreements = 0;
+
+    pthread_mutex_lock( &g_strandStatsMutex );
+    compareStrandMaps( paths.first, tree.first, "master", compared, disagreements );
+    compareStrandMaps( paths.second, tree.second, "slave", compared, disagreements );
+
+    g_strandComparedGraphs++;
+    g_strandComparedCtgs += compared;
+    g_strandDisagreements += disagreements;
+    pthread_mutex_unlock( &g_strandStatsMutex );
+
+    return paths;
+}
+
+
+void
+writeStrandSolverStats( std::ostream &os )
+{
+    pthread_mutex_lock( &g_strandStatsMutex );
+
+    os << "[strand solver stats]\n"
+        << "Graphs compared = " << g_strandComparedGraphs << "\n"
+        << "Contigs compared = " << g_strandComparedCtgs << "\n"
+        << "Strand disagreements = " << g_strandDisagreements << "\n"
+        << std::endl;
+
+    pthread_mutex_unlock( &g_strandStatsMutex );
 }
@@ -39,8 +39,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
 
-#include <google/sparse_hash_map>
 #include <boost/filesystem.hpp>
 
 #include "api/BamAux.h"
@@ -49,17 +50,87 @@
 
 #include "bam/MultiBamReader.hpp"
 #include "assembly/Read.hpp"
+#include "assembly/ReadMap.hpp"
+#include "assembly/CoverageMap.hpp"
 #include "assembly/Block.hpp"
 #include "UtilityFunctions.hpp"
 
 using namespace BamTools;
-using google::sparse_hash_map;
 
 extern OptionsCreate g_options;
 
 namespace modules
 {
 
+//! A range of slave's contigs processed by a single thread.
+typedef struct slave_shard
+{
+	MultiBamReader *bamReader;                          // reader of the slave's BAM files (owned by the shard)
+	int32_t firstRefId;                                 // first contig of the range
+	int32_t lastRefId;                                  // last contig of the range
+	bool useRegion;                                     // whether the reader has to be restricted to the range
+
+	CoverageMap *coverage;                              // slave's coverage (each shard updates its own contigs)
+	const ReadMap *masterReadMap;                       // master's reads (shared, read-only)
+
+	std::vector< KeyedRead > slaveReads;
+	std::vector< Block > blocks;
+} slave_shard_t;
+
+void* loadSlaveReadsThread( void *argv )
+{
+	slave_shard_t *shard = (slave_shard_t*) argv;
+
+	if( shard->useRegion )
+	{
+		const RefVector& refs = shard->bamReader->GetReferenceData();
+		// a shard whose region cannot be set would silently lose its reads (and blocks)
+		if( not shard->bamReader->SetRegion( shard->firstRefId, 0, shard->lastRefId, refs[shard->lastRefId].RefLength ) )
+		{
+			for( uint32_t i=0; i < shard->bamReader->size(); i++ )
+			{
+				std::string error = shard->bamReader->getBamReader(i)->GetErrorString();
+				if( not error.empty() ) std::cerr << "[bam] ERROR: " << error << std::endl;
+			}
+
+			std::cerr << "[error] unable to read slave's contigs " << shard->firstRefId << "-" << shard->lastRefId << " from BAM files" << std::endl;
+			exit(1);
+		}
+	}
+
+	Block::loadSlaveReads( *(shard->bamReader), shard->slaveReads, *(shard->coverage), g_options.noMultiplicityFilter );
+	pthread_exit(NULL);
+}
+
+void* findBlocksThread( void *argv )
+{
+	slave_shard_t *shard = (slave_shard_t*) argv;
+	Block::findBlocks( shard->blocks, shard->slaveReads, g_options.minBlockSize, *(shard->masterReadMap) );
+	pthread_exit(NULL);
+}
+
+// split slave's contigs into (at most) shardsNum ranges of similar total length
+void partitionContigs( const RefVector &refs, int shardsNum, std::vector< std::pair<int32_t,int32_t> > &ranges )
+{
+	uint64_t totLength = 0, curLength = 0;
+	for( size_t i=0; i < refs.size(); i++ ) totLength += refs[i].RefLength;
+
+	int32_t first = 0;
+	for( int32_t i=0; i < int32_t(refs.size()); i++ )
+	{
+		curLength += refs[i].RefLength;
+
+		if( int(ranges.size()) + 1 < shardsNum && curLength * shardsNum >= totLength * (ranges.size()+1) )
+		{
+			ranges.push_back( std::make_pair(first,i) );
+			first = i+1;
+		}
+	}
+
+	if( first < int32_t(refs.size()) ) ranges.push_back( std::make_pair( first, int32_t(refs.size())-1 ) );
+}
+
+
 void CreateBlocks::execute()
 {
 	struct stat st;
@@ -104,19 +175,84 @@ void CreateBlocks::execute()
 		}
 	}
 
-	/* OPEN MASTER BAM AND LOAD READS IN MEMORY */
+	if( g_options.decompressThreadsNum > 0 )
+		std::cout << "[main] BAM files will be decompressed using " << g_options.decompressThreadsNum << " background threads each" << std::endl;
+
+	/* OPEN MASTER AND SLAVE BAMS */
 
 	MultiBamReader masterBam; // master (multi) BAM reader
 	masterBam.Open( masterBamFiles ); // open master BAM files
 	masterBam.setMinMaxInsertSizes( master_minInsert, master_maxInsert );
+	masterBam.setDecompressThreads( g_options.decompressThreadsNum );
+
+	MultiBamReader slaveBam; // slave (multi) BAM reader
+	slaveBam.Open( slaveBamFiles ); // open slave BAM files
+	slaveBam.setMinMaxInsertSizes( slave_minInsert, slave_maxInsert );
+
+	// split slave's contigs among threads (blocks never span slave's contigs)
+	const RefVector& slaveRefs = slaveBam.GetReferenceData();
+	std::vector< std::pair<int32_t,int32_t> > ranges;
+	partitionContigs( slaveRefs, g_options.threadsNum, ranges );
+
+	if( ranges.size() > 1 )
+		std::cout << "[main] slave's contigs split in " << ranges.size() << " ranges processed by distinct threads" << std::endl;
 
 	std::cout << "[main] loading reads in memory" << std::endl;
 
-	std::vector< std::vector<uint32_t> > masterCoverage;
-	sparse_hash_map< std::string, Read > masterReadMap_1, masterReadMap_2;
+	CoverageMap masterCoverage( g_options.coverageWidth, g_options.coverageSpillDir );
+	CoverageMap slaveCoverage( g_options.coverageWidth, g_options.coverageSpillDir );
+	slaveCoverage.init( slaveRefs );
+
+	ReadMap masterReadMap;
+
+	std::vector< slave_shard_t* > shards( ranges.size() );
+	std::vector< pthread_t > threads( ranges.size() );
+
+	for( size_t i=0; i < ranges.size(); i++ )
+	{
+		shards[i] = new slave_shard_t;
+		shards[i]->bamReader = new MultiBamReader();
+		shards[i]->bamReader->Open( slaveBamFiles );
+		shards[i]->bamReader->setMinMaxInsertSizes( slave_minInsert, slave_maxInsert );
+		shards[i]->bamReader->setDecompressThreads( g_options.decompressThreadsNum );
+		shards[i]->firstRefId = ranges[i].first;
+		shards[i]->lastRefId = ranges[i].second;
+		shards[i]->useRegion = (ranges.size() > 1);
+		shards[i]->coverage = &slaveCoverage;
+		shards[i]->masterReadMap = &masterReadMap;
+	}
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+	// the slave's passes (coverage, inserts stats and reads' fingerprints) run concurrently with the master's one
+	for( size_t i=0; i < shards.size(); i++ )
+	{
+		if( pthread_create( &threads[i], &attr, loadSlaveReadsThread, (void*)shards[i] ) != 0 )
+		{
+			std::cerr << "[error] unable to create the thread processing slave's BAM files" << std::endl;
+			exit(1);
+		}
+	}
 
 	// load uniquely mapped reads of the master, while updating master contig's coverage and inserts stats
-	Read::loadReadsMap( masterBam, masterReadMap_1, masterReadMap_2, masterCoverage, g_options.noMultiplicityFilter );
+	Read::loadReadsMap( masterBam, masterReadMap, masterCoverage, g_options.noMultiplicityFilter );
+
+	uint64_t slaveReadsNum = 0, slaveReadsBytes = 0;
+	for( size_t i=0; i < shards.size(); i++ )
+	{
+		pthread_join( threads[i], NULL );
+
+		slaveBam.mergeStats( *(shards[i]->bamReader) );
+		shards[i]->bamReader->Close();
+		delete shards[i]->bamReader;
+
+		slaveReadsNum += shards[i]->slaveReads.size();
+		slaveReadsBytes += shards[i]->slaveReads.capacity() * sizeof(KeyedRead);
+	}
+
+	slaveCoverage.finalize();
 
 	// output inserts statistics for master assembly
 	std::string isize_stats_file = g_options.masterBamFile + ".isize";
@@ -125,21 +261,57 @@ void CreateBlocks::execute()
 	time_t t2 = time(NULL);
 	std::cout << "[main] reads loaded in " << formatTime(t2-t1) << std::endl;
 
+	uint64_t readsNum = masterReadMap.size();
+	uint64_t readMapBytes = masterReadMap.getMemoryUsage();
+	std::cout << "[main] master reads in memory = " << readsNum
+	          << " (" << (readMapBytes >> 20) << " MB, "
+	          << (readsNum > 0 ? double(readMapBytes) / readsNum : 0.0) << " bytes/read, "
+	          << masterReadMap.getCollisions() << " name collisions discarded)" << std::endl;
+	std::cout << "[main] slave reads in memory = " << slaveReadsNum
+	          << " (" << (slaveReadsBytes >> 20) << " MB)" << std::endl;
+
+	std::cout << "[main] coverage stored with " << g_options.coverageWidth << " bits per base = "
+	          << ((masterCoverage.getDataSize() + slaveCoverage.getDataSize()) >> 20) << " MB"
+	          << (g_options.coverageSpillDir.empty() ? "" : " (memory-mapped)") << ", "
+	          << masterCoverage.getOverflowWindows() + slaveCoverage.getOverflowWindows() << " windows in side table" << std::endl;
+
 	std::cout << "[main] finding blocks" << std::endl;
 
+	/* BUILD BLOCKS */
+
+	struct timeval tv1, tv2;
+	gettimeofday( &tv1, NULL );
+
+	// build blocks of each range joining slave's reads with master's ones
+	for( size_t i=0; i < shards.size(); i++ )
+	{
+		if( pthread_create( &threads[i], &attr, findBlocksThread, (void*)shards[i] ) != 0 )
+		{
+			std::cerr << "[error] unable to create the thread building blocks" << std::endl;
+			exit(1);
+		}
+	}
+
+	pthread_attr_destroy(&attr);
+
 	std::vector<Block> blocks;
 
-	/* OPEN SLAVE BAM AND BUILD BLOCKS */
+	// concatenate blocks in slave's contigs order
+	for( size_t i=0; i < shards.size(); i++ )
+	{
+		pthread_join( threads[i], NULL );
 
-	MultiBamReader slaveBam; // slave (multi) BAM reader
-	slaveBam.Open( slaveBamFiles ); // open slave BAM files
-	slaveBam.setMinMaxInsertSizes( slave_minInsert, slave_maxInsert );
+		blocks.insert( blocks.end(), shards[i]->blocks.begin(), shards[i]->blocks.end() );
+		delete shards[i];
+	}
+
+	masterReadMap.clear();
 
-	std::vector< std::vector<uint32_t> > slaveCoverage;
+	gettimeofday( &tv2, NULL );
+	double elapsed = (tv2.tv_sec - tv1.tv_sec) + (tv2.tv_usec - tv1.tv_usec) / 1000000.0;
 
-	// build blocks, compute slave contig's coverage and inserts stats
-	Block::findBlocks( blocks, slaveBam, g_options.minBlockSize,
-					   masterReadMap_1, masterReadMap_2, slaveCoverage, g_options.noMultiplicityFilter );
+	std::cout << "[main] slave reads processed = " << slaveReadsNum
+	          << " (" << uint64_t(elapsed > 0 ? slaveReadsNum / elapsed : 0) << " reads/s while building blocks)" << std::endl;
 
 
 	/* COMPUTE COVERAGE OF THE BLOCKS */
@@ -152,7 +324,11 @@ void CreateBlocks::execute()
 	std::cout << "[main] blocks found = " << blocks.size() << std::endl;
 
 	std::cout << "[main] writing blocks on file: " << getPathBaseName( g_options.outputFilePrefix ) << std::endl;
-	Block::writeBlocks( g_options.outputFilePrefix + ".blocks", blocks );
+	if( g_options.textBlocks )
+		Block::writeBlocks( g_options.outputFilePrefix + ".blocks", blocks );
+	else
+		Block::writeBlocksBinary( g_options.outputFilePrefix + ".blocks", blocks,
+		                          masterBam.GetReferenceData().size(), slaveRefs.size(), g_options.minBlockSize );
 	
 	if( g_options.debug ) 
 		Block::writeBlocksVerbose( g_options.outputFilePrefix + ".blocks.verbose.txt", blocks, masterBam, slaveBam );
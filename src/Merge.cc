@@ -53,6 +53,8 @@
 #include "OptionsMerge.hpp"
 
 #include "assembly/Block.hpp"
+#include "assembly/FastaIndex.hpp"
+#include "assembly/FastaWriter.hpp"
 #include "assembly/Read.hpp"
 #include "assembly/RefSequence.hpp"
 #include "assembly/io_contig.hpp"
@@ -62,6 +64,7 @@
 #include "pctg/PairedContig.hpp"
 #include "pctg/ThreadedBuildPctg.hpp"
 #include "pctg/BuildPctgFunctions.hpp"
+#include "strand_fixer/RelativeStrand.hpp"
 #include "OrderingFunctions.hpp"
 #include "PartitionFunctions.hpp"
 #include "UtilityFunctions.hpp"
@@ -104,10 +107,16 @@ namespace modules {
 
         _g_statsFile.open((g_options.outputFilePrefix + ".stats").c_str(), std::ios::out); // open statistics (output) file
 
-        std::list<Block> blocks;
+        std::vector<Block> blocks;
+        BlocksFileHeader blocksHeader;
 
         std::cout << "[main] Loading blocks" << std::endl;
-        Block::loadBlocks(g_options.blocksFile, blocks, g_options.minBlockSize);
+        Block::loadBlocks(g_options.blocksFile, blocks, g_options.minBlockSize, &blocksHeader);
+
+        if( blocksHeader.version != 0 && blocksHeader.minBlockSize > g_options.minBlockSize )
+            std::cout << "[warning] blocks have been built with min-block-size = " << blocksHeader.minBlockSize
+                      << ", blocks smaller than that are not available" << std::endl;
+
         std::cout << "[main] Loaded blocks = " << blocks.size() << std::endl;
 
         std::cout << "[main] Loading BAMs data" << std::endl;
@@ -131,7 +140,9 @@ namespace modules {
         if (stat(g_options.masterISizeFile.c_str(), &st) != 0) // if statistics file do not exist, create it
         {
             std::cout << "[bam] Computing statistics of master's PE-alignments" << std::endl;
+            masterBam.setDecompressThreads(g_options.decompressThreadsNum);
             masterBam.computeStatistics();
+            masterBam.setDecompressThreads(0);
             masterBam.writeStatsToFile(g_options.masterISizeFile);
         }
 
@@ -161,7 +172,9 @@ namespace modules {
             if (stat(g_options.masterMpISizeFile.c_str(), &st) != 0) // if statistics file do not exist, create it
             {
                 std::cout << "[bam] Computing statistics of master's MP-alignments" << std::endl;
+                masterMpBam.setDecompressThreads(g_options.decompressThreadsNum);
                 masterMpBam.computeStatistics();
+                masterMpBam.setDecompressThreads(0);
                 masterMpBam.writeStatsToFile(g_options.masterMpISizeFile);
             }
 
@@ -189,7 +202,9 @@ namespace modules {
         if (stat(g_options.slaveISizeFile.c_str(), &st) != 0) // if statistics file do not exist, create it
         {
             std::cout << "[bam] Computing statistics of slave's PE-alignments" << std::endl;
+            slaveBam.setDecompressThreads(g_options.decompressThreadsNum);
             slaveBam.computeStatistics();
+            slaveBam.setDecompressThreads(0);
             slaveBam.writeStatsToFile(g_options.slaveISizeFile);
         }
 
@@ -218,7 +233,9 @@ namespace modules {
             if (stat(g_options.slaveMpISizeFile.c_str(), &st) != 0) // if statistics file do not exist, create it
             {
                 std::cout << "[bam] Computing statistics of slave's MP-alignments" << std::endl;
+                slaveMpBam.setDecompressThreads(g_options.decompressThreadsNum);
                 slaveMpBam.computeStatistics();
+                slaveMpBam.setDecompressThreads(0);
                 slaveMpBam.writeStatsToFile(g_options.slaveMpISizeFile);
             }
 
@@ -237,6 +254,13 @@ namespace modules {
         uint64_t master_ctgs = masterBam.GetReferenceData().size();
         uint64_t slave_ctgs = slaveBam.GetReferenceData().size();
 
+        if( blocksHeader.version != 0 && (blocksHeader.masterContigs != master_ctgs || blocksHeader.slaveContigs != slave_ctgs) )
+        {
+            std::cerr << "[error] blocks' file has been built on assemblies with " << blocksHeader.masterContigs << " (master) and "
+                      << blocksHeader.slaveContigs << " (slave) sequences, which do not match the BAM files" << std::endl;
+            exit(1);
+        }
+
         RefSequence masterRef(master_ctgs);
         RefSequence slaveRef(slave_ctgs);
 
@@ -300,33 +324,30 @@ namespace modules {
         /* PARTITION BLOCKS */
 
         std::cout << "[main] Partitioning blocks" << std::endl;
-        std::list< CompactAssemblyGraph* > graphs_list = partitionBlocks(blocks);
-
-        /* LOADING CONTIGS SEQUENCES IN MEMORY */
+        std::vector< BlockSpan > partitions = partitionBlocksByPairedContigs(blocks);
 
-        std::cout << "[main] Loading contig sequences" << std::endl;
+        /* INDEXING CONTIGS SEQUENCES */
 
-        std::map< std::string, int32_t > masterCtg2Id; // master contig Name => ID
-        std::map< std::string, int32_t > slaveCtg2Id; // slave contig Name => ID
+        // sequences are read on demand from the (memory-mapped) FASTA files
+        std::cout << "[main] Indexing contig sequences" << std::endl;
 
-        for (size_t i = 0; i < masterRef.size(); i++) masterCtg2Id[ masterRef[i].RefName ] = i;
-        for (size_t i = 0; i < slaveRef.size(); i++) slaveCtg2Id[ slaveRef[i].RefName ] = i;
+        FastaIndex masterFasta, slaveFasta;
 
-        size_t m_num = loadSequences(g_options.masterFastaFile, masterRef, masterCtg2Id);
-		std::cout << "       master sequences loaded = " << m_num << std::endl;
+        size_t m_num = indexSequences(g_options.masterFastaFile, masterFasta, masterRef);
+		std::cout << "       master sequences indexed = " << m_num << std::endl;
 		
-		if( m_num != masterRef.size() )
+		if( m_num != masterRef.size() || masterFasta.size() != masterRef.size() )
 		{
-			std::cerr << "[error] the number of contigs loaded from the master fasta file is different from the number of sequences in master bam headers\n";
+			std::cerr << "[error] the contigs of the master fasta file do not match the sequences in master bam headers\n";
 			exit(1);
 		}
 		
-        size_t s_num = loadSequences(g_options.slaveFastaFile, slaveRef, slaveCtg2Id);
-		std::cout << "       slave sequences loaded  = " << s_num << std::endl;
+        size_t s_num = indexSequences(g_options.slaveFastaFile, slaveFasta, slaveRef);
+		std::cout << "       slave sequences indexed  = " << s_num << std::endl;
 		
-		if( s_num != slaveRef.size() )
+		if( s_num != slaveRef.size() || slaveFasta.size() != slaveRef.size() )
 		{
-			std::cerr << "[error] the number of contigs loaded from the slave fasta file is different from the number of sequences in slave bam headers\n";
+			std::cerr << "[error] the contigs of the slave fasta file do not match the sequences in slave bam headers\n";
 			exit(1);
 		}
 
@@ -335,7 +356,7 @@ namespace modules {
         // output slave contigs with no blocks (before filtering)
         std::string noblocks_fasta_file = g_options.outputFilePrefix + ".noblocks.BF.fasta";
         std::cout << "[merge] Writing contigs with no blocks to file: " << noblocks_fasta_file << std::endl;
-        std::ofstream noblocks_fasta_stream(noblocks_fasta_file.c_str());
+        FastaWriter noblocks_bf_writer(noblocks_fasta_file, true);
         for( size_t i = 0; i < slaveNBC_BF.size(); ++i )
 		{
             if( i >= slaveRef.size() )
@@ -346,16 +367,17 @@ namespace modules {
 
             if( slaveNBC_BF.test(i) )
             {
-                Contig *ctg = slaveRef.at(i).Sequence;
-                noblocks_fasta_stream << *ctg << std::endl;
+                Contig *ctg = slaveFasta.load( slaveRef.at(i).FastaId );
+                noblocks_bf_writer.write(*ctg);
+                delete ctg;
             }
         }
-        noblocks_fasta_stream.close();
+        noblocks_bf_writer.close();
 
         // output slave contigs with no blocks (after filtering)
         noblocks_fasta_file = g_options.outputFilePrefix + ".noblocks.AF.fasta";
         std::cout << "[merge] Writing contigs with no blocks (after filtering) to file: " << noblocks_fasta_file << std::endl;
-        noblocks_fasta_stream.open(noblocks_fasta_file.c_str());
+        FastaWriter noblocks_af_writer(noblocks_fasta_file, true);
         for( size_t i = 0; i < slaveNBC_AF.size(); ++i )
 		{
             if( i >= slaveRef.size() )
@@ -366,16 +388,25 @@ namespace modules {
 
             if( slaveNBC_AF.test(i) )
             {
-                Contig *ctg = slaveRef.at(i).Sequence;
-                noblocks_fasta_stream << *ctg << std::endl;
+                Contig *ctg = slaveFasta.load( slaveRef.at(i).FastaId );
+                noblocks_af_writer.write(*ctg);
+                delete ctg;
             }
         }
-        noblocks_fasta_stream.close();
+        noblocks_af_writer.close();
 
         /* BUILD PAIRED CONTIGS */
 
-        ThreadedBuildPctg tbp(graphs_list, masterRef, slaveRef);
+        // assemblies' graphs are built and weighted by the same threads which merge them
+        ThreadedBuildPctg tbp(partitions, masterRef, slaveRef);
         std::list<PairedContig> *result = tbp.run();
+        tbp.writeGraphsStats(_g_statsFile);
+        tbp.writeAlignmentStats(_g_statsFile);
+        tbp.writeSchedulingStats(_g_statsFile);
+        if( g_options.strandSolver == OptionsMerge::strand_solver_compare ) writeStrandSolverStats(_g_statsFile);
+
+        std::vector<BlockSpan>().swap(partitions);
+        std::vector<Block>().swap(blocks);
 
         // assign unique IDs to paired contigs
         uint64_t pctg_id = 0;
@@ -412,7 +443,7 @@ namespace modules {
         // TODO: sistemare codice commentato qui sotto
         // save IDs of (slave) contigs NOT merged
         std::cout << "[merge] writing slave's unused contigs (not even partially merged) on file \"" << ( g_options.outputFilePrefix + ".notmerged.fasta" ) << "\"" << std::endl;
-        std::fstream unusedCtgsFile( (g_options.outputFilePrefix + ".notmerged.fasta").c_str(), std::fstream::out );
+        FastaWriter unusedCtgsFile( g_options.outputFilePrefix + ".notmerged.fasta", true );
         boost_bitset_t usedCtgs( slaveRef.size() );
 
         for( std::list< PairedContig >::const_iterator pctg = result->begin(); pctg != result->end(); ++pctg )
@@ -427,13 +458,16 @@ namespace modules {
         usedCtgs |= slaveNBC_AF;
 
         for( size_t i=0; i < usedCtgs.size(); i++ )
-            if( not usedCtgs[i] ) unusedCtgsFile << *(slaveRef[i].Sequence) << "\n";
+            if( not usedCtgs[i] )
+            {
+                Contig *ctg = slaveFasta.load( slaveRef[i].FastaId );
+                unusedCtgsFile.write( *ctg );
+                delete ctg;
+            }
 
         unusedCtgsFile.close();
         usedCtgs.clear(); // linea commentata perchè mi servono dopo per le regioni duplicate
 
-        // delete slave contigs, which are no longer needed
-        for (size_t i = 0; i < slaveRef.size(); i++) delete slaveRef[i].Sequence;
         slaveNBC_BF.clear();
         slaveNBC_AF.clear();
 
@@ -454,8 +488,8 @@ namespace modules {
         // write paired contigs to file
         std::cout << "[merge] Writing paired contigs on file: " << (g_options.outputFilePrefix + ".gam.fasta") << std::endl;
 
-        std::ofstream outFasta((g_options.outputFilePrefix + ".gam.fasta").c_str(), std::ios::out);
-        for (std::list< PairedContig >::const_iterator pctg = result->begin(); pctg != result->end(); pctg++) outFasta << *pctg << std::endl;
+        FastaWriter outFasta(g_options.outputFilePrefix + ".gam.fasta", true);
+        for (std::list< PairedContig >::const_iterator pctg = result->begin(); pctg != result->end(); pctg++) outFasta.write(*pctg);
         outFasta.close();
 
         // save paired contigs descriptors to file
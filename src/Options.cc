@@ -40,8 +40,13 @@ void Options::set_defaults()
 	// input options
 	minBlockSize = 50;
 	threadsNum = 1;
+	decompressThreadsNum = 0;
+	coverageWidth = 16;
 	coverageThreshold = 0.75;
 	noMultiplicityFilter = false;
+	textBlocks = false;
+	affineGaps = false;
+	strandSolver = strand_solver_tree;
 
 	debug = false;
 
@@ -58,10 +58,14 @@ bool OptionsCreate::process(int argc, char *argv[])
 
         ("min-block-size", po::value<int>(), "minimum number of reads needed to build a block (optional) [default=50]")
         ("no-mult-filter", "force all reads to be processed as if they had unique mapping (optional)")
-		//("threads", po::value<int>(), "number of threads [default 1]")
+		("threads", po::value<int>(), "number of threads processing ranges of slave's contigs (optional) [default=1]")
+		("decompress-threads", po::value<int>(), "number of threads decompressing each BAM file in background (optional) [default=0]")
+		("coverage-width", po::value<int>(), "bits per base used to store contigs' coverage, either 16 or 32 (optional) [default=16]")
+		("coverage-spill-dir", po::value< std::string >(), "directory where contigs' coverage is kept in memory-mapped files (optional)")
 
 		// output
 		("output", po::value< std::string >(), "output-file's prefix (optional) [default=out]")
+		("text-blocks", "write blocks in text format rather than binary, e.g. for debugging (optional)")
 		;
 
 	po::options_description hidden_opts("Debug options");
@@ -136,12 +140,49 @@ bool OptionsCreate::process(int argc, char *argv[])
 		noMultiplicityFilter = true;
 	}
 
+	if( vm.count("threads") )
+	{
+		threadsNum = vm["threads"].as<int>();
+		if( threadsNum < 1 ) threadsNum = 1;
+	}
+
+	if( vm.count("decompress-threads") )
+	{
+		decompressThreadsNum = vm["decompress-threads"].as<int>();
+		if( decompressThreadsNum < 0 ) decompressThreadsNum = 0;
+	}
+
+	if( vm.count("coverage-width") )
+	{
+		coverageWidth = vm["coverage-width"].as<int>();
+		if( coverageWidth != 16 && coverageWidth != 32 )
+		{
+			std::cerr << "--coverage-width must be either 16 or 32." << std::endl;
+			exit(1);
+		}
+	}
+
+	if( vm.count("coverage-spill-dir") )
+	{
+		coverageSpillDir = vm["coverage-spill-dir"].as< std::string >();
+		if( stat(coverageSpillDir.c_str(),&st) != 0 || !S_ISDIR(st.st_mode) )
+		{
+			std::cerr << "Coverage spill directory " << coverageSpillDir << " does not exist." << std::endl;
+			exit(1);
+		}
+	}
+
 	// OUTPUT
 	if( vm.count("output") )
 	{
 		outputFilePrefix = vm["output"].as< std::string >();
 	}
 
+	if( vm.count("text-blocks") )
+	{
+		textBlocks = true;
+	}
+
 	return true;
 }
 
@@ -67,8 +67,11 @@ bool OptionsMerge::process(int argc, char *argv[])
 		//("reads-prefix", po::value< std::string >(), "common prefix of all reads" )
 		("min-block-size", po::value<int>(), "minimum number of reads of blocks to be loaded (optional) [default=5]")
 		("threads", po::value<int>(), "number of threads (optional) [default=1]")
+		("decompress-threads", po::value<int>(), "number of threads decompressing each BAM file in background while computing libraries' statistics (optional) [default=0]")
 		("coverage-filter", po::value<double>(), "coverage filter threshold (optional) [default=0.75]")
 		("no-mult-filter", "force all reads to be processed as if they had unique mapping (optional)")
+		("affine-gaps", "align contigs with affine gap scores (gap opening -8, extension -1) instead of linear ones; slower than linear gaps, not a speedup (optional)")
+		("strand-solver", po::value< std::string >(), "contigs' relative strand inference: \"tree\" (maximum evidence spanning tree), \"paths\" (all simple paths, slow on dense graphs) or \"compare\" (runs both, reports disagreements and keeps \"paths\") (optional) [default=tree]")
 
 		("output-graphs", "output graphs in gam_graphs sub-folder (debug)")
 
@@ -238,6 +241,13 @@ bool OptionsMerge::process(int argc, char *argv[])
 	}
 
 
+	if( vm.count("decompress-threads") )
+	{
+		decompressThreadsNum = vm["decompress-threads"].as<int>();
+		if( decompressThreadsNum < 0 ) decompressThreadsNum = 0;
+	}
+
+
 	if( vm.count("coverage-filter") )
 	{
 		if( coverageThreshold >= 0 ) coverageThreshold = vm["coverage-filter"].as<double>();
@@ -248,6 +258,26 @@ bool OptionsMerge::process(int argc, char *argv[])
 		noMultiplicityFilter = true;
 	}
 
+	if( vm.count("affine-gaps") )
+	{
+		affineGaps = true;
+	}
+
+	if( vm.count("strand-solver") )
+	{
+		std::string solver = vm["strand-solver"].as< std::string >();
+
+		if( solver == "tree" ) strandSolver = strand_solver_tree;
+		else if( solver == "paths" ) strandSolver = strand_solver_paths;
+		else if( solver == "compare" ) strandSolver = strand_solver_compare;
+		else
+		{
+			std::cerr << "--strand-solver must be one of \"tree\", \"paths\" or \"compare\"." << std::endl;
+			std::cerr << "Try \"--help\" for help" << std::endl;
+			exit(1);
+		}
+	}
+
 
 	if( vm.count("output-graphs") )
 	{